@@ -6,6 +6,7 @@ import re
 import numpy as np
 import logging
 from flask import Flask, request, jsonify
+from werkzeug.serving import WSGIRequestHandler
 from dotenv import load_dotenv
 
 load_dotenv()
@@ -392,4 +393,6 @@ def status():
     return jsonify({"status": "ok"}), 200
 
 if __name__ == '__main__':
+    # HTTP/1.1: el comunicador reutiliza la conexión que abre al detectar un vehículo
+    WSGIRequestHandler.protocol_version = "HTTP/1.1"
     app.run(host="0.0.0.0", port=5000)
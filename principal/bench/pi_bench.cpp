@@ -0,0 +1,154 @@
+/**
+ * @file pi_bench.cpp
+ * @brief Prueba de estrés de inversión de prioridades: std::mutex contra PiMutex.
+ *
+ * Tres hilos SCHED_FIFO fijados al mismo núcleo, como el sensor y el comunicador
+ * del pipeline compitiendo con trabajo de prioridad intermedia:
+ * - bajo (prioridad 10): toma el mutex y lo retiene HOLD_US de CPU.
+ * - medio (prioridad 20): ráfagas de CPU de BURST_US que no tocan el mutex.
+ * - alto (prioridad 30): toma el mutex periódicamente y mide cuánto espera.
+ *
+ * Con std::mutex, el hilo medio desaloja al bajo mientras retiene el mutex y el
+ * alto espera lo que dure la ráfaga. Con PiMutex el bajo hereda la prioridad del
+ * alto y la espera queda acotada por la sección crítica (HOLD_US).
+ *
+ * Requiere permisos para SCHED_FIFO (root o CAP_SYS_NICE); sin ellos los
+ * resultados no muestran la inversión.
+ *
+ * Uso: ./pi_bench [segundos por caso] [núcleo]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
+#include "rt_mutex.h"
+
+using namespace std;
+using namespace chrono;
+
+const microseconds HOLD_US(50);       // Sección crítica del hilo bajo
+const microseconds BURST_US(5000);    // Ráfaga de CPU del hilo medio
+const microseconds HIGH_PERIOD(1000); // Período del hilo alto
+const microseconds LOW_PERIOD(200);   // Pausa del hilo bajo entre secciones críticas
+
+struct Summary {
+    size_t count;
+    double p50_ns, p99_ns, max_ns;
+};
+
+static Summary summarize(vector<int64_t>& samples) {
+    if (samples.empty()) return {0, 0, 0, 0};
+    sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t idx = min(samples.size() - 1, static_cast<size_t>(q * samples.size()));
+        return static_cast<double>(samples[idx]);
+    };
+    return {samples.size(), at(0.50), at(0.99), static_cast<double>(samples.back())};
+}
+
+static void print_row(const char* name, Summary s) {
+    printf("%-12s esperas %7zu   p50 %9.0f ns   p99 %9.0f ns   max %10.0f ns\n",
+           name, s.count, s.p50_ns, s.p99_ns, s.max_ns);
+}
+
+/** Consume CPU durante `d` sin ceder el núcleo */
+static void spin_for(microseconds d) {
+    auto until = steady_clock::now() + d;
+    while (steady_clock::now() < until) {}
+}
+
+/**
+ * Fija el hilo actual al núcleo y le da SCHED_FIFO con la prioridad pedida.
+ * @return false si no se pudo aplicar la política
+ */
+static bool make_rt(int cpu, int priority) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/**
+ * Corre los tres hilos con el mutex `M` durante `duration` y devuelve las
+ * esperas del hilo alto.
+ */
+template <typename M>
+static Summary run_case(seconds duration, int cpu, bool& rt_ok) {
+    M mtx;
+    atomic<bool> running{true};
+    atomic<int> rt_failures{0};
+    vector<int64_t> waits;
+    waits.reserve(duration_cast<microseconds>(duration) / HIGH_PERIOD + 1);
+
+    thread low([&] {
+        if (!make_rt(cpu, 10)) rt_failures++;
+        while (running.load(memory_order_relaxed)) {
+            {
+                lock_guard<M> lock(mtx);
+                spin_for(HOLD_US);
+            }
+            this_thread::sleep_for(LOW_PERIOD);
+        }
+    });
+    thread medium([&] {
+        if (!make_rt(cpu, 20)) rt_failures++;
+        while (running.load(memory_order_relaxed)) {
+            // Deja correr al bajo un rato para que llegue a tomar el mutex
+            this_thread::sleep_for(HIGH_PERIOD * 3);
+            spin_for(BURST_US);
+        }
+    });
+    thread high([&] {
+        if (!make_rt(cpu, 30)) rt_failures++;
+        auto next = steady_clock::now();
+        while (running.load(memory_order_relaxed)) {
+            next += HIGH_PERIOD;
+            this_thread::sleep_until(next);
+            auto t0 = steady_clock::now();
+            mtx.lock();
+            auto t1 = steady_clock::now();
+            mtx.unlock();
+            waits.push_back(duration_cast<nanoseconds>(t1 - t0).count());
+        }
+    });
+
+    this_thread::sleep_for(duration);
+    running.store(false, memory_order_relaxed);
+    high.join();
+    medium.join();
+    low.join();
+
+    rt_ok = rt_failures.load() == 0;
+    return summarize(waits);
+}
+
+int main(int argc, char** argv) {
+    seconds duration(argc > 1 ? atoi(argv[1]) : 3);
+    int cpu = argc > 2 ? atoi(argv[2]) : 0;
+    printf("Núcleo %d, %lld s por caso; sección crítica %lld us, ráfaga intermedia %lld us\n\n", cpu,
+           static_cast<long long>(duration.count()), static_cast<long long>(HOLD_US.count()),
+           static_cast<long long>(BURST_US.count()));
+
+    PiMutex probe;
+    if (!probe.inherits()) printf("Aviso: el sistema no soporta PTHREAD_PRIO_INHERIT\n");
+
+    bool rt_ok = true;
+    print_row("std::mutex", run_case<mutex>(duration, cpu, rt_ok));
+    bool pi_rt_ok = true;
+    print_row("PiMutex", run_case<PiMutex>(duration, cpu, pi_rt_ok));
+
+    if (!rt_ok || !pi_rt_ok) {
+        printf("\nAviso: no se pudo aplicar SCHED_FIFO; sin prioridades fijas no hay inversión que medir\n");
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file queue_bench.cpp
+ * @brief Microbenchmark de las colas de eventos: SharedQueue (mutex + condition_variable)
+ * contra PhotoChannel (MpscRing + futex) y los buffers SpscRing/MpscRing crudos.
+ *
+ * Mide la latencia de push y pop sin contención y, entre dos hilos, el throughput
+ * y la latencia de extremo a extremo (desde el push hasta que el consumidor lo recibe).
+ *
+ * Uso: ./queue_bench [iteraciones]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shared_data.h"
+#include "ring_buffer.h"
+
+using namespace std;
+using namespace chrono;
+
+// Máximo de eventos en vuelo durante la prueba entre hilos (igual a la capacidad vigente por defecto)
+const uint64_t WINDOW = 8;
+
+struct Summary {
+    double p50_ns, p99_ns, max_ns;
+};
+
+static Summary summarize(vector<int64_t>& samples) {
+    sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t idx = min(samples.size() - 1, static_cast<size_t>(q * samples.size()));
+        return static_cast<double>(samples[idx]);
+    };
+    return {at(0.50), at(0.99), static_cast<double>(samples.back())};
+}
+
+// Los eventos salen de un pool preasignado, igual que en el pipeline real
+static VehiclePool pool;
+
+static VehicleEvent* make_event() {
+    VehicleEvent* ev = pool.acquire();
+    ev->stamp(Stage::Trigger);
+    ev->deadline = ev->trigger_time() + hours(1);
+    return ev;
+}
+
+static void print_row(const char* name, const char* what, Summary s) {
+    printf("%-14s %-10s p50 %8.0f ns   p99 %8.0f ns   max %10.0f ns\n", name, what, s.p50_ns, s.p99_ns, s.max_ns);
+}
+
+/**
+ * Latencia de push y pop en un solo hilo, sin contención.
+ */
+template <typename PushFn, typename PopFn>
+static void bench_uncontended(const char* name, size_t iterations, PushFn push, PopFn pop) {
+    vector<int64_t> push_ns, pop_ns;
+    push_ns.reserve(iterations);
+    pop_ns.reserve(iterations);
+
+    for (size_t i = 0; i < iterations; i++) {
+        VehicleEvent* ev = make_event();
+        auto t0 = steady_clock::now();
+        push(ev);
+        auto t1 = steady_clock::now();
+        ev = pop();
+        auto t2 = steady_clock::now();
+        release_vehicle(ev);
+        push_ns.push_back(duration_cast<nanoseconds>(t1 - t0).count());
+        pop_ns.push_back(duration_cast<nanoseconds>(t2 - t1).count());
+    }
+    print_row(name, "push", summarize(push_ns));
+    print_row(name, "pop", summarize(pop_ns));
+}
+
+/**
+ * Throughput y latencia de extremo a extremo entre un productor y un consumidor.
+ * El productor mantiene como máximo WINDOW eventos en vuelo.
+ */
+template <typename PushFn, typename PopFn>
+static void bench_two_threads(const char* name, size_t iterations, PushFn push, PopFn pop) {
+    vector<int64_t> e2e_ns;
+    e2e_ns.reserve(iterations);
+    atomic<uint64_t> consumed{0};
+
+    auto start = steady_clock::now();
+    thread consumer([&]() {
+        for (size_t i = 0; i < iterations; i++) {
+            VehicleEvent* ev = pop();
+            e2e_ns.push_back(duration_cast<nanoseconds>(steady_clock::now() - ev->trigger_time()).count());
+            release_vehicle(ev);
+            consumed.store(i + 1, memory_order_release);
+        }
+    });
+    for (size_t i = 0; i < iterations; i++) {
+        while (i - consumed.load(memory_order_acquire) >= WINDOW) {
+            this_thread::yield();
+        }
+        push(make_event());
+    }
+    consumer.join();
+    double secs = duration<double>(steady_clock::now() - start).count();
+
+    print_row(name, "e2e", summarize(e2e_ns));
+    printf("%-14s %-10s %.2f Mops/s\n", name, "throughput", iterations / secs / 1e6);
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+    printf("Iteraciones: %zu\n\n", iterations);
+
+    printf("== Un hilo, sin contención ==\n");
+    {
+        SharedQueue q;
+        bench_uncontended("SharedQueue", iterations,
+            [&](VehicleEvent* ev) { q.push(ev); },
+            [&]() { return q.wait_and_pop(); });
+    }
+    {
+        PhotoChannel ch;
+        bench_uncontended("PhotoChannel", iterations,
+            [&](VehicleEvent* ev) { ch.push(ev); },
+            [&]() { return ch.wait_and_pop(); });
+    }
+    {
+        auto ring = make_unique<SpscRing<VehicleEvent*, 16>>();
+        bench_uncontended("SpscRing", iterations,
+            [&](VehicleEvent* ev) { ring->try_push(move(ev)); },
+            [&]() { VehicleEvent* ev = nullptr; ring->try_pop(ev); return ev; });
+    }
+    {
+        auto ring = make_unique<MpscRing<VehicleEvent*, 16>>();
+        bench_uncontended("MpscRing", iterations,
+            [&](VehicleEvent* ev) { ring->try_push(move(ev)); },
+            [&]() { VehicleEvent* ev = nullptr; ring->try_pop(ev); return ev; });
+    }
+
+    printf("\n== Productor y consumidor en hilos distintos ==\n");
+    {
+        SharedQueue q;
+        bench_two_threads("SharedQueue", iterations,
+            [&](VehicleEvent* ev) { q.push(ev); },
+            [&]() { return q.wait_and_pop(); });
+    }
+    {
+        PhotoChannel ch;
+        bench_two_threads("PhotoChannel", iterations,
+            [&](VehicleEvent* ev) { ch.push(ev); },
+            [&]() { return ch.wait_and_pop(); });
+    }
+    {
+        auto ring = make_unique<SpscRing<VehicleEvent*, 16>>();
+        bench_two_threads("SpscRing", iterations,
+            [&](VehicleEvent* ev) { while (!ring->try_push(move(ev))) this_thread::yield(); },
+            [&]() { VehicleEvent* ev = nullptr; while (!ring->try_pop(ev)) this_thread::yield(); return ev; });
+    }
+    {
+        auto ring = make_unique<MpscRing<VehicleEvent*, 16>>();
+        bench_two_threads("MpscRing", iterations,
+            [&](VehicleEvent* ev) { while (!ring->try_push(move(ev))) this_thread::yield(); },
+            [&]() { VehicleEvent* ev = nullptr; while (!ring->try_pop(ev)) this_thread::yield(); return ev; });
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+#ifndef BARRIER_CONTROLLER_H
+#define BARRIER_CONTROLLER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "servo_motion.h"
+
+using namespace std;
+
+/**
+ * Estado de la barrera. El valor numérico es el que se publica en
+ * LaneStatus::barrier (ver BARRIER_STATE_NAMES en shm_stats.h).
+ */
+enum class BarrierState : uint8_t { Closed, Opening, Open, Closing, Fault };
+
+/**
+ * Tiempos de la barrera.
+ */
+struct BarrierTiming {
+    chrono::milliseconds min_hold{1500};     // Mínimo abierta aunque el carril ya esté libre
+    chrono::milliseconds max_hold{10000};    // Máximo abierta si el sensor nunca informa la salida
+    chrono::milliseconds deny_blink{1000};   // LED rojo apagado ante un acceso denegado
+    chrono::milliseconds fault_retry{2000};  // Espera antes de reintentar cerrar tras una falla
+};
+
+/**
+ * Salidas de la barrera. `servo` inicia el movimiento y devuelve la predicción
+ * de cuándo el brazo deja pasar y cuándo termina (ok = false si el comando falló).
+ */
+struct BarrierActuator {
+    function<ServoMove(bool open, chrono::steady_clock::time_point now)> servo;
+    function<void(bool green, bool red)> lights;
+};
+
+/**
+ * Clase BarrierController
+ * Máquina de estados de la barrera, manejada por eventos (decisiones y
+ * ocupación del carril) y por sus propios plazos. Nunca duerme: el hilo
+ * dueño espera hasta next_deadline() o hasta el próximo evento y llama a
+ * tick(). No es segura para varios hilos.
+ *
+ * - Closed: una autorización empieza a abrir el brazo (Opening).
+ * - Opening: cuando el brazo llega a la altura de paso predicha por el servo
+ *   pasa a Open y recién ahí enciende el verde.
+ * - Open: cierra cuando el sensor informa que el carril quedó libre, pero no
+ *   antes de `min_hold` desde la última autorización; si el sensor nunca lo
+ *   informa, cierra igual a los `max_hold`.
+ * - Closing: el rojo se enciende al empezar a bajar; al completar el recorrido
+ *   pasa a Closed. Una autorización en este estado vuelve a abrir desde donde
+ *   esté el brazo.
+ * - Fault: un comando al servo falló. Queda en rojo y reintenta cerrar cada
+ *   `fault_retry`; una autorización también reintenta abrir.
+ *
+ * Una autorización con el brazo ya abierto extiende la apertura para el
+ * vehículo siguiente. Un acceso denegado apaga el rojo durante `deny_blink`
+ * sin mover el brazo.
+ */
+class BarrierController {
+public:
+    using clock = chrono::steady_clock;
+
+    explicit BarrierController(BarrierActuator actuator, BarrierTiming timing = {})
+        : actuator(move(actuator)), timing(timing) {}
+
+    /**
+     * Lleva la barrera a cerrada sin esperar el recorrido (al iniciar el hilo).
+     */
+    void reset(clock::time_point now) {
+        blink_until = clock::time_point::min();
+        if (actuator.servo(false, now).ok) {
+            state_ = BarrierState::Closed;
+        } else {
+            enter_fault(now);
+        }
+        lights(now);
+    }
+
+    /**
+     * Acceso autorizado.
+     * @return false si el servo rechazó el comando (la barrera queda en Fault)
+     */
+    bool grant(clock::time_point now) {
+        lane_clear = false;
+        close_after = now + timing.min_hold;
+        close_by = now + timing.max_hold;
+        switch (state_) {
+        case BarrierState::Opening:
+        case BarrierState::Open:
+            return true;
+        case BarrierState::Closed:
+        case BarrierState::Closing:
+        case BarrierState::Fault: {
+            ServoMove motion = actuator.servo(true, now);
+            if (!motion.ok) {
+                enter_fault(now);
+                lights(now);
+                return false;
+            }
+            state_ = BarrierState::Opening;
+            deadline = now + motion.passable;
+            break;
+        }
+        }
+        tick(now);
+        return true;
+    }
+
+    /**
+     * Acceso denegado: parpadeo del rojo, el brazo no se mueve.
+     */
+    void deny(clock::time_point now) {
+        blink_until = now + timing.deny_blink;
+        lights(now);
+    }
+
+    /**
+     * Ocupación del carril informada por el sensor. La salida queda registrada
+     * hasta la próxima autorización: un vehículo que llega detrás sin permiso
+     * no mantiene la barrera abierta.
+     */
+    void lane(bool occupied, clock::time_point now) {
+        if (state_ != BarrierState::Opening && state_ != BarrierState::Open) return;
+        if (!occupied) lane_clear = true;
+        if (state_ == BarrierState::Open) tick(now);
+    }
+
+    /**
+     * Vence los plazos alcanzados. Puede llamarse en cualquier momento.
+     */
+    void tick(clock::time_point now) {
+        switch (state_) {
+        case BarrierState::Opening:
+            if (now >= deadline) {
+                state_ = BarrierState::Open;
+                opened_at = now;
+                tick(now);
+                return;
+            }
+            break;
+        case BarrierState::Open:
+            if ((lane_clear && now >= close_after) || now >= close_by) start_closing(now);
+            break;
+        case BarrierState::Closing:
+            if (now >= deadline) state_ = BarrierState::Closed;
+            break;
+        case BarrierState::Fault:
+            if (now >= deadline) start_closing(now);
+            break;
+        case BarrierState::Closed:
+            break;
+        }
+        lights(now);
+    }
+
+    /**
+     * Próximo instante en que tick() tiene algo que hacer (time_point::max() si ninguno).
+     */
+    clock::time_point next_deadline() const {
+        clock::time_point next = clock::time_point::max();
+        switch (state_) {
+        case BarrierState::Opening:
+        case BarrierState::Closing:
+        case BarrierState::Fault:
+            next = deadline;
+            break;
+        case BarrierState::Open:
+            next = lane_clear ? min(close_after, close_by) : close_by;
+            break;
+        case BarrierState::Closed:
+            break;
+        }
+        if (blink_until > clock::time_point::min() && blink_until < next) next = blink_until;
+        return next;
+    }
+
+    BarrierState state() const { return state_; }
+
+    /** true si el último cierre fue por `max_hold` y no por la salida del vehículo */
+    bool closed_by_timeout() const { return timed_out; }
+
+    /** Tiempo que estuvo abierta la barrera en el último ciclo completo */
+    clock::duration last_open_time() const { return open_time; }
+
+private:
+    BarrierActuator actuator;
+    BarrierTiming timing;
+    BarrierState state_ = BarrierState::Closed;
+    clock::time_point deadline{};                       // Fin del recorrido o del reintento en curso
+    clock::time_point close_after{};                    // No cerrar antes (min_hold)
+    clock::time_point close_by{};                       // Cerrar a más tardar (max_hold)
+    clock::time_point opened_at{};
+    clock::time_point blink_until = clock::time_point::min();
+    clock::duration open_time{};
+    bool lane_clear = false;                            // El sensor informó la salida desde la última autorización
+    bool timed_out = false;
+    int8_t green_on = -1;                               // Últimas salidas escritas (-1 = desconocida)
+    int8_t red_on = -1;
+
+    void start_closing(clock::time_point now) {
+        if (state_ == BarrierState::Open) {
+            timed_out = !(lane_clear && now >= close_after);
+            open_time = now - opened_at;
+        }
+        ServoMove motion = actuator.servo(false, now);
+        if (!motion.ok) {
+            enter_fault(now);
+            return;
+        }
+        state_ = BarrierState::Closing;
+        deadline = now + motion.settled;
+    }
+
+    void enter_fault(clock::time_point now) {
+        state_ = BarrierState::Fault;
+        deadline = now + timing.fault_retry;
+    }
+
+    /**
+     * Escribe los LEDs que corresponden al estado, solo si cambiaron.
+     */
+    void lights(clock::time_point now) {
+        if (blink_until > clock::time_point::min() && now >= blink_until) blink_until = clock::time_point::min();
+        bool green = state_ == BarrierState::Open;
+        bool red = !green && blink_until == clock::time_point::min();
+        if (green != (green_on == 1) || red != (red_on == 1)) {
+            actuator.lights(green, red);
+            green_on = green;
+            red_on = red;
+        }
+    }
+};
+
+#endif // BARRIER_CONTROLLER_H
@@ -0,0 +1,63 @@
+#include "coro_executor.h"
+#include <vector>
+#include "logger.h"
+
+using namespace std;
+
+/**
+ * Corrutina envoltorio de spawn(): espera a la tarea y, al terminar, se quita
+ * del registro del ejecutor y libera su marco.
+ */
+struct CoroExecutor::Detached {
+    struct promise_type {
+        CoroExecutor* owner = nullptr;
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<promise_type> h) const noexcept {
+                h.promise().owner->live.erase(h.address());
+                h.destroy();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Detached get_return_object() noexcept { return {coroutine_handle<promise_type>::from_promise(*this)}; }
+        suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { terminate(); }
+    };
+
+    coroutine_handle<promise_type> handle;
+};
+
+CoroExecutor::Detached CoroExecutor::run_detached(Task<void> task, const char* name) {
+    try {
+        co_await task;
+    } catch (const exception& e) {
+        LOG_ERROR("[CORO] %s terminó con una excepción: %s", name, e.what());
+    }
+}
+
+CoroExecutor::~CoroExecutor() {
+    // Destruir el envoltorio destruye la tarea que esperaba (y las que ella esperaba)
+    // Las guardas que se destruyen con los marcos no deben retomar a nadie
+    closing = true;
+    vector<void*> pending(live.begin(), live.end());
+    live.clear();
+    for (void* address : pending) coroutine_handle<>::from_address(address).destroy();
+}
+
+void CoroExecutor::spawn(Task<void> task, const char* name) {
+    Detached detached = run_detached(std::move(task), name);
+    detached.handle.promise().owner = this;
+    live.insert(detached.handle.address());
+    spawned_count++;
+    peak_active = max(peak_active, live.size());
+    detached.handle.resume();
+}
+
+void CoroExecutor::resume_later(coroutine_handle<> h) {
+    if (closing) return;
+    if (!loop.post([h] { h.resume(); })) h.resume();
+}
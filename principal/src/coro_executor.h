@@ -0,0 +1,196 @@
+#ifndef CORO_EXECUTOR_H
+#define CORO_EXECUTOR_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include "coro_task.h"
+#include "event_loop.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+/**
+ * Clase CoroExecutor
+ * Ejecutor de corrutinas sobre un EventLoop. Todas las corrutinas corren en el
+ * hilo del loop y se suspenden en awaitables respaldados por sus fuentes:
+ * temporizadores (sleep_until), tareas del WorkerPool (offload) o la cola de
+ * tareas del loop (yield). Cada corrutina suspendida cuesta solo su marco, no
+ * un hilo.
+ *
+ * Las corrutinas lanzadas con spawn() son independientes: se liberan solas al
+ * terminar y las que siguen suspendidas al destruir el ejecutor se destruyen
+ * con él. Antes de eso hay que detener el WorkerPool y el loop, para que
+ * ningún awaitable pendiente retome un marco ya destruido.
+ */
+class CoroExecutor {
+public:
+    using clock = EventLoop::clock;
+
+    CoroExecutor(EventLoop& loop, WorkerPool& pool) : loop(loop), pool(pool) {}
+    ~CoroExecutor();
+
+    CoroExecutor(const CoroExecutor&) = delete;
+    CoroExecutor& operator=(const CoroExecutor&) = delete;
+
+    /**
+     * Lanza una corrutina independiente: corre ya, hasta su primera suspensión.
+     * Una excepción que escape de ella se registra en el log.
+     * @param name Nombre para el log (debe ser un literal)
+     */
+    void spawn(Task<void> task, const char* name);
+
+    /** Corrutinas lanzadas que todavía no terminaron */
+    size_t active() const { return live.size(); }
+    size_t peak() const { return peak_active; }
+    uint64_t spawned() const { return spawned_count; }
+
+    /** Suspende hasta el instante absoluto `when` (temporizador del loop) */
+    auto sleep_until(clock::time_point when) {
+        struct Awaiter {
+            EventLoop& loop;
+            clock::time_point when;
+            bool await_ready() const { return clock::now() >= when; }
+            void await_suspend(coroutine_handle<> h) { loop.add_timer(when, [h] { h.resume(); }); }
+            void await_resume() const {}
+        };
+        return Awaiter{loop, when};
+    }
+
+    /** Cede el hilo del loop: retoma después de los eventos ya pendientes */
+    auto yield() {
+        struct Awaiter {
+            EventLoop& loop;
+            bool await_ready() const { return false; }
+            bool await_suspend(coroutine_handle<> h) { return loop.post([h] { h.resume(); }); }
+            void await_resume() const {}
+        };
+        return Awaiter{loop};
+    }
+
+    /**
+     * Corre `fn` (bloqueante) en el WorkerPool y retoma en el hilo del loop
+     * con su resultado. Una excepción de `fn` se relanza en el co_await, igual
+     * que el rechazo del pool si está lleno. `fn` debe devolver un valor (no void).
+     */
+    template <typename F>
+    auto offload(F fn, TaskClass cls = TaskClass::Live) {
+        using Result = invoke_result_t<F&>;
+        static_assert(!is_void_v<Result>, "offload requiere una función con resultado");
+
+        struct Awaiter {
+            CoroExecutor& ex;
+            F fn;
+            TaskClass cls;
+            optional<Result> result;
+            exception_ptr error;
+
+            bool await_ready() const { return false; }
+            bool await_suspend(coroutine_handle<> h) {
+                bool queued = ex.pool.submit([this, h] {
+                    try {
+                        result.emplace(fn());
+                    } catch (...) {
+                        error = current_exception();
+                    }
+                    // Si el loop ya terminó, el marco se destruye con el ejecutor
+                    ex.loop.post([h] { h.resume(); });
+                }, cls);
+                if (!queued) error = make_exception_ptr(runtime_error("pool de trabajo lleno"));
+                return queued;
+            }
+            Result await_resume() {
+                if (error) rethrow_exception(error);
+                return std::move(*result);
+            }
+        };
+        return Awaiter{*this, std::move(fn), cls, nullopt, nullptr};
+    }
+
+    /**
+     * Retoma `h` desde la cola de tareas del loop (o directamente si está llena),
+     * para no anidar la corrutina retomada dentro de la que la despierta.
+     */
+    void resume_later(coroutine_handle<> h);
+
+    EventLoop& loop;
+    WorkerPool& pool;
+
+private:
+    struct Detached;
+    static Detached run_detached(Task<void> task, const char* name);
+
+    unordered_set<void*> live;             // Marcos de las corrutinas lanzadas con spawn()
+    size_t peak_active = 0;
+    uint64_t spawned_count = 0;
+    bool closing = false;                  // Destruyendo los marcos pendientes
+};
+
+/**
+ * Clase AsyncSemaphore
+ * Semáforo para corrutinas del mismo CoroExecutor (solo el hilo del loop).
+ * Quien no obtiene un permiso queda suspendido sin bloquear el loop; los
+ * permisos se ceden en orden de llegada. `co_await acquire()` devuelve una
+ * guarda que devuelve el permiso al destruirse.
+ */
+class AsyncSemaphore {
+public:
+    class Guard {
+    public:
+        explicit Guard(AsyncSemaphore* owner) : owner(owner) {}
+        Guard(Guard&& other) noexcept : owner(exchange(other.owner, nullptr)) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() {
+            if (owner) owner->release();
+        }
+
+    private:
+        AsyncSemaphore* owner;
+    };
+
+    AsyncSemaphore(CoroExecutor& executor, size_t permits) : executor(executor), available(permits) {}
+
+    auto acquire() {
+        struct Awaiter {
+            AsyncSemaphore& sem;
+            bool await_ready() {
+                if (sem.available == 0) return false;
+                sem.available--;
+                return true;
+            }
+            void await_suspend(coroutine_handle<> h) { sem.waiters.push_back(h); }
+            Guard await_resume() { return Guard(&sem); }
+        };
+        return Awaiter{*this};
+    }
+
+    /** Corrutinas esperando un permiso */
+    size_t waiting() const { return waiters.size(); }
+
+private:
+    CoroExecutor& executor;
+    size_t available;
+    deque<coroutine_handle<>> waiters;
+
+    void release() {
+        if (waiters.empty()) {
+            available++;
+            return;
+        }
+        // El permiso pasa directo al primero en espera
+        coroutine_handle<> next = waiters.front();
+        waiters.pop_front();
+        executor.resume_later(next);
+    }
+};
+
+#endif // CORO_EXECUTOR_H
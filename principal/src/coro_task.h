@@ -0,0 +1,127 @@
+#ifndef CORO_TASK_H
+#define CORO_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+using namespace std;
+
+template <typename T = void>
+class Task;
+
+namespace coro_detail {
+
+/**
+ * Al terminar, una tarea le cede el hilo a quien la esperaba (transferencia
+ * simétrica: no crece la pila aunque se encadenen muchas tareas).
+ */
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    coroutine_handle<> await_suspend(coroutine_handle<Promise> h) const noexcept {
+        coroutine_handle<> next = h.promise().continuation;
+        return next ? next : noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    coroutine_handle<> continuation;
+    exception_ptr error;
+
+    suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T take() {
+        if (error) rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void take() {
+        if (error) rethrow_exception(error);
+    }
+};
+
+} // namespace coro_detail
+
+/**
+ * Clase Task
+ * Corrutina perezosa con resultado: empieza recién cuando alguien la espera
+ * con co_await, y al terminar retoma a ese llamador. Una excepción dentro de
+ * la tarea se relanza en el co_await. Es dueña de su marco: destruir la Task
+ * destruye la corrutina (y las que esté esperando).
+ *
+ * No tiene planificador propio: corre en el hilo que la retoma. En este
+ * proyecto ese hilo es el del EventLoop (ver CoroExecutor).
+ */
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = coro_detail::Promise<T>;
+
+    Task() = default;
+    explicit Task(coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool valid() const { return static_cast<bool>(handle); }
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    coroutine_handle<> await_suspend(coroutine_handle<> caller) noexcept {
+        handle.promise().continuation = caller;
+        return handle;
+    }
+
+    T await_resume() { return handle.promise().take(); }
+
+private:
+    coroutine_handle<promise_type> handle;
+};
+
+namespace coro_detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace coro_detail
+
+#endif // CORO_TASK_H
@@ -0,0 +1,91 @@
+#ifndef EVENT_CHANNEL_H
+#define EVENT_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "futex_signal.h"
+#include "ring_buffer.h"
+
+using namespace std;
+
+/**
+ * Clase EventChannel
+ * Canal FIFO acotado entre etapas del pipeline: varios productores, un consumidor.
+ * Inserta sin locks en un MpscRing y despierta al consumidor con un futex.
+ *
+ * @tparam T Tipo de evento transportado
+ * @tparam Capacity Cantidad de slots, potencia de dos
+ */
+template <typename T, size_t Capacity>
+class EventChannel {
+private:
+    MpscRing<T, Capacity> ring;
+    FutexSignal signal;
+    atomic<uint64_t> drops{0};        // Eventos rechazados por canal lleno
+
+public:
+    /**
+     * Inserta un evento sin bloquear. Puede llamarse desde cualquier hilo.
+     * @return false si el canal estaba lleno y el evento se descartó
+     */
+    bool push(T ev) {
+        if (!ring.try_push(move(ev))) {
+            drops.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        signal.notify();
+        return true;
+    }
+
+    /**
+     * Extrae un evento si hay alguno disponible. Solo el consumidor.
+     */
+    bool try_pop(T& out) {
+        return ring.try_pop(out);
+    }
+
+    /**
+     * Espera hasta que haya un evento o venza el tiempo. Solo el consumidor.
+     * @param out Evento extraído
+     * @param timeout Tiempo máximo de espera
+     * @return false si venció el tiempo sin eventos
+     */
+    bool wait_and_pop(T& out, chrono::nanoseconds timeout) {
+        auto deadline = chrono::steady_clock::now() + timeout;
+        for (;;) {
+            uint32_t seq = signal.prepare();
+            if (ring.try_pop(out)) return true;
+            auto remaining = deadline - chrono::steady_clock::now();
+            if (remaining <= chrono::nanoseconds::zero()) return false;
+            signal.wait_for(seq, remaining);
+        }
+    }
+
+    /**
+     * Espera un evento, un wake() o el instante límite, lo que ocurra primero.
+     * Solo el consumidor. Es para consumidores que además atienden plazos u
+     * otro estado compartido y lo revisan cada vez que vuelven.
+     * @param out Evento extraído
+     * @param deadline Instante límite (steady_clock)
+     * @return true si extrajo un evento
+     */
+    bool pop_or_wait_until(T& out, chrono::steady_clock::time_point deadline) {
+        uint32_t seq = signal.prepare();
+        if (ring.try_pop(out)) return true;
+        signal.wait_until(seq, deadline);
+        return ring.try_pop(out);
+    }
+
+    /**
+     * Despierta al consumidor sin publicar nada (por ejemplo, para que revise si debe terminar).
+     */
+    void wake() {
+        signal.notify();
+    }
+
+    size_t depth() const { return ring.size(); }
+    uint64_t dropped() const { return drops.load(memory_order_relaxed); }
+};
+
+#endif // EVENT_CHANNEL_H
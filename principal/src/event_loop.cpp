@@ -0,0 +1,219 @@
+#include "event_loop.h"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "logger.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+// data.u64 de epoll: generación en la parte alta, descriptor en la baja
+uint64_t pack(int fd, uint32_t generation) {
+    return (uint64_t(generation) << 32) | uint32_t(fd);
+}
+
+} // namespace
+
+EventLoop::EventLoop(milliseconds dispatch_budget) : dispatch_budget(dispatch_budget) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!ok()) {
+        LOG_ERROR("[LOOP] No se pudo crear epoll/timerfd/eventfd: %s", strerror(errno));
+        return;
+    }
+    add_fd(timer_fd, EPOLLIN, [this](uint32_t) { on_timer(); });
+    add_fd(wake_fd, EPOLLIN, [this](uint32_t) { on_wake(); });
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : {epoll_fd, timer_fd, wake_fd}) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool EventLoop::add_fd(int fd, uint32_t events, FdHandler handler) {
+    uint32_t generation = ++next_generation;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = pack(fd, generation);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        LOG_ERROR("[LOOP] epoll_ctl(ADD, %d): %s", fd, strerror(errno));
+        return false;
+    }
+    watches[fd] = Watch{generation, move(handler)};
+    return true;
+}
+
+bool EventLoop::modify_fd(int fd, uint32_t events) {
+    auto it = watches.find(fd);
+    if (it == watches.end()) return false;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = pack(fd, it->second.generation);
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove_fd(int fd) {
+    if (watches.erase(fd) == 0) return;
+    // Puede fallar si el descriptor ya se cerró: epoll lo quitó solo
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+EventLoop::TimerId EventLoop::add_timer(clock::time_point when, Task fn) {
+    TimerId id = next_timer++;
+    timers.emplace(id, move(fn));
+    timer_heap.emplace(when, id);
+    arm_timer();
+    return id;
+}
+
+bool EventLoop::cancel_timer(TimerId id) {
+    return timers.erase(id) > 0;
+}
+
+bool EventLoop::post(Task fn) {
+    bool own_thread = loop_thread.load(memory_order_relaxed) == this_thread::get_id();
+    while (!tasks.try_push(move(fn))) {
+        if (own_thread || stopping.load(memory_order_acquire)) return false;
+        this_thread::yield();
+    }
+    posted.fetch_add(1, memory_order_relaxed);
+    signal_wake();
+    return true;
+}
+
+void EventLoop::run() {
+    loop_thread.store(this_thread::get_id(), memory_order_relaxed);
+    epoll_event events[32];
+
+    while (!stopping.load(memory_order_acquire)) {
+        int n = epoll_wait(epoll_fd, events, 32, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("[LOOP] epoll_wait: %s", strerror(errno));
+            break;
+        }
+        wakeups.fetch_add(1, memory_order_relaxed);
+
+        for (int i = 0; i < n; i++) {
+            int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFF);
+            uint32_t generation = static_cast<uint32_t>(events[i].data.u64 >> 32);
+            // Un callback anterior de esta vuelta pudo quitar (o reemplazar) el descriptor
+            auto it = watches.find(fd);
+            if (it == watches.end() || it->second.generation != generation) continue;
+            FdHandler handler = it->second.handler;
+            uint32_t mask = events[i].events;
+            dispatch("fd", [&handler, mask] { handler(mask); });
+        }
+        if (after_dispatch) dispatch("after", after_dispatch);
+    }
+    loop_thread.store(thread::id(), memory_order_relaxed);
+}
+
+void EventLoop::stop() {
+    stopping.store(true, memory_order_release);
+    uint64_t one = 1;
+    (void)!write(wake_fd, &one, sizeof(one));
+}
+
+EventLoop::Stats EventLoop::stats() const {
+    Stats s;
+    s.wakeups = wakeups.load(memory_order_relaxed);
+    s.dispatches = dispatches.load(memory_order_relaxed);
+    s.overruns = overruns.load(memory_order_relaxed);
+    s.timers = timers_fired.load(memory_order_relaxed);
+    s.posted = posted.load(memory_order_relaxed);
+    s.dispatch = dispatch_time.snapshot();
+    return s;
+}
+
+/**
+ * Corre un callback midiendo su duración. Una excepción se registra y no
+ * detiene el loop, como en los hilos de trabajo.
+ */
+void EventLoop::dispatch(const char* kind, const Task& fn) {
+    auto start = clock::now();
+    try {
+        fn();
+    } catch (const exception& e) {
+        LOG_ERROR("[LOOP] Excepción en callback (%s): %s", kind, e.what());
+    }
+    auto elapsed = clock::now() - start;
+    dispatches.fetch_add(1, memory_order_relaxed);
+    dispatch_time.record(elapsed.count());
+    if (elapsed > dispatch_budget) {
+        overruns.fetch_add(1, memory_order_relaxed);
+        LOG_WARN("[LOOP] Callback (%s) bloqueó el loop %.1f ms (presupuesto %.1f ms)", kind,
+                 duration<double, milli>(elapsed).count(), duration<double, milli>(dispatch_budget).count());
+    }
+}
+
+/**
+ * Corre los temporizadores vencidos y rearma el timerfd con el próximo.
+ */
+void EventLoop::on_timer() {
+    uint64_t expirations;
+    (void)!read(timer_fd, &expirations, sizeof(expirations));
+    armed_at = clock::time_point::max();
+
+    auto now = clock::now();
+    while (!timer_heap.empty() && timer_heap.top().first <= now) {
+        TimerId id = timer_heap.top().second;
+        timer_heap.pop();
+        auto it = timers.find(id);
+        if (it == timers.end()) continue;
+        Task fn = move(it->second);
+        timers.erase(it);
+        timers_fired.fetch_add(1, memory_order_relaxed);
+        dispatch("timer", fn);
+    }
+    arm_timer();
+}
+
+/**
+ * Corre las tareas recibidas de otros hilos.
+ */
+void EventLoop::on_wake() {
+    uint64_t count;
+    (void)!read(wake_fd, &count, sizeof(count));
+    // Se baja antes de vaciar: un post() concurrente vuelve a escribir el eventfd
+    wake_pending.store(false, memory_order_release);
+
+    Task fn;
+    while (tasks.try_pop(fn)) {
+        dispatch("task", fn);
+        fn = nullptr;
+    }
+}
+
+/**
+ * Programa el timerfd (tiempo absoluto) para el temporizador vigente más próximo.
+ */
+void EventLoop::arm_timer() {
+    while (!timer_heap.empty() && !timers.count(timer_heap.top().second)) timer_heap.pop();
+    clock::time_point next = timer_heap.empty() ? clock::time_point::max() : timer_heap.top().first;
+    if (next == armed_at) return;
+    armed_at = next;
+
+    itimerspec spec{};
+    if (next != clock::time_point::max()) {
+        // steady_clock es CLOCK_MONOTONIC; un instante ya pasado dispara enseguida
+        auto ns = max<int64_t>(duration_cast<nanoseconds>(next.time_since_epoch()).count(), 1);
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::signal_wake() {
+    if (wake_pending.exchange(true, memory_order_acq_rel)) return;
+    uint64_t one = 1;
+    (void)!write(wake_fd, &one, sizeof(one));
+}
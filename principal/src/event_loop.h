@@ -0,0 +1,130 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "latency_histogram.h"
+#include "ring_buffer.h"
+
+using namespace std;
+
+/**
+ * Clase EventLoop
+ * Bucle de eventos de un solo hilo sobre epoll. Multiplexa descriptores
+ * (sockets, signalfd), temporizadores absolutos sobre un único timerfd y
+ * tareas que otros hilos le envían con post() (MpscRing + eventfd, sin locks).
+ *
+ * Todos los callbacks corren en el hilo de run() y no deben bloquear: el
+ * trabajo pesado va a un WorkerPool, que devuelve el resultado con post().
+ * Cada despacho se mide; los que superan `dispatch_budget` se cuentan como
+ * desbordes, el equivalente de los timeouts del supervisor en este modo.
+ */
+class EventLoop {
+public:
+    using clock = chrono::steady_clock;
+    using TimerId = uint64_t;
+    using Task = function<void()>;
+    using FdHandler = function<void(uint32_t events)>;
+
+    /** Estadísticas del loop; pueden leerse desde cualquier hilo */
+    struct Stats {
+        uint64_t wakeups = 0;          // Retornos de epoll_wait
+        uint64_t dispatches = 0;       // Callbacks ejecutados (descriptores, timers, tareas)
+        uint64_t overruns = 0;         // Despachos que superaron el presupuesto
+        uint64_t timers = 0;           // Temporizadores vencidos
+        uint64_t posted = 0;           // Tareas recibidas de otros hilos
+        HistogramSnapshot dispatch;    // Duración de cada despacho (ns)
+    };
+
+    explicit EventLoop(chrono::milliseconds dispatch_budget = chrono::milliseconds(50));
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /** false si no se pudo crear el epoll, el timerfd o el eventfd */
+    bool ok() const { return epoll_fd >= 0 && timer_fd >= 0 && wake_fd >= 0; }
+
+    /**
+     * Vigila un descriptor. Solo desde el hilo del loop (o antes de run()).
+     * @param events Máscara EPOLLIN/EPOLLOUT/...
+     * @param handler Recibe los eventos ocurridos
+     */
+    bool add_fd(int fd, uint32_t events, FdHandler handler);
+    bool modify_fd(int fd, uint32_t events);
+    void remove_fd(int fd);
+
+    /**
+     * Programa `fn` para el instante absoluto `when`. Solo desde el hilo del loop.
+     * @return Id para cancel_timer() (nunca 0)
+     */
+    TimerId add_timer(clock::time_point when, Task fn);
+
+    /** @return false si el temporizador ya corrió o fue cancelado */
+    bool cancel_timer(TimerId id);
+
+    /**
+     * Encola `fn` para el hilo del loop. Puede llamarse desde cualquier hilo;
+     * con el buffer lleno, otro hilo cede el CPU hasta que haya lugar.
+     * @return false si el loop ya terminó (o, desde el propio loop, si el buffer está lleno)
+     */
+    bool post(Task fn);
+
+    /** Tarea que corre al final de cada vuelta, después de despachar los eventos */
+    void set_after_dispatch(Task fn) { after_dispatch = move(fn); }
+
+    /** Despacha eventos hasta stop() */
+    void run();
+
+    /** Pide que run() termine. Puede llamarse desde cualquier hilo */
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Watch {
+        uint32_t generation;           // Distingue un descriptor reusado dentro de una misma vuelta
+        FdHandler handler;
+    };
+    using TimerEntry = pair<clock::time_point, TimerId>;
+
+    int epoll_fd = -1;
+    int timer_fd = -1;
+    int wake_fd = -1;
+    chrono::nanoseconds dispatch_budget;
+
+    unordered_map<int, Watch> watches;
+    uint32_t next_generation = 0;
+
+    priority_queue<TimerEntry, vector<TimerEntry>, greater<TimerEntry>> timer_heap;
+    unordered_map<TimerId, Task> timers;   // Vigentes; los cancelados quedan en el heap hasta vencer
+    TimerId next_timer = 1;
+    clock::time_point armed_at = clock::time_point::max();
+
+    MpscRing<Task, 256> tasks;
+    atomic<bool> wake_pending{false};
+    atomic<bool> stopping{false};
+    atomic<thread::id> loop_thread{};
+    Task after_dispatch;
+
+    atomic<uint64_t> wakeups{0};
+    atomic<uint64_t> dispatches{0};
+    atomic<uint64_t> overruns{0};
+    atomic<uint64_t> timers_fired{0};
+    atomic<uint64_t> posted{0};
+    LatencyHistogram dispatch_time;
+
+    void dispatch(const char* kind, const Task& fn);
+    void on_timer();
+    void on_wake();
+    void arm_timer();
+    void signal_wake();
+};
+
+#endif // EVENT_LOOP_H
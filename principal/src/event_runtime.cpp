@@ -0,0 +1,387 @@
+#include "event_runtime.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <iostream>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include "logger.h"
+#include "shared_data.h"
+#include "tracer.h"
+#include "threads/camera.h"
+
+using namespace std;
+using namespace chrono;
+
+/** Disparos del sensor (el mismo canal del modo de hilos) */
+extern TriggerChannel triggerChannel;
+
+namespace {
+
+const size_t MAX_UPLOADS = 2;                   // Envíos simultáneos al backend
+const milliseconds DISPATCH_BUDGET(50);         // Tiempo máximo que un callback puede ocupar el loop
+const milliseconds CAPTURE_BUDGET(2000);        // Plazo de una captura (el techo del hilo de cámara)
+const seconds SENSOR_SETTLE(1);                 // Espera antes de la primera medición
+// La medición corre en el loop: el eco se acota para que pausa y dos flancos
+// (2 + 2 × 20 ms) entren en DISPATCH_BUDGET. 20 ms de eco son ~3,4 m, de sobra
+// para el umbral de detección de 30 cm
+const microseconds LOOP_ECHO_TIMEOUT(20000);
+
+/**
+ * Cantidad de hilos del pool (STR_LOOP_WORKERS, 1 a 4).
+ * @param fallback Valor si la variable no está o está fuera de rango
+ */
+size_t pool_size_from_env(size_t fallback) {
+    const char* value = getenv("STR_LOOP_WORKERS");
+    if (!value || !*value) return fallback;
+    long n = strtol(value, nullptr, 10);
+    if (n < 1 || n > 4) {
+        LOG_WARN("[LOOP] STR_LOOP_WORKERS fuera de rango (1-4): %s", value);
+        return fallback;
+    }
+    return static_cast<size_t>(n);
+}
+
+} // namespace
+
+/**
+ * Awaitable de un envío por curl_multi: agrega el pedido al multi handle y
+ * retoma cuando collect_transfers() lo da por terminado.
+ */
+struct EventRuntime::Transfer {
+    EventRuntime& runtime;
+    UploadRequest& request;
+    coroutine_handle<> waiter;
+    CURLcode result = CURLE_OK;
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(coroutine_handle<> h) {
+        waiter = h;
+        CURLMcode rc = curl_multi_add_handle(runtime.multi, request.handle());
+        if (rc != CURLM_OK) {
+            LOG_ERROR("Error en cURL multi: %s", curl_multi_strerror(rc));
+            result = CURLE_FAILED_INIT;
+            return false;
+        }
+        runtime.transfers.push_back(this);
+        return true;
+    }
+
+    CURLcode await_resume() const { return result; }
+};
+
+EventRuntime::EventRuntime(cv::VideoCapture& cam, RtProfile& rt) : cam(cam), rt(rt), loop(DISPATCH_BUDGET) {}
+
+EventRuntime::~EventRuntime() {
+    stopping.store(true, memory_order_relaxed);
+    if (pool) pool->stop();
+    // Los envíos en curso salen del multi antes de destruir las corrutinas que los esperan
+    for (Transfer* t : transfers) curl_multi_remove_handle(multi, t->request.handle());
+    transfers.clear();
+    executor.reset();
+    if (multi) curl_multi_cleanup(multi);
+    if (signal_fd >= 0) close(signal_fd);
+}
+
+int EventRuntime::run(const sigset_t& signals) {
+    // SIGUSR1 también por signalfd: se bloquea antes de crear el pool para que lo herede
+    sigset_t mask = signals;
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    multi = curl_multi_init();
+    if (!loop.ok() || signal_fd < 0 || !multi) {
+        cerr << "Error al crear el event loop" << endl;
+        return EXIT_FAILURE;
+    }
+    loop.add_fd(signal_fd, EPOLLIN, [this](uint32_t) { on_signal(); });
+
+    curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, curl_socket_cb);
+    curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, curl_timer_cb);
+    curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+
+    // Un hilo por núcleo de fondo, fuera de los núcleos de tiempo real
+    size_t threads = pool_size_from_env(clamp<size_t>(rt.worker_cpus(), 1, 4));
+    pool = make_unique<WorkerPool>(threads, [this](size_t) {
+        Logger::instance().set_thread_name("pool");
+        Tracer::instance().set_thread_name("pool");
+        rt.confine_worker();
+    });
+    executor = make_unique<CoroExecutor>(loop, *pool);
+    camera = make_unique<AsyncSemaphore>(*executor, 1);
+    upload_slots = make_unique<AsyncSemaphore>(*executor, MAX_UPLOADS);
+    detector = make_unique<VehicleDetector>(LOOP_ECHO_TIMEOUT);
+    station = make_unique<BarrierStation>();
+
+    // El loop hace el trabajo del sensor: toma su rol
+    Logger::instance().set_thread_name("loop");
+    Tracer::instance().set_thread_name("loop");
+    rt.apply(ThreadRole::Sensor);
+
+    loop.add_timer(clock::now() + rt.warmup, [this] { rt.mark_warm(); });
+
+    // Los plazos de la barrera se revisan al final de cada vuelta
+    loop.set_after_dispatch([this] { update_barrier(); });
+
+    LOG_INFO("[LOOP] Event loop iniciado (%zu hilos de captura)", pool->size());
+    executor->spawn(lane(), "carril");
+    loop.run();
+
+    stopping.store(true, memory_order_relaxed);
+    size_t dropped = pool->stop();
+    if (dropped > 0) LOG_WARN("[LOOP] %zu capturas descartadas al apagar", dropped);
+    return EXIT_SUCCESS;
+}
+
+void EventRuntime::print_report() {
+    auto ms = [](double ns) { return ns / 1e6; };
+    EventLoop::Stats s = loop.stats();
+    cout << "[LOOP] Event loop:" << endl;
+    cout << "  despertares=" << s.wakeups << " despachos=" << s.dispatches
+         << " p50=" << ms(s.dispatch.p50) << " p99=" << ms(s.dispatch.p99) << " max=" << ms(s.dispatch.max)
+         << " desbordes=" << s.overruns << " (presupuesto " << DISPATCH_BUDGET.count() << " ms)" << endl;
+    cout << "  temporizadores=" << s.timers << " tareas del pool=" << s.posted << endl;
+    if (executor) {
+        cout << "  corrutinas: lanzadas=" << executor->spawned() << " en_vuelo_max=" << executor->peak()
+             << " pendientes=" << executor->active() << endl;
+    }
+    for (size_t c = 0; c < TASK_CLASS_COUNT; c++) {
+        WorkerPool::ClassStats p = pool->stats(static_cast<TaskClass>(c));
+        if (p.submitted == 0 && p.rejected == 0) continue;
+        cout << "  pool " << TASK_CLASS_NAMES[c] << ": tareas=" << p.submitted << " rechazadas=" << p.rejected
+             << " espera p50=" << ms(p.wait.p50) << " p99=" << ms(p.wait.p99)
+             << " ejecución p50=" << ms(p.run.p50) << " p99=" << ms(p.run.p99) << " max=" << ms(p.run.max) << endl;
+    }
+    cout << "  pool: hilos=" << pool->size() << " robadas=" << pool->stolen() << endl;
+    cout << "  sensor: muestras=" << samples << " invalidas=" << invalid_samples
+         << " periodos_perdidos=" << sample_overruns << endl;
+    cout << "  camara: capturas=" << captures << " fuera_de_plazo=" << capture_overruns << endl;
+    cout << "  comunicador: envios=" << uploads_started << endl;
+    cout << "  barrera: fallas=" << barrier_faults << endl;
+}
+
+/**
+ * Corrutina del carril: espera cada vehículo detectado y lanza su recorrido,
+ * sin esperar a que termine el anterior.
+ */
+Task<void> EventRuntime::lane() {
+    next_sample = clock::now() + SENSOR_SETTLE;
+    while (VehicleEvent* vehicle = co_await detection()) {
+        executor->spawn(vehicle_flow(vehicle), "vehiculo");
+    }
+}
+
+/**
+ * Mide en cada instante de muestreo hasta que el sensor dispara un vehículo.
+ * Como PeriodicTimer, el muestreo sigue instantes absolutos: una medición que
+ * se pasa del período saltea los instantes perdidos y retoma la fase.
+ * @return nullptr al apagar
+ */
+Task<VehicleEvent*> EventRuntime::detection() {
+    VehicleEvent* vehicle = nullptr;
+    while (!triggerChannel.try_pop(vehicle)) {
+        co_await executor->sleep_until(next_sample);
+        if (stopping.load(memory_order_relaxed)) co_return nullptr;
+
+        samples++;
+        if (!detector->sample()) invalid_samples++;
+
+        next_sample += SAMPLE_PERIOD;
+        auto now = clock::now();
+        if (next_sample <= now) {
+            auto missed = (now - next_sample) / SAMPLE_PERIOD + 1;
+            sample_overruns += static_cast<uint64_t>(missed);
+            next_sample += SAMPLE_PERIOD * missed;
+        }
+    }
+    co_return vehicle;
+}
+
+/**
+ * Recorrido completo de un vehículo: foto, consulta al backend y barrera.
+ */
+Task<void> EventRuntime::vehicle_flow(VehicleEvent* vehicle) {
+    string filename;
+    if (!co_await capture(vehicle, filename)) {
+        release_vehicle(vehicle);
+        co_return;
+    }
+    vehicle->set_path(filename);
+    vehicle->deadline = vehicle->trigger_time() + PHOTO_DEADLINE;
+
+    co_await upload(vehicle);
+
+    // Las fotos vencidas terminan acá: el vehículo ya no está en la barrera
+    if (vehicle->stale) {
+        release_vehicle(vehicle);
+        co_return;
+    }
+    station->actuate(vehicle, clock::now());
+    BarrierStation::finish(vehicle);
+}
+
+/**
+ * Captura y codifica la foto en el WorkerPool, de a una por vez. El plazo de
+ * la captura es un temporizador del loop que solo avisa: la captura en curso
+ * no se puede interrumpir.
+ */
+Task<bool> EventRuntime::capture(VehicleEvent* vehicle, string& filename) {
+    auto device = co_await camera->acquire();
+    captures++;
+    auto deadline = loop.add_timer(clock::now() + CAPTURE_BUDGET, [this, id = vehicle->id] {
+        capture_overruns++;
+        LOG_WARN("[LOOP] La captura del vehículo #%" PRIu64 " supera su plazo de %lld ms", id,
+                 static_cast<long long>(CAPTURE_BUDGET.count()));
+    });
+    bool ok = false;
+    try {
+        ok = co_await executor->offload([this, vehicle, &filename] {
+            return capturePhoto(cam, vehicle, filename, [this] { return !stopping.load(memory_order_relaxed); });
+        }, TaskClass::Live);
+    } catch (const exception& e) {
+        LOG_ERROR("[LOOP] Captura del vehículo #%" PRIu64 " fallida: %s", vehicle->id, e.what());
+    }
+    loop.cancel_timer(deadline);
+    co_return ok;
+}
+
+/**
+ * Consulta al backend por curl_multi, con a lo sumo MAX_UPLOADS en curso. Si
+ * la foto esperó su turno más que su plazo, como en la cola de plazos del modo
+ * de hilos, se envía solo para auditoría.
+ */
+Task<void> EventRuntime::upload(VehicleEvent* vehicle) {
+    auto slot = co_await upload_slots->acquire();
+    if (clock::now() >= vehicle->deadline) vehicle->stale = true;
+
+    UploadRequest request(vehicle);
+    if (request.prepare()) {
+        request.begin();
+        uploads_started++;
+        request.finish(co_await transfer(request));
+    }
+    recordDecision(vehicle);
+}
+
+EventRuntime::Transfer EventRuntime::transfer(UploadRequest& request) {
+    return Transfer{*this, request, nullptr};
+}
+
+/**
+ * Señales por signalfd: SIGINT detiene el loop, SIGUSR1 lanza el recorrido
+ * de una foto manual y SIGUSR2 pide un volcado de la traza.
+ */
+void EventRuntime::on_signal() {
+    signalfd_siginfo info;
+    while (read(signal_fd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        switch (info.ssi_signo) {
+        case SIGINT:
+            cout << "\n🛑 SIGINT recibida en el event loop. Iniciando apagado..." << endl;
+            stopping.store(true, memory_order_relaxed);
+            loop.stop();
+            break;
+        case SIGUSR1:
+            handle_signal_camera(SIGUSR1);
+            if (VehicleEvent* vehicle = takeManualTrigger()) executor->spawn(vehicle_flow(vehicle), "manual");
+            break;
+        case SIGUSR2:
+            Tracer::instance().request_dump("manual", true);
+            break;
+        }
+    }
+}
+
+/**
+ * Toma la ocupación del carril, vence los plazos de la barrera y rearma su
+ * temporizador si cambió el próximo plazo. El temporizador solo despierta al
+ * loop: esta función corre al final de cada vuelta.
+ */
+void EventRuntime::update_barrier() {
+    if (stopping.load(memory_order_relaxed)) return;
+    station->poll(clock::now());
+    if (station->update()) {
+        barrier_faults++;
+        LOG_ERROR("[LOOP] Falla en la barrera");
+    }
+
+    auto deadline = station->next_deadline();
+    if (deadline == barrier_timer_at) return;
+    if (barrier_timer) loop.cancel_timer(barrier_timer);
+    barrier_timer = 0;
+    barrier_timer_at = deadline;
+    if (deadline == clock::time_point::max()) return;
+    barrier_timer = loop.add_timer(deadline, [this] {
+        barrier_timer = 0;
+        barrier_timer_at = clock::time_point::max();
+    });
+}
+
+void EventRuntime::curl_action(curl_socket_t socket, int flags) {
+    int running = 0;
+    curl_multi_socket_action(multi, socket, flags, &running);
+    collect_transfers();
+}
+
+/**
+ * Retoma las corrutinas cuyos envíos terminaron. Se retoman después de leer
+ * todos los mensajes: una corrutina retomada puede agregar otro envío.
+ */
+void EventRuntime::collect_transfers() {
+    vector<Transfer*> done;
+    int queued = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        CURL* easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        curl_multi_remove_handle(multi, easy);
+
+        auto it = find_if(transfers.begin(), transfers.end(),
+                          [easy](const Transfer* t) { return t->request.handle() == easy; });
+        if (it == transfers.end()) continue;
+        (*it)->result = result;
+        done.push_back(*it);
+        transfers.erase(it);
+    }
+    for (Transfer* t : done) t->waiter.resume();
+}
+
+/**
+ * curl_multi pide vigilar (o dejar de vigilar) un socket.
+ */
+int EventRuntime::curl_socket_cb(CURL*, curl_socket_t socket, int what, void* userp, void*) {
+    auto* self = static_cast<EventRuntime*>(userp);
+    if (what == CURL_POLL_REMOVE) {
+        self->loop.remove_fd(socket);
+        return 0;
+    }
+    uint32_t events = ((what & CURL_POLL_IN) ? EPOLLIN : 0u) | ((what & CURL_POLL_OUT) ? EPOLLOUT : 0u);
+    if (!self->loop.modify_fd(socket, events)) {
+        self->loop.add_fd(socket, events, [self, socket](uint32_t ready) {
+            int flags = ((ready & EPOLLIN) ? CURL_CSELECT_IN : 0) | ((ready & EPOLLOUT) ? CURL_CSELECT_OUT : 0) |
+                        ((ready & (EPOLLERR | EPOLLHUP)) ? CURL_CSELECT_ERR : 0);
+            self->curl_action(socket, flags);
+        });
+    }
+    return 0;
+}
+
+/**
+ * curl_multi pide un único temporizador (timeout_ms < 0 lo borra).
+ */
+int EventRuntime::curl_timer_cb(CURLM*, long timeout_ms, void* userp) {
+    auto* self = static_cast<EventRuntime*>(userp);
+    if (self->curl_timer) self->loop.cancel_timer(self->curl_timer);
+    self->curl_timer = 0;
+    if (timeout_ms >= 0) {
+        self->curl_timer = self->loop.add_timer(clock::now() + milliseconds(timeout_ms), [self] {
+            self->curl_timer = 0;
+            self->curl_action(CURL_SOCKET_TIMEOUT, 0);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef EVENT_RUNTIME_H
+#define EVENT_RUNTIME_H
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include <opencv2/opencv.hpp>
+#include "coro_executor.h"
+#include "coro_task.h"
+#include "event_loop.h"
+#include "rt_profile.h"
+#include "worker_pool.h"
+#include "threads/barrera.h"
+#include "threads/communicator.h"
+#include "threads/sensor.h"
+
+using namespace std;
+
+struct VehicleEvent;
+
+/**
+ * Clase EventRuntime
+ * Modo de ejecución de un solo hilo (`str_project --event-loop`): todo el
+ * pipeline corre sobre un EventLoop en el hilo que llama a run(), como
+ * corrutinas de un CoroExecutor.
+ *
+ * El recorrido de cada vehículo es una única corrutina que se lee de corrido:
+ * captura (co_await al WorkerPool, de a una por la cámara), envío (co_await a
+ * curl_multi, hasta MAX_UPLOADS a la vez) y actuación de la barrera. El carril
+ * es otra corrutina que espera cada detección del sensor y lanza el recorrido
+ * del vehículo, así que pueden estar en vuelo tantos vehículos como registros
+ * tenga el pool, a costa de un marco de corrutina cada uno.
+ *
+ * - El muestreo del sensor es un temporizador absoluto cada SAMPLE_PERIOD.
+ * - curl_multi tiene sus sockets y su temporizador en el mismo epoll.
+ * - Los plazos de la barrera y de cada captura son temporizadores del loop.
+ * - SIGINT, SIGUSR1 (foto manual) y SIGUSR2 (volcado de traza) llegan por signalfd.
+ *
+ * Solo la captura y codificación de fotos corre en un WorkerPool chico fijado
+ * a los núcleos de OpenCV (STR_LOOP_WORKERS, 1 a 4 hilos; por defecto uno por
+ * núcleo de esa lista), como trabajo Live: OpenCV no expone el
+ * descriptor del dispositivo para vigilarlo con epoll. No hay supervisor: cada
+ * callback se mide contra un presupuesto y los desbordes se cuentan.
+ */
+class EventRuntime {
+public:
+    using clock = chrono::steady_clock;
+
+    EventRuntime(cv::VideoCapture& cam, RtProfile& rt);
+    ~EventRuntime();
+
+    EventRuntime(const EventRuntime&) = delete;
+    EventRuntime& operator=(const EventRuntime&) = delete;
+
+    /**
+     * Corre el pipeline hasta SIGINT.
+     * @param signals Señales que main ya bloqueó (SIGINT y SIGUSR2); se agrega SIGUSR1
+     * @return EXIT_SUCCESS, o EXIT_FAILURE si no se pudo armar el loop
+     */
+    int run(const sigset_t& signals);
+
+    /** Estadísticas del loop y de cada etapa, para comparar con el modo de hilos */
+    void print_report();
+
+private:
+    struct Transfer;
+
+    cv::VideoCapture& cam;
+    RtProfile& rt;
+    EventLoop loop;
+    unique_ptr<WorkerPool> pool;
+    unique_ptr<CoroExecutor> executor;
+    unique_ptr<AsyncSemaphore> camera;            // La cámara es un único dispositivo
+    unique_ptr<AsyncSemaphore> upload_slots;      // Envíos simultáneos al backend
+    unique_ptr<VehicleDetector> detector;
+    unique_ptr<BarrierStation> station;
+    CURLM* multi = nullptr;
+    vector<Transfer*> transfers;                  // Envíos en curso en curl_multi
+    int signal_fd = -1;
+    atomic<bool> stopping{false};
+
+    clock::time_point next_sample{};
+    EventLoop::TimerId curl_timer = 0;
+    EventLoop::TimerId barrier_timer = 0;
+    clock::time_point barrier_timer_at = clock::time_point::max();
+
+    // Contadores del reporte (solo el hilo del loop)
+    uint64_t samples = 0;
+    uint64_t invalid_samples = 0;
+    uint64_t sample_overruns = 0;
+    uint64_t captures = 0;
+    uint64_t capture_overruns = 0;
+    uint64_t uploads_started = 0;
+    uint64_t barrier_faults = 0;
+
+    Task<void> lane();
+    Task<VehicleEvent*> detection();
+    Task<void> vehicle_flow(VehicleEvent* vehicle);
+    Task<bool> capture(VehicleEvent* vehicle, string& filename);
+    Task<void> upload(VehicleEvent* vehicle);
+    Transfer transfer(UploadRequest& request);
+
+    void on_signal();
+    void update_barrier();
+    void curl_action(curl_socket_t socket, int flags);
+    void collect_transfers();
+
+    static int curl_socket_cb(CURL* easy, curl_socket_t socket, int what, void* userp, void* socketp);
+    static int curl_timer_cb(CURLM* multi, long timeout_ms, void* userp);
+};
+
+#endif // EVENT_RUNTIME_H
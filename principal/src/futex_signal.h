@@ -0,0 +1,113 @@
+#ifndef FUTEX_SIGNAL_H
+#define FUTEX_SIGNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Clase FutexSignal
+ * Señal de despertar basada en futex para consumidores bloqueantes.
+ *
+ * Los productores llaman a notify() después de publicar un dato; solo se
+ * hace la llamada al sistema si hay algún consumidor dormido. El consumidor
+ * usa el patrón: `seq = prepare()`, revisar la fuente de datos, y si sigue
+ * vacía `wait(seq)`. Así no se pierde ninguna notificación entre la
+ * revisión y la espera, y no hay mutex que pueda invertir prioridades.
+ */
+class FutexSignal {
+private:
+    atomic<uint32_t> seq{0};       // Se incrementa en cada notificación
+    atomic<uint32_t> waiters{0};   // Consumidores dormidos (o a punto de dormir)
+
+    static long futex(atomic<uint32_t>* addr, int op, uint32_t val, const timespec* ts, uint32_t val3 = 0) {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val, ts, nullptr, val3);
+    }
+
+public:
+    /**
+     * Devuelve la secuencia actual; debe leerse antes de revisar la fuente de datos.
+     */
+    uint32_t prepare() const {
+        return seq.load(memory_order_seq_cst);
+    }
+
+    /**
+     * Despierta a todos los consumidores que esperan sobre esta señal.
+     */
+    void notify() {
+        seq.fetch_add(1, memory_order_seq_cst);
+        if (waiters.load(memory_order_seq_cst) != 0) {
+            futex(&seq, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+        }
+    }
+
+    /**
+     * Duerme mientras la secuencia siga valiendo `expected`.
+     * @param expected Valor obtenido con prepare()
+     */
+    void wait(uint32_t expected) {
+        waiters.fetch_add(1, memory_order_seq_cst);
+        while (seq.load(memory_order_seq_cst) == expected) {
+            futex(&seq, FUTEX_WAIT_PRIVATE, expected, nullptr);
+        }
+        waiters.fetch_sub(1, memory_order_seq_cst);
+    }
+
+    /**
+     * Igual que wait() pero con tiempo máximo de espera.
+     * @param expected Valor obtenido con prepare()
+     * @param timeout Tiempo máximo a dormir
+     * @return true si hubo notificación, false si venció el tiempo
+     */
+    bool wait_for(uint32_t expected, chrono::nanoseconds timeout) {
+        auto deadline = chrono::steady_clock::now() + timeout;
+        waiters.fetch_add(1, memory_order_seq_cst);
+        bool notified = true;
+        while (seq.load(memory_order_seq_cst) == expected) {
+            auto remaining = deadline - chrono::steady_clock::now();
+            if (remaining <= chrono::nanoseconds::zero()) {
+                notified = false;
+                break;
+            }
+            auto ns = chrono::duration_cast<chrono::nanoseconds>(remaining).count();
+            timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+            futex(&seq, FUTEX_WAIT_PRIVATE, expected, &ts);
+        }
+        waiters.fetch_sub(1, memory_order_seq_cst);
+        return notified;
+    }
+
+    /**
+     * Igual que wait() pero hasta un instante absoluto de steady_clock
+     * (CLOCK_MONOTONIC). El kernel despierta en ese instante exacto, sin el
+     * corrimiento de recalcular un tiempo relativo.
+     * @param expected Valor obtenido con prepare()
+     * @param deadline Instante límite
+     * @return true si hubo notificación, false si se alcanzó el instante
+     */
+    bool wait_until(uint32_t expected, chrono::steady_clock::time_point deadline) {
+        auto ns = deadline.time_since_epoch().count();
+        timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+        waiters.fetch_add(1, memory_order_seq_cst);
+        bool notified = true;
+        while (seq.load(memory_order_seq_cst) == expected) {
+            if (chrono::steady_clock::now() >= deadline) {
+                notified = false;
+                break;
+            }
+            futex(&seq, FUTEX_WAIT_BITSET_PRIVATE, expected, &ts, FUTEX_BITSET_MATCH_ANY);
+        }
+        waiters.fetch_sub(1, memory_order_seq_cst);
+        return notified;
+    }
+};
+
+#endif // FUTEX_SIGNAL_H
@@ -0,0 +1,209 @@
+#include "jitter_test.h"
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <curl/curl.h>
+#include <opencv2/opencv.hpp>
+#include "periodic_timer.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+/** Roles que se miden: los de los hilos de trabajo */
+const ThreadRole MEASURED_ROLES[] = {
+    ThreadRole::Sensor, ThreadRole::Barrier, ThreadRole::Camera, ThreadRole::Communicator
+};
+
+/**
+ * Deja al hilo que llama en SCHED_OTHER y sin fijar a ningún núcleo.
+ */
+void run_as_background() {
+    set_background_policy();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int cpus = static_cast<int>(thread::hardware_concurrency());
+    for (int c = 0; c < max(cpus, 1); c++) CPU_SET(c, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * Carga de cámara y/o codificación: captura (o genera) un frame y lo codifica a JPEG sin pausa.
+ */
+void camera_load(const JitterTestOptions& options, atomic<bool>& running, atomic<uint64_t>& frames) {
+    run_as_background();
+    cv::VideoCapture cam;
+    if (options.load_camera) {
+        cam.open(0);
+        if (!cam.isOpened()) cerr << "[JITTER] No se pudo abrir la cámara, se codifican frames sintéticos." << endl;
+        cam.set(cv::CAP_PROP_FRAME_WIDTH, 640);
+        cam.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
+    }
+
+    cv::Mat synthetic(480, 640, CV_8UC3);
+    cv::randu(synthetic, cv::Scalar(0, 0, 0), cv::Scalar(255, 255, 255));
+    vector<unsigned char> jpeg;
+
+    while (running) {
+        cv::Mat frame;
+        if (cam.isOpened()) cam >> frame;
+        if (options.load_encode) cv::imencode(".jpg", frame.empty() ? synthetic : frame, jpeg);
+        frames.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+/**
+ * Carga de red: consultas HTTP consecutivas al backend.
+ */
+void curl_load(const JitterTestOptions& options, atomic<bool>& running, atomic<uint64_t>& requests, atomic<uint64_t>& errors) {
+    run_as_background();
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        cerr << "[JITTER] Error al inicializar cURL, sin carga de red." << endl;
+        return;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, options.curl_url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 2L);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    while (running) {
+        if (curl_easy_perform(curl) != CURLE_OK) {
+            errors.fetch_add(1, memory_order_relaxed);
+            this_thread::sleep_for(milliseconds(100));
+        }
+        requests.fetch_add(1, memory_order_relaxed);
+    }
+    curl_easy_cleanup(curl);
+}
+
+} // namespace
+
+bool parse_jitter_args(int argc, char** argv, JitterTestOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto value_of = [&arg](const char* prefix) -> const char* {
+            size_t n = strlen(prefix);
+            return arg.compare(0, n, prefix) == 0 ? arg.c_str() + n : nullptr;
+        };
+
+        if (arg == "--jitter-test") continue;
+        if (const char* v = value_of("--duration=")) {
+            options.duration = seconds(atol(v));
+        } else if (const char* v = value_of("--interval-us=")) {
+            options.interval = microseconds(atol(v));
+        } else if (const char* v = value_of("--max-latency-us=")) {
+            options.max_latency = microseconds(atol(v));
+        } else if (const char* v = value_of("--url=")) {
+            options.curl_url = v;
+        } else if (const char* v = value_of("--load=")) {
+            stringstream ss(v);
+            string item;
+            while (getline(ss, item, ',')) {
+                if (item == "camera") options.load_camera = true;
+                else if (item == "encode") options.load_encode = true;
+                else if (item == "curl") options.load_curl = true;
+                else {
+                    cerr << "Carga desconocida: " << item << endl;
+                    return false;
+                }
+            }
+        } else {
+            cerr << "Argumento desconocido: " << arg << endl;
+            return false;
+        }
+    }
+    if (options.duration <= seconds::zero() || options.interval <= microseconds::zero()) {
+        cerr << "La duración y el intervalo deben ser positivos." << endl;
+        return false;
+    }
+    return true;
+}
+
+int run_jitter_test(const JitterTestOptions& options, RtProfile& rt, const sigset_t& stop_signals) {
+    constexpr size_t MEASURED = sizeof(MEASURED_ROLES) / sizeof(MEASURED_ROLES[0]);
+    atomic<bool> measuring(true);
+    atomic<bool> loading(true);
+    array<PeriodicStats, MEASURED> stats;
+
+    cout << "[JITTER] Midiendo " << options.duration.count() << " s, intervalo "
+         << options.interval.count() << " us, carga:"
+         << (options.load_camera ? " cámara" : "") << (options.load_encode ? " jpeg" : "")
+         << (options.load_curl ? " curl" : "")
+         << (!options.load_camera && !options.load_encode && !options.load_curl ? " ninguna" : "") << endl;
+
+    // Carga sintética
+    atomic<uint64_t> frames(0), requests(0), request_errors(0);
+    vector<thread> load;
+    if (options.load_camera || options.load_encode) {
+        load.emplace_back(camera_load, cref(options), ref(loading), ref(frames));
+    }
+    if (options.load_curl) {
+        load.emplace_back(curl_load, cref(options), ref(loading), ref(requests), ref(request_errors));
+    }
+
+    // Hilos de medición, uno por rol, todos con el mismo ancla y repartidos en el primer medio período
+    vector<thread> measurers;
+    auto anchor = steady_clock::now() + milliseconds(100);
+    for (size_t i = 0; i < MEASURED; i++) {
+        measurers.emplace_back([&, i]() {
+            rt.apply(MEASURED_ROLES[i]);
+            PeriodicTimer timer(options.interval, options.interval * i / (2 * MEASURED), &stats[i]);
+            timer.start(anchor);
+            while (measuring.load(memory_order_relaxed)) timer.wait_next();
+        });
+    }
+
+    // Los fallos de página se cuentan desde que arranca la medición
+    this_thread::sleep_until(anchor);
+    rt.mark_warm();
+
+    // Espera la duración indicada o una señal de corte
+    auto ns = duration_cast<nanoseconds>(options.duration).count();
+    timespec timeout{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+    if (sigtimedwait(&stop_signals, nullptr, &timeout) > 0) {
+        cout << "\n[JITTER] Medición interrumpida." << endl;
+    }
+
+    measuring = false;
+    for (auto& t : measurers) t.join();
+    loading = false;
+    for (auto& t : load) t.join();
+
+    // Resumen al estilo cyclictest (en microsegundos)
+    auto us = [](double ns) { return ns / 1000.0; };
+    bool passed = true;
+    cout << "[JITTER] Latencia de despertar por hilo (us):" << endl;
+    for (size_t i = 0; i < MEASURED; i++) {
+        size_t r = static_cast<size_t>(MEASURED_ROLES[i]);
+        HistogramSnapshot s = stats[i].jitter.snapshot();
+        cout << "  T:" << i << " " << ROLE_NAMES[r]
+             << " P:" << (rt.enabled ? rt.priority[r] : 0)
+             << " C:" << (rt.enabled && rt.cpu[r] >= 0 ? to_string(rt.cpu[r]) : string("-"))
+             << " n=" << s.count
+             << " Min:" << us(s.min) << " Avg:" << us(s.mean)
+             << " p99:" << us(s.p99) << " p99.9:" << us(s.p999) << " Max:" << us(s.max)
+             << " desbordes=" << stats[i].overruns.load() << endl;
+        if (options.max_latency.count() > 0 &&
+            s.max > static_cast<uint64_t>(duration_cast<nanoseconds>(options.max_latency).count())) {
+            passed = false;
+        }
+    }
+    if (!load.empty()) {
+        cout << "  carga: " << frames.load() << " frames, " << requests.load() << " consultas HTTP ("
+             << request_errors.load() << " con error)" << endl;
+    }
+    rt.print_report();
+
+    if (options.max_latency.count() > 0) {
+        cout << "[JITTER] Veredicto: " << (passed ? "APTO" : "NO APTO") << " (umbral "
+             << options.max_latency.count() << " us)" << endl;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,49 @@
+#ifndef JITTER_TEST_H
+#define JITTER_TEST_H
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include "rt_profile.h"
+
+using namespace std;
+
+/**
+ * Opciones del modo de medición de jitter (`str_project --jitter-test`).
+ */
+struct JitterTestOptions {
+    chrono::seconds duration{60};                // Duración total de la medición
+    chrono::microseconds interval{1000};         // Período de cada hilo de medición
+    bool load_camera = false;                    // Carga sintética: captura de la cámara
+    bool load_encode = false;                    // Carga sintética: codificación JPEG
+    bool load_curl = false;                      // Carga sintética: envíos HTTP al backend
+    string curl_url = "http://192.168.0.103:5000/status";
+    chrono::microseconds max_latency{0};         // Umbral para aprobar el equipo (0 = sin veredicto)
+};
+
+/**
+ * Interpreta los argumentos del modo de medición.
+ * Acepta: --duration=S, --interval-us=N, --load=camera,encode,curl,
+ *         --url=URL, --max-latency-us=N
+ * @return false si algún argumento es inválido (se informa por cerr)
+ */
+bool parse_jitter_args(int argc, char** argv, JitterTestOptions& options);
+
+/**
+ * Medición de latencia de despertar al estilo cyclictest.
+ *
+ * Lanza un hilo de medición por cada rol de hilo de trabajo, con la misma
+ * prioridad y afinidad que le daría el perfil de tiempo real. Cada hilo
+ * duerme hasta instantes absolutos y registra cuánto tarde despierta. En
+ * paralelo puede correr carga sintética (cámara, JPEG, HTTP) en SCHED_OTHER
+ * sobre todos los núcleos, como el tráfico real del sistema.
+ *
+ * Al terminar (por duración o Ctrl+C) imprime un resumen por hilo.
+ * @param options Opciones de la medición
+ * @param rt Perfil de tiempo real ya cargado
+ * @param stop_signals Señales que terminan la medición antes de tiempo
+ * @return EXIT_SUCCESS, o EXIT_FAILURE si algún hilo superó max_latency
+ */
+int run_jitter_test(const JitterTestOptions& options, RtProfile& rt, const sigset_t& stop_signals);
+
+#endif // JITTER_TEST_H
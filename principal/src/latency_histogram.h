@@ -0,0 +1,151 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Resumen de un histograma en un instante dado. Todos los valores en nanosegundos.
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    double mean = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+};
+
+/**
+ * Clase LatencyHistogram
+ * Histograma logarítmico sin locks (estilo HDR) para latencias en nanosegundos.
+ *
+ * Cada potencia de dos se divide en 16 sub-buckets lineales, por lo que el
+ * error relativo de cualquier percentil es a lo sumo 1/16 (6,25 %). Cubre
+ * desde 1 ns hasta ~2^48 ns (más de 3 días); los valores mayores caen en el
+ * último bucket. record() son unas pocas operaciones atómicas relajadas y
+ * puede llamarse desde varios hilos a la vez.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr uint64_t SUB_COUNT = 1u << SUB_BITS;
+    static constexpr size_t BUCKETS = (48 - SUB_BITS + 1) * SUB_COUNT;
+
+private:
+    array<atomic<uint64_t>, BUCKETS> buckets{};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> sum{0};
+    atomic<uint64_t> min_value{UINT64_MAX};
+    atomic<uint64_t> max_value{0};
+
+public:
+    /**
+     * Índice de bucket para un valor.
+     */
+    static size_t bucket_index(uint64_t v) {
+        if (v < SUB_COUNT) return static_cast<size_t>(v);
+        unsigned e = 63 - static_cast<unsigned>(countl_zero(v));      // Potencia de dos del valor
+        uint64_t m = v >> (e - SUB_BITS);                             // 16..31
+        size_t idx = (e - SUB_BITS + 1) * SUB_COUNT + (m - SUB_COUNT);
+        return idx < BUCKETS ? idx : BUCKETS - 1;
+    }
+
+    /**
+     * Mayor valor que cae en un bucket (se reporta el límite superior: conservador para latencias).
+     */
+    static uint64_t bucket_upper(size_t idx) {
+        if (idx < SUB_COUNT) return idx;
+        uint64_t group = idx / SUB_COUNT;
+        uint64_t m = idx % SUB_COUNT + SUB_COUNT;
+        uint64_t width = 1ull << (group - 1);
+        return m * width + width - 1;
+    }
+
+    /**
+     * Registra una muestra.
+     * @param ns Valor en nanosegundos (los negativos se registran como 0)
+     */
+    void record(int64_t ns) {
+        uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+        buckets[bucket_index(v)].fetch_add(1, memory_order_relaxed);
+        total.fetch_add(1, memory_order_relaxed);
+        sum.fetch_add(v, memory_order_relaxed);
+
+        uint64_t cur = max_value.load(memory_order_relaxed);
+        while (v > cur && !max_value.compare_exchange_weak(cur, v, memory_order_relaxed)) {}
+        cur = min_value.load(memory_order_relaxed);
+        while (v < cur && !min_value.compare_exchange_weak(cur, v, memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t max() const { return max_value.load(memory_order_relaxed); }
+    uint64_t sum_ns() const { return sum.load(memory_order_relaxed); }
+
+    /**
+     * Muestras en los buckets cuyo límite superior no pasa de `ns` (para
+     * exportar buckets acumulados, al estilo `le` de Prometheus).
+     */
+    uint64_t count_at_or_below(uint64_t ns) const {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS && bucket_upper(i) <= ns; i++) {
+            seen += buckets[i].load(memory_order_relaxed);
+        }
+        return seen;
+    }
+
+    /**
+     * Valor por debajo del cual cae la fracción `q` de las muestras.
+     * @param q Cuantil entre 0 y 1
+     */
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(q * n);
+        if (target >= n) target = n - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(memory_order_relaxed);
+            if (seen > target) return min(bucket_upper(i), max());
+        }
+        return max();
+    }
+
+    /**
+     * Copia consistente de forma aproximada (las muestras concurrentes pueden
+     * quedar parcialmente incluidas).
+     */
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s;
+        s.count = count();
+        if (s.count == 0) return s;
+        s.min = min_value.load(memory_order_relaxed);
+        s.max = max();
+        s.mean = static_cast<double>(sum.load(memory_order_relaxed)) / s.count;
+        s.p50 = percentile(0.50);
+        s.p90 = percentile(0.90);
+        s.p99 = percentile(0.99);
+        s.p999 = percentile(0.999);
+        return s;
+    }
+
+    /**
+     * Vacía el histograma. No es atómico respecto de record() concurrentes.
+     */
+    void reset() {
+        for (auto& b : buckets) b.store(0, memory_order_relaxed);
+        total.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        min_value.store(UINT64_MAX, memory_order_relaxed);
+        max_value.store(0, memory_order_relaxed);
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,167 @@
+#include "led_engine.h"
+#include <algorithm>
+#include <pigpio.h>
+#include "logger.h"
+#include "rt_profile.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+/** Tramo de un patrón cíclico: nivel durante `length` */
+struct Step {
+    bool on;
+    nanoseconds length;
+};
+
+const Step HEARTBEAT[] = {{true, milliseconds(100)}, {false, milliseconds(100)},
+                          {true, milliseconds(100)}, {false, milliseconds(700)}};
+const Step FAILSAFE[] = {{true, milliseconds(500)}, {false, milliseconds(500)}};
+const milliseconds ERROR_ON(200);        // Destello de un código de error
+const milliseconds ERROR_OFF(300);       // Pausa entre destellos
+const milliseconds ERROR_GAP(1500);      // Pausa entre repeticiones del código
+
+/**
+ * Recorre un ciclo de tramos.
+ */
+bool walk(const Step* steps, size_t count, nanoseconds elapsed, nanoseconds& until_change) {
+    nanoseconds cycle{0};
+    for (size_t i = 0; i < count; i++) cycle += steps[i].length;
+    nanoseconds t = elapsed % cycle;
+    for (size_t i = 0; i < count; i++) {
+        if (t < steps[i].length) {
+            until_change = steps[i].length - t;
+            return steps[i].on;
+        }
+        t -= steps[i].length;
+    }
+    until_change = steps[0].length;
+    return steps[0].on;
+}
+
+} // namespace
+
+LedEngine::~LedEngine() {
+    stop();
+}
+
+void LedEngine::start() {
+    if (running.exchange(true)) return;
+    worker = thread(&LedEngine::run, this);
+}
+
+void LedEngine::stop() {
+    if (!running.exchange(false)) return;
+    wake.notify();
+    if (worker.joinable()) worker.join();
+}
+
+void LedEngine::post(unsigned gpio, LedPattern pattern) {
+    if (gpio >= MAX_GPIO) return;
+    Channel& ch = channels[gpio];
+    uint32_t value = pattern.encode();
+    bool first = !ch.used.load(memory_order_relaxed);
+    if (!first && ch.requested.load(memory_order_relaxed) == value) return;
+    ch.requested.store(value, memory_order_release);
+    if (first) ch.used.store(true, memory_order_release);
+    wake.notify();
+}
+
+LedPattern LedEngine::pattern(unsigned gpio) const {
+    if (gpio >= MAX_GPIO) return LedPattern::off();
+    return LedPattern::decode(channels[gpio].requested.load(memory_order_acquire));
+}
+
+bool LedEngine::level_at(LedPattern pattern, nanoseconds elapsed, nanoseconds& until_change) {
+    until_change = nanoseconds::max();
+    switch (pattern.mode) {
+    case LedMode::Off:
+        return false;
+    case LedMode::Solid:
+        return true;
+    case LedMode::Blink: {
+        if (pattern.param == 0) return true;
+        nanoseconds half(static_cast<int64_t>(1e9 * 100 / pattern.param / 2));
+        Step steps[] = {{true, half}, {false, half}};
+        return walk(steps, 2, elapsed, until_change);
+    }
+    case LedMode::Heartbeat:
+        return walk(HEARTBEAT, size(HEARTBEAT), elapsed, until_change);
+    case LedMode::ErrorCode: {
+        // n destellos (encendido + pausa) y una pausa larga en lugar de la última
+        nanoseconds flash = ERROR_ON + ERROR_OFF;
+        nanoseconds cycle = flash * max<uint16_t>(pattern.param, 1) - ERROR_OFF + ERROR_GAP;
+        nanoseconds t = elapsed % cycle;
+        nanoseconds flashes_end = flash * max<uint16_t>(pattern.param, 1) - ERROR_OFF;
+        if (t >= flashes_end) {
+            until_change = cycle - t;
+            return false;
+        }
+        nanoseconds in_flash = t % flash;
+        if (in_flash < ERROR_ON) {
+            until_change = ERROR_ON - in_flash;
+            return true;
+        }
+        until_change = flash - in_flash;
+        return false;
+    }
+    case LedMode::Failsafe:
+        return walk(FAILSAFE, size(FAILSAFE), elapsed, until_change);
+    }
+    return false;
+}
+
+/**
+ * Muestra en cada LED el patrón publicado en el instante `now`.
+ * @return Próxima transición de cualquier LED (time_point::max() si ninguno cambia)
+ */
+LedEngine::clock::time_point LedEngine::apply(clock::time_point now) {
+    auto next = clock::time_point::max();
+    for (unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+        Channel& ch = channels[gpio];
+        if (!ch.used.load(memory_order_acquire)) continue;
+
+        uint32_t requested = ch.requested.load(memory_order_acquire);
+        if (requested != ch.active) {
+            if (ch.level < 0) gpioSetMode(gpio, PI_OUTPUT);
+            ch.active = requested;
+            ch.anchor = now;
+        }
+        LedPattern pattern = LedPattern::decode(ch.active);
+        auto anchor = pattern.mode == LedMode::Failsafe ? epoch : ch.anchor;
+
+        nanoseconds until_change;
+        int level = level_at(pattern, now - anchor, until_change) ? 1 : 0;
+        if (level != ch.level) {
+            gpioWrite(gpio, static_cast<unsigned>(level));
+            ch.level = level;
+        }
+        if (until_change != nanoseconds::max()) next = min(next, now + until_change);
+    }
+    return next;
+}
+
+/**
+ * Hilo del motor: aplica los patrones publicados y duerme hasta la próxima
+ * transición de cualquier LED o hasta el próximo post().
+ */
+void LedEngine::run() {
+    set_background_policy();
+    Logger::instance().set_thread_name("leds");
+
+    while (running.load(memory_order_acquire)) {
+        uint32_t seq = wake.prepare();
+        auto next = apply(clock::now());
+
+        if (!running.load(memory_order_acquire)) break;
+        if (next == clock::time_point::max()) {
+            wake.wait(seq);
+        } else {
+            wake.wait_until(seq, next);
+        }
+    }
+
+    // Un post() justo antes de stop() pudo llegar después de la última pasada
+    apply(clock::now());
+}
@@ -0,0 +1,108 @@
+#ifndef LED_ENGINE_H
+#define LED_ENGINE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "futex_signal.h"
+
+using namespace std;
+
+/** Tipo de patrón de un LED */
+enum class LedMode : uint8_t {
+    Off,
+    Solid,
+    Blink,         // Parpadeo simétrico a `param` centésimas de Hz
+    Heartbeat,     // Doble pulso corto por segundo ("sistema vivo")
+    ErrorCode,     // `param` destellos y una pausa larga, repetido
+    Failsafe       // 1 Hz en fase con todos los LEDs en failsafe
+};
+
+/**
+ * Patrón declarativo de un LED. Entra en 32 bits para publicarse con un
+ * único atómico.
+ */
+struct LedPattern {
+    LedMode mode = LedMode::Off;
+    uint16_t param = 0;
+
+    static constexpr LedPattern off() { return {LedMode::Off, 0}; }
+    static constexpr LedPattern solid() { return {LedMode::Solid, 0}; }
+    static constexpr LedPattern blink(double hz) { return {LedMode::Blink, static_cast<uint16_t>(hz * 100)}; }
+    static constexpr LedPattern heartbeat() { return {LedMode::Heartbeat, 0}; }
+    static constexpr LedPattern error_code(uint16_t flashes) { return {LedMode::ErrorCode, flashes}; }
+    static constexpr LedPattern failsafe() { return {LedMode::Failsafe, 0}; }
+
+    uint32_t encode() const { return (uint32_t(mode) << 16) | param; }
+    static LedPattern decode(uint32_t v) { return {static_cast<LedMode>(v >> 16), static_cast<uint16_t>(v & 0xFFFF)}; }
+    bool operator==(const LedPattern&) const = default;
+};
+
+/**
+ * Clase LedEngine
+ * Motor de patrones de los LEDs de señalización. Un único hilo SCHED_OTHER
+ * escribe todos los GPIO y duerme hasta la próxima transición de cualquier
+ * LED; post() solo publica un atómico y despierta al motor, así que lo puede
+ * llamar cualquier hilo (incluso los de tiempo real) sin bloquearse.
+ *
+ * Publicar el patrón vigente no tiene efecto (no reinicia su fase); uno
+ * distinto arranca desde su comienzo. Las ondas de pigpio las usa el servo de
+ * la barrera, por eso los LEDs se manejan con gpioWrite desde este hilo.
+ */
+class LedEngine {
+public:
+    using clock = chrono::steady_clock;
+    static constexpr unsigned MAX_GPIO = 32;
+
+    LedEngine() = default;
+    ~LedEngine();
+
+    LedEngine(const LedEngine&) = delete;
+    LedEngine& operator=(const LedEngine&) = delete;
+
+    /** Inicia el hilo del motor (pigpio ya debe estar inicializado) */
+    void start();
+
+    /**
+     * Detiene el hilo después de aplicar los últimos patrones publicados, que
+     * quedan fijos en el nivel de ese instante: quien apaga publica off() antes.
+     */
+    void stop();
+
+    /**
+     * Cambia el patrón de un LED sin bloquear.
+     * @param gpio Pin del LED (0-31)
+     */
+    void post(unsigned gpio, LedPattern pattern);
+
+    /** Patrón publicado para un LED */
+    LedPattern pattern(unsigned gpio) const;
+
+    /**
+     * Nivel del patrón `pattern` a `elapsed` de su inicio y tiempo hasta el próximo cambio.
+     * @param until_change Tiempo hasta la próxima transición (nanoseconds::max() si no cambia más)
+     */
+    static bool level_at(LedPattern pattern, chrono::nanoseconds elapsed, chrono::nanoseconds& until_change);
+
+private:
+    struct Channel {
+        atomic<uint32_t> requested{0};        // LedPattern::encode() publicado por post()
+        atomic<bool> used{false};
+        uint32_t active = UINT32_MAX;         // Patrón que está mostrando el motor (solo el hilo del motor)
+        clock::time_point anchor{};           // Inicio del patrón activo
+        int level = -1;                       // Último nivel escrito (-1 = ninguno)
+    };
+
+    array<Channel, MAX_GPIO> channels;
+    clock::time_point epoch = clock::now();   // Fase común de Failsafe
+    atomic<bool> running{false};
+    FutexSignal wake;
+    thread worker;
+
+    clock::time_point apply(clock::time_point now);
+    void run();
+};
+
+#endif // LED_ENGINE_H
@@ -0,0 +1,315 @@
+#include "logger.h"
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include "rt_profile.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+const char* LEVEL_NAMES[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+
+/** Tamaño de cada buffer de salida del escritor */
+constexpr size_t OUT_SIZE = 16384;
+
+/** Largo máximo de una línea formateada */
+constexpr size_t LINE_SIZE = 512;
+
+/**
+ * Escribe todo el buffer en el descriptor, reintentando escrituras parciales.
+ */
+void write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) return;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+LogLevel level_from_env() {
+    const char* value = getenv("STR_LOG_LEVEL");
+    if (!value) return LogLevel::Info;
+    string v = value;
+    if (v == "debug") return LogLevel::Debug;
+    if (v == "warn") return LogLevel::Warn;
+    if (v == "error") return LogLevel::Error;
+    return LogLevel::Info;
+}
+
+} // namespace
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() {
+    min_level.store(level_from_env(), memory_order_relaxed);
+    wall_offset_ns = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count()
+                     - steady_clock::now().time_since_epoch().count();
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+/**
+ * Inicia el hilo escritor. Conviene llamarlo desde main antes de crear los
+ * hilos de tiempo real: el escritor hereda la afinidad de quien lo crea.
+ */
+void Logger::start() {
+    if (running.exchange(true)) return;
+    writer = thread(&Logger::writer_loop, this);
+}
+
+/**
+ * Escribe lo pendiente y detiene el hilo escritor. Los mensajes posteriores
+ * se escriben en forma sincrónica.
+ */
+void Logger::stop() {
+    if (!running.exchange(false)) return;
+    wake.notify();
+    if (writer.joinable()) writer.join();
+}
+
+void Logger::set_thread_name(const char* name) {
+    if (Producer* producer = current_producer()) {
+        snprintf(producer->name, NAME_SIZE, "%s", name);
+    }
+}
+
+Logger::Registration::~Registration() {
+    if (producer) producer->alive.store(false, memory_order_release);
+}
+
+/**
+ * Devuelve (asignándolo la primera vez) el buffer del hilo que llama.
+ * @return nullptr si no quedan buffers libres.
+ */
+Logger::Producer* Logger::current_producer() {
+    thread_local Registration registration;
+    if (registration.producer || registration.attempted) return registration.producer;
+
+    registration.attempted = true;
+    for (size_t i = 0; i < MAX_PRODUCERS; i++) {
+        Producer& p = producers[i];
+        bool expected = false;
+        if (p.claimed.load(memory_order_relaxed) ||
+            !p.claimed.compare_exchange_strong(expected, true, memory_order_acq_rel)) continue;
+        snprintf(p.name, NAME_SIZE, "hilo-%zu", i);
+        p.alive.store(true, memory_order_release);
+        registration.producer = &p;
+        return &p;
+    }
+    return nullptr;
+}
+
+/**
+ * Límite de mensajes por línea de código: como mucho `site_limit` por segundo.
+ * @param suppressed Mensajes descartados antes de este, a informar con él
+ * @return false si el mensaje debe descartarse
+ */
+bool Logger::admit(LogSite& site, int64_t now, uint32_t& suppressed) {
+    constexpr int64_t WINDOW_NS = 1000000000;
+    int64_t start = site.window_start_ns.load(memory_order_relaxed);
+    if (now - start >= WINDOW_NS &&
+        site.window_start_ns.compare_exchange_strong(start, now, memory_order_relaxed)) {
+        site.in_window.store(0, memory_order_relaxed);
+    }
+    if (site.in_window.fetch_add(1, memory_order_relaxed) >= site_limit.load(memory_order_relaxed)) {
+        site.suppressed.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    if (site.suppressed.load(memory_order_relaxed) != 0) {
+        suppressed = site.suppressed.exchange(0, memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * Camino lento: formatea y escribe en el momento (sin escritor o sin buffer libre).
+ */
+void Logger::write_now(const LogRecord& record, const Producer* producer) {
+    char line[LINE_SIZE];
+    size_t n = format(record, producer ? producer->name : "-", line, sizeof(line));
+    write_all(record.level >= LogLevel::Warn ? STDERR_FILENO : STDOUT_FILENO, line, n);
+}
+
+/**
+ * Hilo escritor: corre en SCHED_OTHER, despierta cada 20 ms (o enseguida ante
+ * un WARN/ERROR) y vuelca todos los buffers.
+ */
+void Logger::writer_loop() {
+    set_background_policy();
+
+    while (running.load(memory_order_acquire)) {
+        uint32_t seq = wake.prepare();
+        if (drain()) continue;
+        wake.wait_for(seq, milliseconds(20));
+    }
+    drain();
+}
+
+/**
+ * Vuelca los registros de todos los hilos en orden de timestamp y libera los
+ * buffers de hilos que ya terminaron.
+ * @return true si se escribió algo
+ */
+bool Logger::drain() {
+    static char out[OUT_SIZE];
+    static char err[OUT_SIZE];
+    static uint64_t reported_drops = 0;
+    size_t out_used = 0, err_used = 0;
+    bool wrote = false;
+
+    for (;;) {
+        // Mezcla por timestamp: el registro más antiguo entre los frentes de todos los buffers
+        Producer* oldest = nullptr;
+        const LogRecord* record = nullptr;
+        for (auto& p : producers) {
+            if (!p.claimed.load(memory_order_acquire)) continue;
+            const LogRecord* front = p.ring.front();
+            if (front && (!record || front->ts_ns < record->ts_ns)) {
+                record = front;
+                oldest = &p;
+            }
+        }
+        if (!record) break;
+
+        bool is_err = record->level >= LogLevel::Warn;
+        char* buf = is_err ? err : out;
+        size_t& used = is_err ? err_used : out_used;
+        if (OUT_SIZE - used < LINE_SIZE) {
+            write_all(is_err ? STDERR_FILENO : STDOUT_FILENO, buf, used);
+            used = 0;
+        }
+        used += format(*record, oldest->name, buf + used, LINE_SIZE);
+        oldest->ring.consume();
+        wrote = true;
+    }
+
+    uint64_t total_drops = drops.load(memory_order_relaxed);
+    if (total_drops != reported_drops) {
+        // Como con cada registro: se vacía antes si no queda lugar para una línea
+        if (OUT_SIZE - err_used < LINE_SIZE) {
+            write_all(STDERR_FILENO, err, err_used);
+            err_used = 0;
+        }
+        int n = snprintf(err + err_used, OUT_SIZE - err_used,
+                         "[log] %llu mensajes descartados por buffer lleno\n",
+                         static_cast<unsigned long long>(total_drops - reported_drops));
+        if (n > 0) err_used += min(static_cast<size_t>(n), OUT_SIZE - err_used - 1);
+        reported_drops = total_drops;
+    }
+    if (out_used) write_all(STDOUT_FILENO, out, out_used);
+    if (err_used) write_all(STDERR_FILENO, err, err_used);
+
+    // Un hilo terminado libera su buffer una vez vaciado
+    for (auto& p : producers) {
+        if (p.claimed.load(memory_order_acquire) && !p.alive.load(memory_order_acquire) && !p.ring.front()) {
+            p.claimed.store(false, memory_order_release);
+        }
+    }
+    return wrote;
+}
+
+/**
+ * Formatea un registro como "HH:MM:SS.mmm NIVEL [hilo] mensaje\n".
+ * Interpreta el formato printf argumento por argumento según el tipo guardado.
+ * @return Bytes escritos en `out` (sin contar el terminador)
+ */
+size_t Logger::format(const LogRecord& record, const char* thread_name, char* out, size_t cap) const {
+    auto clamp = [cap](size_t n, int w) { return w < 0 ? n : min(n + static_cast<size_t>(w), cap - 2); };
+
+    int64_t wall = record.ts_ns + wall_offset_ns;
+    time_t secs = static_cast<time_t>(wall / 1000000000);
+    tm local{};
+    localtime_r(&secs, &local);
+    size_t n = clamp(0, snprintf(out, cap, "%02d:%02d:%02d.%03d %s [%s] ", local.tm_hour, local.tm_min,
+                                 local.tm_sec, static_cast<int>(wall / 1000000 % 1000),
+                                 LEVEL_NAMES[static_cast<int>(record.level)], thread_name));
+
+    auto as_int = [&record](size_t i) -> long long {
+        if (record.types[i] == LogRecord::F64) {
+            double d;
+            memcpy(&d, &record.args[i], sizeof(d));
+            return static_cast<long long>(d);
+        }
+        return static_cast<long long>(record.args[i]);
+    };
+    auto as_double = [&record](size_t i) -> double {
+        double d;
+        switch (record.types[i]) {
+            case LogRecord::F64: memcpy(&d, &record.args[i], sizeof(d)); return d;
+            case LogRecord::I64: return static_cast<double>(static_cast<int64_t>(record.args[i]));
+            default: return static_cast<double>(record.args[i]);
+        }
+    };
+
+    const char* p = record.fmt;
+    size_t arg = 0;
+    while (*p && n < cap - 2) {
+        if (*p != '%') {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Especificador: se conservan banderas, ancho y precisión; el largo se decide por el tipo guardado
+        char spec[32];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && s < 20) spec[s++] = *p++;
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        char conv = *p;
+        if (!conv) break;
+        p++;
+
+        int w;
+        if (arg >= record.nargs) {
+            w = snprintf(out + n, cap - n, "?");
+        } else if (strchr("diuxXo", conv)) {
+            spec[s++] = 'l';
+            spec[s++] = 'l';
+            spec[s++] = conv;
+            spec[s] = '\0';
+            w = snprintf(out + n, cap - n, spec, as_int(arg));
+        } else if (conv == 'c') {
+            spec[s++] = 'c';
+            spec[s] = '\0';
+            w = snprintf(out + n, cap - n, spec, static_cast<int>(as_int(arg)));
+        } else if (strchr("fFeEgGaA", conv)) {
+            spec[s++] = conv;
+            spec[s] = '\0';
+            w = snprintf(out + n, cap - n, spec, as_double(arg));
+        } else if (conv == 's') {
+            spec[s++] = 's';
+            spec[s] = '\0';
+            const char* str = "?";
+            if (record.types[arg] == LogRecord::STR) {
+                str = record.args[arg] < LogRecord::TEXT_SIZE ? record.text + record.args[arg] : "";
+            }
+            w = snprintf(out + n, cap - n, spec, str);
+        } else if (conv == 'p') {
+            w = snprintf(out + n, cap - n, "%p", reinterpret_cast<void*>(record.args[arg]));
+        } else {
+            w = snprintf(out + n, cap - n, "%%%c", conv);
+            arg--;
+        }
+        arg++;
+        n = clamp(n, w);
+    }
+
+    if (record.suppressed) {
+        n = clamp(n, snprintf(out + n, cap - n, " (+%u repetidos suprimidos)", record.suppressed));
+    }
+    out[n++] = '\n';
+    return n;
+}
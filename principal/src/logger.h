@@ -0,0 +1,225 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include "futex_signal.h"
+#include "ring_buffer.h"
+
+using namespace std;
+
+/**
+ * Niveles de log, de menor a mayor severidad.
+ */
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error };
+
+/**
+ * Estado por línea de código que loguea, para limitar mensajes repetitivos.
+ * Lo declara la macro LOG_* como variable estática local.
+ */
+struct LogSite {
+    atomic<int64_t> window_start_ns{0};   // Inicio de la ventana de conteo actual
+    atomic<uint32_t> in_window{0};        // Mensajes emitidos en la ventana
+    atomic<uint32_t> suppressed{0};       // Mensajes descartados desde el último emitido
+};
+
+/**
+ * Registro binario de tamaño fijo. Los argumentos se guardan sin formatear;
+ * las cadenas se copian (truncadas) al buffer `text`.
+ */
+struct LogRecord {
+    static constexpr size_t MAX_ARGS = 8;
+    static constexpr size_t TEXT_SIZE = 112;
+
+    enum ArgType : uint8_t { I64, U64, F64, STR, PTR };
+
+    int64_t ts_ns = 0;                    // steady_clock
+    const char* fmt = nullptr;            // Formato printf (debe ser un literal)
+    uint32_t suppressed = 0;              // Repeticiones suprimidas antes de este mensaje
+    LogLevel level = LogLevel::Info;
+    uint8_t nargs = 0;
+    uint8_t text_used = 0;
+    array<ArgType, MAX_ARGS> types{};
+    array<uint64_t, MAX_ARGS> args{};
+    char text[TEXT_SIZE];
+};
+
+/**
+ * Clase Logger
+ * Logger asíncrono: cada hilo escribe registros binarios en su propio
+ * SpscRing, sin locks ni llamadas al sistema, y un hilo de baja prioridad los
+ * formatea y los escribe en lote. Reemplaza a cout/cerr en los hilos de
+ * tiempo real, donde un flush a la consola serie o a journald puede frenar
+ * varios milisegundos.
+ *
+ * - Filtrado por nivel (STR_LOG_LEVEL=debug|info|warn|error).
+ * - Límite por línea de código: más de `site_limit` mensajes por segundo se
+ *   suprimen y el siguiente mensaje emitido informa cuántos se perdieron.
+ * - Si el buffer del hilo está lleno el mensaje se descarta y se cuenta;
+ *   nunca se bloquea al hilo que loguea.
+ * - Antes de start() y después de stop() se escribe en forma sincrónica.
+ *
+ * Se usa a través de las macros LOG_DEBUG/LOG_INFO/LOG_WARN/LOG_ERROR, que
+ * además hacen que el compilador verifique el formato contra los argumentos.
+ * Las cadenas se pasan como `const char*` (por ejemplo, `s.c_str()`).
+ */
+class Logger {
+public:
+    static constexpr size_t MAX_PRODUCERS = 32;
+    static constexpr size_t RING_SIZE = 128;
+    static constexpr size_t NAME_SIZE = 16;
+
+    static Logger& instance();
+
+    void start();
+    void stop();
+
+    void set_level(LogLevel level) { min_level.store(level, memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= min_level.load(memory_order_relaxed); }
+    void set_site_limit(uint32_t per_second) { site_limit.store(per_second, memory_order_relaxed); }
+
+    /**
+     * Nombre del hilo que llama, mostrado en cada línea (hasta 15 caracteres).
+     */
+    void set_thread_name(const char* name);
+
+    uint64_t dropped() const { return drops.load(memory_order_relaxed); }
+
+    /**
+     * Encola un mensaje. Ver las macros LOG_*.
+     */
+    template <typename... Args>
+    void log(LogSite& site, LogLevel level, const char* fmt, const Args&... args) {
+        int64_t now = chrono::steady_clock::now().time_since_epoch().count();
+        uint32_t suppressed = 0;
+        if (!admit(site, now, suppressed)) return;
+
+        Producer* producer = current_producer();
+        if (!producer || !running.load(memory_order_acquire)) {
+            LogRecord record;
+            fill(record, now, level, fmt, suppressed, args...);
+            write_now(record, producer);
+            return;
+        }
+
+        LogRecord* record = producer->ring.try_claim();
+        if (!record) {
+            drops.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        fill(*record, now, level, fmt, suppressed, args...);
+        producer->ring.commit();
+
+        // Los errores se escriben enseguida; el resto espera la próxima pasada del escritor
+        if (level >= LogLevel::Warn) wake.notify();
+    }
+
+private:
+    struct Producer {
+        SpscRing<LogRecord, RING_SIZE> ring;
+        atomic<bool> claimed{false};      // Slot asignado a un hilo
+        atomic<bool> alive{false};        // El hilo dueño sigue vivo
+        char name[NAME_SIZE] = {};
+    };
+
+    array<Producer, MAX_PRODUCERS> producers;
+    atomic<LogLevel> min_level{LogLevel::Info};
+    atomic<uint32_t> site_limit{20};
+    atomic<uint64_t> drops{0};
+    atomic<bool> running{false};
+    FutexSignal wake;
+    thread writer;
+    int64_t wall_offset_ns = 0;           // system_clock - steady_clock, para mostrar la hora
+
+    /** Slot del hilo actual; se libera cuando el hilo termina */
+    struct Registration {
+        Producer* producer = nullptr;
+        bool attempted = false;
+        ~Registration();
+    };
+
+    Logger();
+    ~Logger();
+
+    Producer* current_producer();
+    bool admit(LogSite& site, int64_t now, uint32_t& suppressed);
+    void write_now(const LogRecord& record, const Producer* producer);
+    void writer_loop();
+    bool drain();
+    size_t format(const LogRecord& record, const char* thread_name, char* out, size_t cap) const;
+
+    template <typename T>
+    static void put_arg(LogRecord& record, const T& value) {
+        if (record.nargs >= LogRecord::MAX_ARGS) return;
+        size_t i = record.nargs++;
+        using D = decay_t<T>;
+        if constexpr (is_same_v<D, bool> || (is_integral_v<D> && is_signed_v<D>) || is_enum_v<D>) {
+            record.types[i] = LogRecord::I64;
+            record.args[i] = static_cast<uint64_t>(static_cast<int64_t>(value));
+        } else if constexpr (is_integral_v<D>) {
+            record.types[i] = LogRecord::U64;
+            record.args[i] = static_cast<uint64_t>(value);
+        } else if constexpr (is_floating_point_v<D>) {
+            double d = static_cast<double>(value);
+            record.types[i] = LogRecord::F64;
+            memcpy(&record.args[i], &d, sizeof(d));
+        } else if constexpr (is_convertible_v<const T&, const char*>) {
+            const char* s = static_cast<const char*>(value);
+            if (!s) s = "(null)";
+            size_t room = LogRecord::TEXT_SIZE - record.text_used;
+            size_t len = room ? strnlen(s, room - 1) : 0;
+            record.types[i] = LogRecord::STR;
+            record.args[i] = record.text_used;
+            if (room) {
+                memcpy(record.text + record.text_used, s, len);
+                record.text[record.text_used + len] = '\0';
+                record.text_used = static_cast<uint8_t>(record.text_used + len + 1);
+            } else {
+                record.args[i] = LogRecord::TEXT_SIZE;   // Sin lugar: se muestra vacía
+            }
+        } else {
+            static_assert(is_pointer_v<D>, "Tipo de argumento de log no soportado (usar .c_str() para strings)");
+            record.types[i] = LogRecord::PTR;
+            record.args[i] = reinterpret_cast<uint64_t>(value);
+        }
+    }
+
+    template <typename... Args>
+    static void fill(LogRecord& record, int64_t now, LogLevel level, const char* fmt,
+                     uint32_t suppressed, const Args&... args) {
+        record.ts_ns = now;
+        record.fmt = fmt;
+        record.level = level;
+        record.suppressed = suppressed;
+        record.nargs = 0;
+        record.text_used = 0;
+        (put_arg(record, args), ...);
+    }
+};
+
+/**
+ * Macro base de log. El `if (false) printf(...)` no genera código: solo
+ * pide al compilador que valide el formato contra los argumentos.
+ */
+#define LOG_AT(level, fmt, ...)                                                        \
+    do {                                                                               \
+        if (Logger::instance().enabled(level)) {                                       \
+            static LogSite log_site_;                                                  \
+            Logger::instance().log(log_site_, level, fmt __VA_OPT__(,) __VA_ARGS__);   \
+        }                                                                              \
+        if (false) printf(fmt __VA_OPT__(,) __VA_ARGS__);                              \
+    } while (0)
+
+#define LOG_DEBUG(fmt, ...) LOG_AT(LogLevel::Debug, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LogLevel::Info, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LogLevel::Warn, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LogLevel::Error, fmt __VA_OPT__(,) __VA_ARGS__)
+
+#endif // LOGGER_H
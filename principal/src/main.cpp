@@ -17,9 +17,27 @@
 #include "threads/communicator.h"
 #include "threads/barrera.h"
 #include "shared_data.h"
+#include "rt_profile.h"
+#include "jitter_test.h"
+#include "logger.h"
+#include "tracer.h"
+#include "metrics.h"
+#include "shm_stats.h"
+#include "led_engine.h"
+#include "event_runtime.h"
 
-pthread_barrier_t barrier;
-SharedQueue sharedQueue;
+// Registros de vehículo preasignados y canales entre etapas del pipeline:
+// sensor -> cámara -> comunicador -> barrera
+VehiclePool vehiclePool;
+TriggerChannel triggerChannel;
+PhotoChannel photoChannel;
+DecisionChannel decisionChannel;
+
+// Contadores e histogramas que actualizan los hilos de trabajo
+PipelineMetrics pipelineMetrics;
+
+// Patrones de los LEDs de señalización (cualquier hilo publica sin bloquearse)
+LedEngine leds;
 
 using namespace cv;
 using namespace std;
@@ -30,7 +48,6 @@ const int SENSOR_THREAD = 1;
 const int CAMERA_THREAD = 2;
 const int COMMUNICATOR_THREAD = 3;
 const int BARRIER_THREAD = 4;
-const int NUM_THREADS = 4;
 const int LED_RED = 27;
 const int LED_GREEN = 17;
 const int BARRIER_PIN = 18;
@@ -40,13 +57,8 @@ const int ECHO_PIN = 24;
 atomic<bool> system_running(true);
 ThreadSupervisor* global_supervisor_ptr = nullptr;
 
-void setThreadPriority(thread &t, int priority) {
-    sched_param sch_params;
-    sch_params.sched_priority = priority;
-    if (pthread_setschedparam(t.native_handle(), SCHED_FIFO, &sch_params)) {
-        cerr << "Error al asignar prioridad" << endl;
-    }
-}
+// Prioridades, afinidad y memoria bloqueada (se activa con STR_RT=1)
+RtProfile rt_profile;
 
 // Signal handler para Ctrl+C
 void handle_sigint(int signum) {
@@ -58,49 +70,259 @@ void handle_sigint(int signum) {
         global_supervisor_ptr->shutdown_all();
     }
 
-    gpioWrite(LED_RED, 0);
-    gpioWrite(LED_GREEN, 0);
+    leds.post(LED_RED, LedPattern::off());
+    leds.post(LED_GREEN, LedPattern::off());
+    gpioWaveTxStop();   // El servo de la barrera se mueve con ondas de pigpio
     gpioServo(BARRIER_PIN, 0);
     
     cout << "✅ Señal de apagado enviada. Esperando que terminen los threads...\n";
 }
 
-void enter_failsafe_state(const string &reason, ThreadSupervisor &supervisor) {
-    cerr << "[FAILSAFE] " << reason << endl;
+/**
+ * Nombre del hilo actual en los logs y en la traza.
+ */
+void name_thread(const char* name) {
+    Logger::instance().set_thread_name(name);
+    Tracer::instance().set_thread_name(name);
+}
+
+/**
+ * Arma la respuesta del endpoint de métricas: contadores del pipeline,
+ * profundidad de las colas y estadísticas del supervisor (si lo hay; el modo
+ * event loop corre sin él).
+ */
+void render_metrics(MetricsWriter& m, ThreadSupervisor* supervisor) {
+    const auto latency_bounds = {0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 5.0, 10.0};
+
+    m.counter("str_vehicles_detected_total", "Vehiculos detectados por el sensor.", pipelineMetrics.vehicles_detected.value());
+    m.counter("str_photos_captured_total", "Fotos guardadas por la camara.", pipelineMetrics.photos_captured.value());
+    m.counter("str_camera_frame_drops_total", "Frames vacios o capturas fallidas.", pipelineMetrics.camera_frame_drops.value());
+    m.counter("str_events_dropped_total", "Vehiculos perdidos por pool agotado o canal lleno.", pipelineMetrics.events_dropped.value());
+    m.counter("str_uploads_failed_total", "Consultas al backend sin decision.", pipelineMetrics.uploads_failed.value());
+    m.header("str_decisions_total", "Decisiones de acceso recibidas.", "counter");
+    m.sample("str_decisions_total", static_cast<double>(pipelineMetrics.decisions_granted.value()), "result=\"granted\"");
+    m.sample("str_decisions_total", static_cast<double>(pipelineMetrics.decisions_denied.value()), "result=\"denied\"");
+    m.histogram("str_upload_latency_seconds", "Duracion del envio de la foto al backend.",
+                pipelineMetrics.upload_latency, latency_bounds);
+    m.histogram("str_decision_latency_seconds", "Tiempo desde el disparo hasta conocer la decision.",
+                pipelineMetrics.decision_latency, latency_bounds);
+    const auto setup_bounds = {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 1.0};
+    m.histogram("str_upload_setup_warm_seconds", "Preparacion y conexion de un envio con conexion precalentada.",
+                pipelineMetrics.upload_setup_warm, setup_bounds);
+    m.histogram("str_upload_setup_cold_seconds", "Preparacion y conexion de un envio en frio.",
+                pipelineMetrics.upload_setup_cold, setup_bounds);
+    m.counter("str_connection_warmups_total", "Conexiones al backend precalentadas al detectar un vehiculo.",
+              pipelineMetrics.connection_warmups.value());
+    m.counter("str_connection_expired_total", "Conexiones precalentadas descartadas sin foto.",
+              pipelineMetrics.connection_expired.value());
+
+    QueueStats photos = photoChannel.stats();
+    m.header("str_queue_depth", "Eventos en espera en cada canal del pipeline.", "gauge");
+    m.sample("str_queue_depth", static_cast<double>(triggerChannel.depth()), "queue=\"trigger\"");
+    m.sample("str_queue_depth", static_cast<double>(photos.live_depth), "queue=\"photo\"");
+    m.sample("str_queue_depth", static_cast<double>(photos.background_depth), "queue=\"photo_audit\"");
+    m.sample("str_queue_depth", static_cast<double>(decisionChannel.depth()), "queue=\"decision\"");
+    m.counter("str_photo_queue_dropped_total", "Fotos descartadas por la cola de plazos.", photos.dropped);
+    m.gauge("str_vehicle_pool_in_use", "Registros de vehiculo en uso.", vehiclePool.used());
+
+    if (supervisor) {
+        vector<ThreadTimingStats> threads = supervisor->timing_stats();
+        auto per_thread = [&m, &threads](const char* name, const char* help, const char* type, auto value) {
+            m.header(name, help, type);
+            for (const auto& st : threads) {
+                m.sample(name, static_cast<double>(value(st)), "thread=\"" + to_string(st.thread_id) + "\"");
+            }
+        };
+        per_thread("str_supervisor_timeouts_total", "Plazos incumplidos detectados por el supervisor.", "counter",
+                   [](const ThreadTimingStats& st) { return st.timeouts; });
+        per_thread("str_supervisor_recoveries_total", "Recuperaciones ejecutadas.", "counter",
+                   [](const ThreadTimingStats& st) { return st.recoveries; });
+        per_thread("str_supervisor_restarts_total", "Reinicios de hilos colgados.", "counter",
+                   [](const ThreadTimingStats& st) { return st.restarts; });
+        per_thread("str_supervisor_budget_seconds", "Presupuesto vigente por iteracion.", "gauge",
+                   [](const ThreadTimingStats& st) { return st.current_budget_ns / 1e9; });
+    }
+
+    m.counter("str_log_dropped_total", "Mensajes de log descartados por buffer lleno.", Logger::instance().dropped());
+    m.counter("str_trace_dumps_total", "Volcados de traza escritos.", Tracer::instance().dumps());
+}
+
+/**
+ * Arma el estado publicado en memoria compartida para strctl.
+ */
+void fill_stats(StatsPayload& s, ThreadSupervisor* supervisor) {
+    auto latency = [](const LatencyHistogram& h) {
+        HistogramSnapshot snap = h.snapshot();
+        return LatencySnapshot{snap.count, snap.p50, snap.p99, snap.max};
+    };
+
+    s.lane_count = 1;
+    for (size_t i = 0; i < s.lane_count; i++) {
+        const LaneStatus& lane = pipelineMetrics.lanes[i];
+        s.lanes[i].occupied = lane.occupied.load(memory_order_relaxed);
+        s.lanes[i].barrier = lane.barrier.load(memory_order_relaxed);
+        s.lanes[i].last_distance_mm = lane.last_distance_mm.load(memory_order_relaxed);
+        s.lanes[i].last_measure_ns = lane.last_measure_ns.load(memory_order_relaxed);
+        s.lanes[i].last_vehicle_id = lane.last_vehicle_id.load(memory_order_relaxed);
+    }
+
+    QueueStats photos = photoChannel.stats();
+    s.trigger_depth = static_cast<uint32_t>(triggerChannel.depth());
+    s.photo_depth = static_cast<uint32_t>(photos.live_depth);
+    s.audit_depth = static_cast<uint32_t>(photos.background_depth);
+    s.decision_depth = static_cast<uint32_t>(decisionChannel.depth());
+    s.pool_in_use = vehiclePool.used();
+
+    s.vehicles_detected = pipelineMetrics.vehicles_detected.value();
+    s.photos_captured = pipelineMetrics.photos_captured.value();
+    s.frame_drops = pipelineMetrics.camera_frame_drops.value();
+    s.events_dropped = pipelineMetrics.events_dropped.value();
+    s.uploads_failed = pipelineMetrics.uploads_failed.value();
+    s.upload_latency = latency(pipelineMetrics.upload_latency);
+    s.decision_latency = latency(pipelineMetrics.decision_latency);
+
+    if (!supervisor) return;
+    for (const auto& st : supervisor->timing_stats()) {
+        if (s.slot_count >= STATS_MAX_SLOTS) break;
+        SlotSnapshot& slot = s.slots[s.slot_count++];
+        slot.thread_id = st.thread_id;
+        slot.in_iteration = st.in_iteration;
+        slot.last_start_ns = st.last_start_ns;
+        slot.budget_ns = st.current_budget_ns;
+        slot.iterations = st.exec.count;
+        slot.timeouts = st.timeouts;
+        slot.recoveries = st.recoveries;
+        slot.restarts = st.restarts;
+        slot.exec_p50_ns = st.exec.p50;
+        slot.exec_p99_ns = st.exec.p99;
+        slot.exec_max_ns = st.exec.max;
+    }
+}
+
+/**
+ * Detiene el pipeline, cierra la barrera y deja los LEDs señalizando la falla:
+ * el rojo en failsafe y el verde con el código del hilo que falló. No bloquea
+ * al llamador; el proceso queda en ese estado hasta Ctrl+C.
+ * @param code Cantidad de destellos del verde (id del hilo que falló)
+ */
+void enter_failsafe_state(const string &reason, ThreadSupervisor &supervisor, uint16_t code) {
+    LOG_ERROR("[FAILSAFE] %s", reason.c_str());
     supervisor.shutdown_all();
+    gpioWaveTxStop();
     gpioServo(BARRIER_PIN, 500);
-    gpioSetMode(LED_RED, PI_OUTPUT);
-    gpioSetMode(LED_GREEN, PI_OUTPUT);
-    while (true) {
-        gpioWrite(LED_RED, 1);
-        gpioWrite(LED_GREEN, 1);
-        this_thread::sleep_for(chrono::milliseconds(500));
-        gpioWrite(LED_RED, 0);
-        gpioWrite(LED_GREEN, 0);
-        this_thread::sleep_for(chrono::milliseconds(500));
+    leds.post(LED_RED, LedPattern::failsafe());
+    leds.post(LED_GREEN, LedPattern::error_code(code));
+}
+
+/**
+ * Latencias del pipeline, comunes a los dos modos de ejecución.
+ */
+void print_latency_report() {
+    auto ms = [](double ns) { return ns / 1e6; };
+    for (auto [name, histogram] : {pair<const char*, const LatencyHistogram*>{"envio", &pipelineMetrics.upload_latency},
+                                   {"decision", &pipelineMetrics.decision_latency}}) {
+        HistogramSnapshot h = histogram->snapshot();
+        cout << "[PIPELINE] Latencia de " << name << " (ms): n=" << h.count << " p50=" << ms(h.p50)
+             << " p99=" << ms(h.p99) << " max=" << ms(h.max) << endl;
+    }
+
+    // Lo que ahorra precalentar la conexión: preparación + conexión en frío contra en caliente
+    HistogramSnapshot warm = pipelineMetrics.upload_setup_warm.snapshot();
+    HistogramSnapshot cold = pipelineMetrics.upload_setup_cold.snapshot();
+    cout << "[PIPELINE] Preparación del envío (ms): en caliente n=" << warm.count << " p50=" << ms(warm.p50)
+         << ", en frío n=" << cold.count << " p50=" << ms(cold.p50);
+    if (warm.count > 0 && cold.count > 0) cout << ", ahorro p50=" << ms(double(cold.p50) - double(warm.p50));
+    cout << " (precalentadas " << pipelineMetrics.connection_warmups.value() << ", vencidas "
+         << pipelineMetrics.connection_expired.value() << ")" << endl;
+}
+
+/**
+ * Corre el sistema con EventRuntime en lugar del supervisor y sus hilos.
+ * Comparte con el modo de hilos el hardware, las métricas, el estado en
+ * memoria compartida y el apagado.
+ */
+int run_event_loop_mode(VideoCapture& cam, const sigset_t& signal_set) {
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    MetricsServer metrics_server([](MetricsWriter& m) { render_metrics(m, nullptr); });
+    metrics_server.start();
+    StatsPublisher stats_publisher([](StatsPayload& s) { fill_stats(s, nullptr); });
+    if (!stats_publisher.start()) {
+        LOG_WARN("No se pudo crear el segmento de estado en memoria compartida");
+    }
+
+    cout << "Sistema iniciado en modo event loop. Esperando eventos...\n";
+    cout << "Presiona Ctrl+C para terminar el programa.\n";
+
+    int result;
+    {
+        // Los envíos pendientes se cierran con el runtime, antes de curl_global_cleanup()
+        EventRuntime runtime(cam, rt_profile);
+        result = runtime.run(signal_set);
+        handle_sigint(SIGINT);
+
+        cam.release();
+        stats_publisher.stop();
+        metrics_server.stop();
+        Tracer::instance().stop();
+        Logger::instance().stop();
+        runtime.print_report();
     }
+    curl_global_cleanup();
+    releaseBarrierArm();
+    rt_profile.print_report();
+    print_latency_report();
+
+    leds.post(LED_RED, LedPattern::off());
+    leds.post(LED_GREEN, LedPattern::off());
+    leds.stop();
+    gpioTerminate();
+
+    cout << "✅ Apagado limpio completado.\n";
+    return result;
 }
 
-int main() {
+int main(int argc, char** argv) {
     sigset_t signal_set;
     sigemptyset(&signal_set);
     sigaddset(&signal_set, SIGINT);
+    sigaddset(&signal_set, SIGUSR2);
     
-    // Bloquear SIGINT en el thread principal (todos los threads heredarán esta máscara)
+    // Bloquear SIGINT y SIGUSR2 (volcado de traza) en el thread principal (todos los threads heredarán esta máscara)
     if (pthread_sigmask(SIG_BLOCK, &signal_set, NULL) != 0) {
         cerr << "Error bloqueando SIGINT en thread principal" << endl;
         return EXIT_FAILURE;
     }
 
-    ThreadSupervisor supervisor;
-    global_supervisor_ptr = &supervisor;
+    // Antes de crear hilos: memoria bloqueada y pool de OpenCV en sus propios núcleos
+    // (los hilos creados desde acá heredan esa afinidad hasta aplicar su rol)
+    rt_profile.load_from_env();
+    rt_profile.setup_memory();
+    rt_profile.confine_opencv();
 
-    supervisor.set_running_flag(&system_running);
+    bool event_loop_mode = argc > 1 && string(argv[1]) == "--event-loop";
+
+    // Modo diagnóstico: mide la latencia de despertar del equipo y termina
+    if (argc > 1 && string(argv[1]) == "--jitter-test") {
+        JitterTestOptions options;
+        if (!parse_jitter_args(argc, argv, options)) return EXIT_FAILURE;
+        sigset_t stop_set = signal_set;
+        sigdelset(&stop_set, SIGUSR2);
+        curl_global_init(CURL_GLOBAL_ALL);
+        int result = run_jitter_test(options, rt_profile, stop_set);
+        curl_global_cleanup();
+        return result;
+    }
+
+    // Escritor de logs y de trazas en SCHED_OTHER, creados antes que cualquier hilo de tiempo real
+    Logger::instance().start();
+    Tracer::instance().start();
 
     if (gpioInitialise() < 0) {
         cerr << "Error al inicializar pigpio" << endl;
         return EXIT_FAILURE;
     }
+    leds.start();
 
     VideoCapture cam(0);
     if (!cam.isOpened()) {
@@ -110,44 +332,56 @@ int main() {
     cam.set(CAP_PROP_FRAME_WIDTH, 640);
     cam.set(CAP_PROP_FRAME_HEIGHT, 480);
 
-    // Configurar señales para la cámara
+    // Disparo manual de la cámara (kill -USR1)
     signal(SIGUSR1, handle_signal_camera);
 
-    // Configurar barrera
-    pthread_barrier_init(&barrier, NULL, NUM_THREADS);
+    // Modo de un solo hilo: el pipeline sobre un event loop, para comparar con el de hilos
+    if (event_loop_mode) {
+        return run_event_loop_mode(cam, signal_set);
+    }
+
+    ThreadSupervisor supervisor;
+    global_supervisor_ptr = &supervisor;
+    rt_profile.apply(ThreadRole::Monitor, supervisor.monitor_handle());
+    rt_profile.apply(ThreadRole::Recovery, supervisor.recovery_handle());
+
+    supervisor.set_running_flag(&system_running);
 
     atomic<int> sensor_retries(0);
     auto recovery_sensor = [&supervisor, &sensor_retries] () {
-        cout << "Intentando recuperación del sensor..." << endl;
+        LOG_INFO("Intentando recuperación del sensor...");
         if (++sensor_retries > 5) {
-            cerr << "❌ Error crítico: No se pudo recuperar el sensor tras varios intentos." << endl;
-            enter_failsafe_state("Sensor falló de forma permanente.", supervisor);
+            LOG_ERROR("❌ Error crítico: No se pudo recuperar el sensor tras varios intentos.");
+            enter_failsafe_state("Sensor falló de forma permanente.", supervisor, SENSOR_THREAD);
+            return;
         }
         gpioSetMode(TRIGGER_PIN, PI_OUTPUT);
         gpioSetMode(ECHO_PIN, PI_INPUT);
         gpioWrite(TRIGGER_PIN, 0);
         usleep(50000);
-        cout << "✅ Reconfiguración del sensor realizada." << endl;
+        LOG_INFO("✅ Reconfiguración del sensor realizada.");
         sensor_retries = 0;
     };
 
     auto recovery_camera = [&cam, &supervisor]() {
-        cerr << "Ejecutando recuperación para cámara..." << endl;
+        LOG_WARN("Ejecutando recuperación para cámara...");
         if (!cam.isOpened()) {
-            cerr << "❌ Error crítico: No se pudo recuperar la cámara." << endl;
-            enter_failsafe_state("Cámara falló de forma permanente.", supervisor);
+            LOG_ERROR("❌ Error crítico: No se pudo recuperar la cámara.");
+            enter_failsafe_state("Cámara falló de forma permanente.", supervisor, CAMERA_THREAD);
+            return;
         }
         cam.set(CAP_PROP_FRAME_WIDTH, 640);
         cam.set(CAP_PROP_FRAME_HEIGHT, 480);
-        cout << "✅ Reconfiguración de la cámara realizada." << endl;
+        LOG_INFO("✅ Reconfiguración de la cámara realizada.");
     };
 
     auto recovery_communicator = [&supervisor]() {
-        cerr << "Ejecutando recuperación para comunicador..." << endl;
+        LOG_WARN("Ejecutando recuperación para comunicador...");
         CURL *curl = curl_easy_init();
         if (!curl) {
-            cerr << "Error inicializando CURL" << endl;
-            enter_failsafe_state("Error crítico: Comunicador inalcanzable.", supervisor);
+            LOG_ERROR("Error inicializando CURL");
+            enter_failsafe_state("Error crítico: Comunicador inalcanzable.", supervisor, COMMUNICATOR_THREAD);
+            return;
         }
         curl_easy_setopt(curl, CURLOPT_URL, "http://192.168.0.103:5000/status");
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, 3L);
@@ -155,84 +389,144 @@ int main() {
         CURLcode res = curl_easy_perform(curl);
         curl_easy_cleanup(curl);
         if (res != CURLE_OK) {
-            cerr << "No se pudo contactar con el backend: " << curl_easy_strerror(res) << endl;
-            enter_failsafe_state("Error crítico: Comunicador inalcanzable.", supervisor);
+            LOG_ERROR("No se pudo contactar con el backend: %s", curl_easy_strerror(res));
+            enter_failsafe_state("Error crítico: Comunicador inalcanzable.", supervisor, COMMUNICATOR_THREAD);
         }
     };
 
     atomic<int> barrier_retries = 0;
     auto recovery_barrier = [&supervisor, &barrier_retries]() {
-        cerr << "Intentando recuperación de la barrera..." << endl;
+        LOG_WARN("Intentando recuperación de la barrera...");
         if (++barrier_retries > 1) {
-            cerr << "❌ Error crítico: Fallo persistente en la barrera." << endl;
-            enter_failsafe_state("Fallo en la barrera.", supervisor);
+            LOG_ERROR("❌ Error crítico: Fallo persistente en la barrera.");
+            enter_failsafe_state("Fallo en la barrera.", supervisor, BARRIER_THREAD);
+            return;
         }
-        gpioSetMode(LED_GREEN, PI_OUTPUT);
-        gpioSetMode(LED_RED, PI_OUTPUT);
+        gpioWaveTxStop();
         gpioServo(BARRIER_PIN, 500);
-        gpioWrite(LED_GREEN, 0);
-        gpioWrite(LED_RED, 0);
-        cout << "✅ Barrera reiniciada." << endl;
+        leds.post(LED_GREEN, LedPattern::off());
+        leds.post(LED_RED, LedPattern::solid());
+        LOG_INFO("✅ Barrera reiniciada.");
         barrier_retries = 0;
     };
 
-    // Registrar los threads con el supervisor
-    supervisor.register_thread(SENSOR_THREAD, milliseconds(200), recovery_sensor);
-    supervisor.register_thread(CAMERA_THREAD, milliseconds(1000), recovery_camera);
-    supervisor.register_thread(COMMUNICATOR_THREAD, milliseconds(10000), recovery_communicator);
-    supervisor.register_thread(BARRIER_THREAD, milliseconds(10000), recovery_barrier);
+    // El comunicador puede reiniciarse: la inicialización global de cURL es del proceso
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    // Registrar los threads con el supervisor, que los crea y reinicia si se cuelgan
+    supervisor.register_worker(SENSOR_THREAD, milliseconds(200), recovery_sensor,
+                               [](WorkerContext& ctx) {
+                                   name_thread("sensor");
+                                   rt_profile.apply(ThreadRole::Sensor);
+                                   threadSensor(ctx);
+                               });
+    // La cámara es una sola: una generación nueva no la usa mientras la abandonada siga dentro
+    supervisor.register_worker(CAMERA_THREAD, milliseconds(1000), recovery_camera,
+                               [&cam](WorkerContext& ctx) {
+                                   name_thread("camara");
+                                   rt_profile.apply(ThreadRole::Camera);
+                                   threadCamera(ctx, cam);
+                               }, 3, true);
+    supervisor.register_worker(COMMUNICATOR_THREAD, milliseconds(10000), recovery_communicator,
+                               [](WorkerContext& ctx) {
+                                   name_thread("comunicador");
+                                   rt_profile.apply(ThreadRole::Communicator);
+                                   threadCommunicator(ctx);
+                               });
+    supervisor.register_worker(BARRIER_THREAD, milliseconds(1000), recovery_barrier,
+                               [](WorkerContext& ctx) {
+                                   name_thread("barrera");
+                                   rt_profile.apply(ThreadRole::Barrier);
+                                   threadBarrier(ctx);
+                               });
+
+    // Presupuestos aprendidos de los tiempos observados, acotados por valores seguros
+    // (la cámara tarda bastante más en la primera captura que a régimen). El piso
+    // cubre la peor iteración legítima: una medición sin eco espera el límite en
+    // cada flanco, y una lectura de la cámara puede trabarse cerca de un segundo
+    supervisor.enable_adaptive_budget(SENSOR_THREAD, {.floor = SENSOR_WORST_MEASURE + milliseconds(50), .ceiling = milliseconds(400)});
+    supervisor.enable_adaptive_budget(CAMERA_THREAD, {.floor = milliseconds(1000), .ceiling = milliseconds(2000)});
+    supervisor.enable_adaptive_budget(COMMUNICATOR_THREAD, {.floor = milliseconds(500), .ceiling = milliseconds(12000)});
+    supervisor.enable_adaptive_budget(BARRIER_THREAD, {.floor = milliseconds(50), .ceiling = milliseconds(1000)});
 
     // Crear los threads de trabajo (heredarán la máscara de señales bloqueada)
-    thread t_sensor(threadSensor, ref(supervisor), ref(system_running), SENSOR_THREAD);
-    thread t_camera(threadCamera, ref(supervisor), ref(system_running), CAMERA_THREAD, ref(cam));
-    thread t_communicator(threadCommunicator, ref(supervisor), ref(system_running), COMMUNICATOR_THREAD);
-    thread t_barrier(threadBarrier, ref(supervisor), ref(system_running), BARRIER_THREAD);
+    supervisor.start_workers();
+
+    // Métricas locales en formato Prometheus (curl localhost:9105/metrics)
+    MetricsServer metrics_server([&supervisor](MetricsWriter& m) { render_metrics(m, &supervisor); });
+    metrics_server.start();
+
+    // Estado en vivo en memoria compartida (strctl show|watch|check)
+    StatsPublisher stats_publisher([&supervisor](StatsPayload& s) { fill_stats(s, &supervisor); });
+    if (!stats_publisher.start()) {
+        LOG_WARN("No se pudo crear el segmento de estado en memoria compartida");
+    }
 
     // Thread dedicado para manejar señales
     thread signal_thread([&signal_set]() {
         int received_signal;
         cout << "🔧 Thread de señales iniciado. Esperando Ctrl+C..." << endl;
         
-        // Esperar por SIGINT
-        int result = sigwait(&signal_set, &received_signal);
-        if (result == 0 && received_signal == SIGINT) {
-            cout << "\n🛑 SIGINT recibida en thread dedicado. Iniciando apagado..." << endl;
-            handle_sigint(received_signal);
-        } else {
-            cerr << "Error en sigwait: " << result << endl;
+        // Esperar por SIGINT; cada SIGUSR2 pide un volcado de la traza
+        for (;;) {
+            int result = sigwait(&signal_set, &received_signal);
+            if (result == 0 && received_signal == SIGUSR2) {
+                Tracer::instance().request_dump("manual", true);
+                continue;
+            }
+            if (result == 0 && received_signal == SIGINT) {
+                cout << "\n🛑 SIGINT recibida en thread dedicado. Iniciando apagado..." << endl;
+                handle_sigint(received_signal);
+            } else {
+                cerr << "Error en sigwait: " << result << endl;
+            }
+            break;
         }
     });
 
     cout << "Sistema iniciado. Esperando eventos...\n";
     cout << "Presiona Ctrl+C para terminar el programa.\n";
 
+    // Pasado el calentamiento, todo fallo de página nuevo es una latencia evitable
+    auto warmup_end = steady_clock::now() + rt_profile.warmup;
+    while (system_running && steady_clock::now() < warmup_end) {
+        this_thread::sleep_for(milliseconds(100));
+    }
+    rt_profile.mark_warm();
+
     // Esperar a que termine el signal_thread (cuando reciba Ctrl+C)
     signal_thread.join();
     
     cout << "🔧 Esperando que terminen los threads de trabajo..." << endl;
 
-    // Dar tiempo a los threads para que vean system_running = false
-    this_thread::sleep_for(chrono::milliseconds(100));
-
-    // Esperar a que terminen los threads de trabajo
-    if (t_sensor.joinable()) {
-        cout << "🔧 Esperando thread sensor..." << endl;
-        t_sensor.join();
-    }
-    if (t_camera.joinable()) {
-        cout << "🔧 Esperando thread camera..." << endl;
-        t_camera.join();
-    }
-    if (t_communicator.joinable()) {
-        cout << "🔧 Esperando thread communicator..." << endl;
-        t_communicator.join();
-    }
-    if (t_barrier.joinable()) {
-        cout << "🔧 Esperando thread barrier..." << endl;
-        t_barrier.join();
+    // Esperar a que terminen los threads de trabajo; uno colgado no bloquea el apagado
+    bool workers_done = supervisor.join_workers();
+    if (workers_done) {
+        cam.release();
+        curl_global_cleanup();
+        releaseBarrierArm();
     }
+    stats_publisher.stop();
+    metrics_server.stop();
+    Tracer::instance().stop();
+    Logger::instance().stop();
+
+    // Distribución de tiempos observada, para ajustar los presupuestos de cada hilo
+    supervisor.print_timing_report();
+    rt_profile.print_report();
+    print_latency_report();
 
-    pthread_barrier_destroy(&barrier);
+    leds.post(LED_RED, LedPattern::off());
+    leds.post(LED_GREEN, LedPattern::off());
+    leds.stop();
+
+    // Un hilo abandonado puede seguir dentro de la cámara, cURL o pigpio: no se liberan
+    // ni se destruye el supervisor, se termina el proceso sin correr destructores
+    if (!workers_done) {
+        cerr << "⚠️ Quedan hilos sin terminar: se sale sin liberar cámara, cURL ni pigpio." << endl;
+        cout.flush();
+        _exit(EXIT_FAILURE);
+    }
     gpioTerminate();
 
     cout << "✅ Apagado limpio completado.\n";
@@ -0,0 +1,226 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "logger.h"
+#include "rt_profile.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Escribe todo el buffer en el socket, reintentando escrituras parciales.
+ */
+bool send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void append_format(string& out, const char* fmt, double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), fmt, value);
+    out += buf;
+}
+
+} // namespace
+
+void MetricsWriter::header(const char* name, const char* help, const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void MetricsWriter::sample(const char* name, double value, const string& labels) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    append_format(out, " %.9g\n", value);
+}
+
+void MetricsWriter::counter(const char* name, const char* help, uint64_t value) {
+    header(name, help, "counter");
+    sample(name, static_cast<double>(value));
+}
+
+void MetricsWriter::gauge(const char* name, const char* help, double value) {
+    header(name, help, "gauge");
+    sample(name, value);
+}
+
+void MetricsWriter::histogram(const char* name, const char* help, const LatencyHistogram& h,
+                              initializer_list<double> bounds_s) {
+    header(name, help, "histogram");
+    string base = name;
+    // El total se lee primero: los buckets acumulados nunca lo superan aunque haya muestras concurrentes
+    uint64_t count = h.count();
+    for (double le : bounds_s) {
+        char label[48];
+        snprintf(label, sizeof(label), "le=\"%g\"", le);
+        uint64_t below = h.count_at_or_below(static_cast<uint64_t>(le * 1e9));
+        sample((base + "_bucket").c_str(), static_cast<double>(min(below, count)), label);
+    }
+    sample((base + "_bucket").c_str(), static_cast<double>(count), "le=\"+Inf\"");
+    sample((base + "_sum").c_str(), static_cast<double>(h.sum_ns()) / 1e9);
+    sample((base + "_count").c_str(), static_cast<double>(count));
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    const char* enabled = getenv("STR_METRICS");
+    if (enabled && strcmp(enabled, "0") == 0) return false;
+
+    const char* path = getenv("STR_METRICS_SOCKET");
+    if (path && *path) {
+        sockaddr_un addr{};
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            LOG_ERROR("[METRICAS] Ruta de socket demasiado larga: %s", path);
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+        unlink(path);
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            LOG_ERROR("[METRICAS] No se pudo abrir %s: %s", path, strerror(errno));
+            stop();
+            return false;
+        }
+        socket_path = path;
+    } else {
+        const char* port_env = getenv("STR_METRICS_PORT");
+        const char* addr_env = getenv("STR_METRICS_ADDR");
+        int port = port_env ? atoi(port_env) : 9105;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, addr_env ? addr_env : "127.0.0.1", &addr.sin_addr) != 1) {
+            LOG_ERROR("[METRICAS] Dirección inválida: %s", addr_env);
+            return false;
+        }
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (listen_fd >= 0) setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            LOG_ERROR("[METRICAS] No se pudo abrir el puerto %d: %s", port, strerror(errno));
+            stop();
+            return false;
+        }
+    }
+
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd < 0 || listen(listen_fd, 4) < 0) {
+        LOG_ERROR("[METRICAS] Error iniciando el servidor: %s", strerror(errno));
+        stop();
+        return false;
+    }
+    server = thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (server.joinable()) {
+        uint64_t one = 1;
+        (void)!write(stop_fd, &one, sizeof(one));
+        server.join();
+    }
+    if (listen_fd >= 0) close(listen_fd);
+    if (stop_fd >= 0) close(stop_fd);
+    if (!socket_path.empty()) unlink(socket_path.c_str());
+    listen_fd = -1;
+    stop_fd = -1;
+    socket_path.clear();
+}
+
+/**
+ * Hilo servidor: en SCHED_OTHER, espera conexiones o el pedido de cierre.
+ */
+void MetricsServer::serve() {
+    set_background_policy();
+    Logger::instance().set_thread_name("metricas");
+
+    pollfd fds[2] = {{listen_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("[METRICAS] Error en poll: %s", strerror(errno));
+            return;
+        }
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        handle(fd);
+        close(fd);
+    }
+}
+
+/**
+ * Atiende una conexión: lee la línea de pedido y responde con las métricas.
+ * Un cliente que no envía nada en un segundo se descarta.
+ */
+void MetricsServer::handle(int fd) {
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    size_t used = 0;
+    while (used < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+        if (n <= 0) break;
+        used += static_cast<size_t>(n);
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[used] = '\0';
+
+    bool is_metrics = strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0;
+    string body;
+    const char* status = "404 Not Found";
+    const char* type = "text/plain";
+    if (is_metrics) {
+        MetricsWriter writer(body);
+        render(writer);
+        status = "200 OK";
+        type = "text/plain; version=0.0.4; charset=utf-8";
+        served.fetch_add(1, memory_order_relaxed);
+    } else {
+        body = "Solo se atiende GET /metrics\n";
+    }
+
+    char head[192];
+    int n = snprintf(head, sizeof(head), "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                     status, type, body.size());
+    if (send_all(fd, head, static_cast<size_t>(n))) send_all(fd, body.data(), body.size());
+}
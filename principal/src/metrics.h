@@ -0,0 +1,161 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include "latency_histogram.h"
+
+using namespace std;
+
+/**
+ * Clase ShardedCounter
+ * Contador monótono repartido en varias celdas, cada una en su propia línea
+ * de caché. Cada hilo incrementa siempre la misma celda (asignada la primera
+ * vez que cuenta), por lo que los hilos de tiempo real no compiten por la
+ * línea de caché de un contador; la lectura suma todas las celdas.
+ */
+class ShardedCounter {
+public:
+    static constexpr size_t SHARDS = 8;
+
+    void inc(uint64_t n = 1) {
+        shards[shard_index()].value.fetch_add(n, memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& s : shards) total += s.value.load(memory_order_relaxed);
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        atomic<uint64_t> value{0};
+    };
+
+    array<Shard, SHARDS> shards;
+
+    static size_t shard_index() {
+        static atomic<size_t> next_shard{0};
+        thread_local size_t index = next_shard.fetch_add(1, memory_order_relaxed) % SHARDS;
+        return index;
+    }
+};
+
+/** Carriles con sensor propio (por ahora se usa solo el 0) */
+inline constexpr size_t MAX_LANES = 4;
+
+/**
+ * Estado en vivo de un carril. Lo escriben el sensor y la barrera; la barrera
+ * además lee `occupied` para cerrar, y se publica para inspección (ver shm_stats.h).
+ */
+struct LaneStatus {
+    atomic<uint8_t> occupied{0};          // 1 mientras hay un vehículo frente al sensor (la barrera cierra al liberarse)
+    atomic<uint8_t> barrier{0};           // BarrierState de la barrera del carril
+    atomic<int32_t> last_distance_mm{-1}; // Última distancia medida (-1 = inválida)
+    atomic<int64_t> last_measure_ns{0};
+    atomic<uint64_t> last_vehicle_id{0};
+};
+
+/**
+ * Métricas del pipeline que actualizan los hilos de trabajo. Las del
+ * supervisor, las colas y el pool se leen de sus propias estadísticas al
+ * momento de la consulta.
+ */
+struct PipelineMetrics {
+    ShardedCounter vehicles_detected;     // Detecciones del sensor con registro asignado
+    ShardedCounter photos_captured;       // Fotos guardadas por la cámara
+    ShardedCounter camera_frame_drops;    // Frames vacíos o capturas fallidas
+    ShardedCounter events_dropped;        // Vehículos perdidos por pool agotado o canal lleno
+    ShardedCounter uploads_failed;        // Consultas sin decisión (sin archivo, error de red o respuesta distinta de 200)
+    ShardedCounter decisions_granted;
+    ShardedCounter decisions_denied;
+    LatencyHistogram upload_latency;      // Duración del envío al backend (ns)
+    LatencyHistogram upload_setup_warm;   // Preparación + conexión de un envío con conexión precalentada (ns)
+    LatencyHistogram upload_setup_cold;   // Preparación + conexión de un envío en frío (ns)
+    ShardedCounter connection_warmups;    // Conexiones precalentadas al detectar un vehículo
+    ShardedCounter connection_expired;    // Conexiones precalentadas descartadas sin foto
+    LatencyHistogram decision_latency;    // Disparo -> decisión conocida (ns)
+    array<LaneStatus, MAX_LANES> lanes;
+};
+
+/**
+ * Clase MetricsWriter
+ * Arma la respuesta en el formato de texto de Prometheus (versión 0.0.4).
+ */
+class MetricsWriter {
+public:
+    explicit MetricsWriter(string& out) : out(out) {}
+
+    /** Líneas # HELP y # TYPE; van una vez por métrica, antes de sus muestras */
+    void header(const char* name, const char* help, const char* type);
+
+    /**
+     * Una muestra.
+     * @param labels Etiquetas ya formateadas, por ejemplo `hilo="1"` (vacío = sin etiquetas)
+     */
+    void sample(const char* name, double value, const string& labels = "");
+
+    void counter(const char* name, const char* help, uint64_t value);
+    void gauge(const char* name, const char* help, double value);
+
+    /**
+     * Histograma en segundos a partir de un LatencyHistogram en nanosegundos.
+     * Los límites `le` se redondean al bucket logarítmico (error ≤ 6,25 %).
+     */
+    void histogram(const char* name, const char* help, const LatencyHistogram& h,
+                   initializer_list<double> bounds_s);
+
+private:
+    string& out;
+};
+
+/**
+ * Clase MetricsServer
+ * Servidor HTTP mínimo que responde `GET /metrics` con el texto que arma
+ * `render`. Atiende de a una conexión en un hilo SCHED_OTHER; armar la
+ * respuesta solo lee atómicos, así que consultarlo no frena al pipeline.
+ *
+ * Se configura por variables de entorno (todas opcionales):
+ * - STR_METRICS=0                        Desactiva el servidor
+ * - STR_METRICS_PORT=9105                Puerto TCP
+ * - STR_METRICS_ADDR=127.0.0.1           Dirección de escucha (por defecto solo local)
+ * - STR_METRICS_SOCKET=/run/str.sock     Escucha en un socket Unix en lugar de TCP
+ */
+class MetricsServer {
+public:
+    using Renderer = function<void(MetricsWriter&)>;
+
+    explicit MetricsServer(Renderer render) : render(move(render)) {}
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * Abre el socket e inicia el hilo servidor.
+     * @return false si está desactivado o no pudo abrirse el socket
+     */
+    bool start();
+    void stop();
+
+    uint64_t scrapes() const { return served.load(memory_order_relaxed); }
+
+private:
+    Renderer render;
+    int listen_fd = -1;
+    int stop_fd = -1;                     // eventfd para despertar al servidor al detenerlo
+    string socket_path;
+    thread server;
+    atomic<uint64_t> served{0};
+
+    void serve();
+    void handle(int fd);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,117 @@
+#ifndef PERIODIC_TIMER_H
+#define PERIODIC_TIMER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <cerrno>
+#include "latency_histogram.h"
+
+using namespace std;
+
+/**
+ * Estadísticas de activación de una tarea periódica. Las escribe solo el
+ * hilo de la tarea; se leen sin locks para los reportes.
+ */
+struct PeriodicStats {
+    LatencyHistogram jitter;                 // Retraso de cada despertar respecto de su instante teórico (ns)
+    atomic<uint64_t> activations{0};         // Activaciones realizadas
+    atomic<uint64_t> overruns{0};            // Iteraciones que terminaron después de la siguiente activación
+    atomic<uint64_t> skipped{0};             // Activaciones perdidas por esos desbordes
+    atomic<int64_t> period_ns{0};            // Período configurado
+};
+
+/**
+ * Clase PeriodicTimer
+ * Calendario de activaciones con instantes absolutos: la activación k ocurre
+ * en `anchor + phase + k * period`, sin importar cuánto tarde cada iteración.
+ * A diferencia de encadenar sleep() relativos, el período no se corre con el
+ * trabajo hecho ni acumula error.
+ *
+ * Si una iteración se pasa de la siguiente activación (desborde), se cuenta y
+ * se saltean las activaciones ya vencidas para no disparar una ráfaga de
+ * iteraciones atrasadas: la tarea vuelve a su fase original.
+ */
+class PeriodicTimer {
+public:
+    using time_point = chrono::steady_clock::time_point;
+
+    /**
+     * @param period Período de activación
+     * @param phase Desfase respecto del ancla (para repartir tareas del mismo período)
+     * @param stats Destino de las estadísticas (nullptr = estadísticas propias)
+     */
+    explicit PeriodicTimer(chrono::nanoseconds period,
+                           chrono::nanoseconds phase = chrono::nanoseconds::zero(),
+                           PeriodicStats* stats = nullptr)
+        : period(period), phase(phase), stats(stats ? stats : &own_stats) {
+        this->stats->period_ns.store(period.count(), memory_order_relaxed);
+    }
+
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+
+    /**
+     * Fija el ancla del calendario. Si no se llama, el ancla es la primera llamada a arm().
+     */
+    void start(time_point anchor) {
+        next = anchor + phase;
+        started = true;
+    }
+
+    /**
+     * Calcula el instante de la próxima activación, detectando desbordes.
+     * @param now Instante actual
+     * @return Instante absoluto hasta el cual hay que dormir
+     */
+    time_point arm(time_point now) {
+        if (!started) start(now);
+        if (now > next && armed_once) {
+            // La iteración anterior terminó tarde: se saltean las activaciones vencidas
+            auto late = now - next;
+            uint64_t missed = static_cast<uint64_t>(late / period) + 1;
+            stats->overruns.fetch_add(1, memory_order_relaxed);
+            stats->skipped.fetch_add(missed, memory_order_relaxed);
+            next += period * missed;
+        }
+        armed_once = true;
+        return next;
+    }
+
+    /**
+     * Registra el despertar de la activación armada y avanza el calendario.
+     * @param woke Instante real del despertar
+     */
+    void released(time_point woke) {
+        stats->jitter.record(chrono::duration_cast<chrono::nanoseconds>(woke - next).count());
+        stats->activations.fetch_add(1, memory_order_relaxed);
+        next += period;
+    }
+
+    /**
+     * Duerme hasta la próxima activación con clock_nanosleep(TIMER_ABSTIME).
+     * No es cancelable: los hilos supervisados usan WorkerContext::wait_next().
+     */
+    void wait_next() {
+        time_point release = arm(chrono::steady_clock::now());
+        auto ns = release.time_since_epoch().count();
+        timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        released(chrono::steady_clock::now());
+    }
+
+    chrono::nanoseconds get_period() const { return period; }
+    const PeriodicStats& get_stats() const { return *stats; }
+
+private:
+    chrono::nanoseconds period;
+    chrono::nanoseconds phase;
+    PeriodicStats own_stats;
+    PeriodicStats* stats;
+    time_point next{};
+    bool started = false;
+    bool armed_once = false;
+};
+
+#endif // PERIODIC_TIMER_H
@@ -0,0 +1,206 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+/** Tamaño de línea de caché usado para separar índices de productores y consumidores */
+inline constexpr size_t CACHE_LINE = 64;
+
+/**
+ * Clase SpscRing
+ * Buffer circular sin locks de capacidad fija para un productor y un consumidor.
+ * Los elementos se mueven por valor dentro de slots preasignados: no hay
+ * reservas de memoria al insertar ni al extraer.
+ *
+ * @tparam T Tipo de evento (debe ser construible por defecto y movible)
+ * @tparam Capacity Cantidad de slots, potencia de dos
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity debe ser potencia de dos");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    alignas(CACHE_LINE) atomic<size_t> head{0};   // Próximo slot a leer (escrito por el consumidor)
+    alignas(CACHE_LINE) size_t cached_tail{0};    // Copia local de tail del lado consumidor
+    alignas(CACHE_LINE) atomic<size_t> tail{0};   // Próximo slot a escribir (escrito por el productor)
+    alignas(CACHE_LINE) size_t cached_head{0};    // Copia local de head del lado productor
+    alignas(CACHE_LINE) array<T, Capacity> slots{};
+
+public:
+    /**
+     * Inserta un evento. Solo puede llamarlo el hilo productor.
+     * @return false si el buffer está lleno
+     */
+    bool try_push(T&& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cached_head == Capacity) {
+            cached_head = head.load(memory_order_acquire);
+            if (t - cached_head == Capacity) return false;
+        }
+        slots[t & MASK] = move(value);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Reserva el próximo slot para escribirlo en el lugar, sin copias
+     * intermedias. Debe seguirse de commit(). Solo el hilo productor.
+     * @return nullptr si el buffer está lleno
+     */
+    T* try_claim() {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cached_head == Capacity) {
+            cached_head = head.load(memory_order_acquire);
+            if (t - cached_head == Capacity) return nullptr;
+        }
+        return &slots[t & MASK];
+    }
+
+    /**
+     * Publica el slot obtenido con try_claim().
+     */
+    void commit() {
+        tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+    /**
+     * Extrae un evento. Solo puede llamarlo el hilo consumidor.
+     * @return false si el buffer está vacío
+     */
+    bool try_pop(T& out) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(memory_order_acquire);
+            if (h == cached_tail) return false;
+        }
+        out = move(slots[h & MASK]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Devuelve el próximo evento sin extraerlo, para leerlo en el lugar.
+     * Debe seguirse de consume(). Solo el hilo consumidor.
+     * @return nullptr si el buffer está vacío
+     */
+    const T* front() {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(memory_order_acquire);
+            if (h == cached_tail) return nullptr;
+        }
+        return &slots[h & MASK];
+    }
+
+    /**
+     * Libera el slot leído con front().
+     */
+    void consume() {
+        head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    /**
+     * Cantidad aproximada de eventos en el buffer (exacta si no hay operaciones concurrentes).
+     */
+    size_t size() const {
+        return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+};
+
+/**
+ * Clase MpscRing
+ * Buffer circular sin locks de capacidad fija para varios productores y un consumidor.
+ * Cada slot lleva un número de secuencia (esquema de Vyukov): los productores
+ * reservan un slot con CAS sobre `tail` y lo publican actualizando su secuencia.
+ *
+ * @tparam T Tipo de evento (debe ser construible por defecto y movible)
+ * @tparam Capacity Cantidad de slots, potencia de dos
+ */
+template <typename T, size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity debe ser potencia de dos");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct alignas(CACHE_LINE) Cell {
+        atomic<size_t> sequence;
+        T value{};
+    };
+
+    alignas(CACHE_LINE) atomic<size_t> tail{0};   // Próxima posición a reservar por un productor
+    alignas(CACHE_LINE) size_t head{0};           // Próxima posición a leer (solo el consumidor)
+    alignas(CACHE_LINE) atomic<size_t> consumed{0};
+    array<Cell, Capacity> cells;
+
+public:
+    MpscRing() {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * Inserta un evento. Puede llamarse desde cualquier hilo.
+     * @return false si el buffer está lleno
+     */
+    bool try_push(T&& value) {
+        size_t pos = tail.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & MASK];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    cell.value = move(value);
+                    cell.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Extrae un evento. Solo puede llamarlo el hilo consumidor.
+     * @return false si el buffer está vacío
+     */
+    bool try_pop(T& out) {
+        Cell& cell = cells[head & MASK];
+        size_t seq = cell.sequence.load(memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head + 1) < 0) return false;
+        out = move(cell.value);
+        cell.sequence.store(head + Capacity, memory_order_release);
+        head++;
+        consumed.store(head, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Cantidad aproximada de eventos en el buffer.
+     */
+    size_t size() const {
+        size_t t = tail.load(memory_order_acquire);
+        size_t h = consumed.load(memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+};
+
+#endif // RING_BUFFER_H
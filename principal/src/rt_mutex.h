@@ -0,0 +1,121 @@
+#ifndef RT_MUTEX_H
+#define RT_MUTEX_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <ctime>
+#include <mutex>
+#include <pthread.h>
+
+using namespace std;
+
+/**
+ * Clase PiMutex
+ * Mutex con herencia de prioridad (PTHREAD_PRIO_INHERIT) para el estado que
+ * comparten hilos SCHED_FIFO de distinta prioridad. Mientras un hilo espera el
+ * mutex, el que lo tiene corre al menos con la prioridad de ese hilo: uno de
+ * prioridad intermedia no puede desalojarlo y dejar esperando sin límite al
+ * de mayor prioridad. El bloqueo queda acotado por la sección crítica más
+ * larga.
+ *
+ * Cumple Lockable, así que se usa con lock_guard y unique_lock. Si el sistema
+ * no soporta el protocolo queda como un mutex común (ver inherits()).
+ */
+class PiMutex {
+private:
+    pthread_mutex_t handle;
+    bool priority_inheritance = true;
+
+public:
+    PiMutex() {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+        if (pthread_mutex_init(&handle, &attr) != 0) {
+            pthread_mutex_init(&handle, nullptr);
+            priority_inheritance = false;
+        }
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    ~PiMutex() { pthread_mutex_destroy(&handle); }
+
+    PiMutex(const PiMutex&) = delete;
+    PiMutex& operator=(const PiMutex&) = delete;
+
+    void lock() { pthread_mutex_lock(&handle); }
+    bool try_lock() { return pthread_mutex_trylock(&handle) == 0; }
+    void unlock() { pthread_mutex_unlock(&handle); }
+
+    /** true si el mutex hereda prioridad */
+    bool inherits() const { return priority_inheritance; }
+
+    pthread_mutex_t* native_handle() { return &handle; }
+};
+
+/**
+ * Clase PiCondition
+ * Variable de condición para usar con PiMutex (la de la biblioteca estándar
+ * solo acepta std::mutex). Los plazos son de CLOCK_MONOTONIC, el mismo reloj
+ * que steady_clock, así que no les afectan los cambios de hora.
+ *
+ * Al despertar, el mutex se vuelve a tomar con herencia de prioridad; el lock
+ * interno de la variable de condición de glibc no la tiene, pero solo se toma
+ * durante la notificación.
+ */
+class PiCondition {
+private:
+    pthread_cond_t handle;
+
+public:
+    using clock = chrono::steady_clock;
+
+    PiCondition() {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&handle, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+
+    ~PiCondition() { pthread_cond_destroy(&handle); }
+
+    PiCondition(const PiCondition&) = delete;
+    PiCondition& operator=(const PiCondition&) = delete;
+
+    void notify_one() { pthread_cond_signal(&handle); }
+    void notify_all() { pthread_cond_broadcast(&handle); }
+
+    void wait(unique_lock<PiMutex>& lock) { pthread_cond_wait(&handle, lock.mutex()->native_handle()); }
+
+    template <typename Predicate>
+    void wait(unique_lock<PiMutex>& lock, Predicate ready) {
+        while (!ready()) wait(lock);
+    }
+
+    cv_status wait_until(unique_lock<PiMutex>& lock, clock::time_point when) {
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(when.time_since_epoch()).count();
+        timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+        int err = pthread_cond_timedwait(&handle, lock.mutex()->native_handle(), &ts);
+        return err == ETIMEDOUT ? cv_status::timeout : cv_status::no_timeout;
+    }
+
+    /**
+     * @return El valor del predicado al salir (false si venció el plazo)
+     */
+    template <typename Predicate>
+    bool wait_until(unique_lock<PiMutex>& lock, clock::time_point when, Predicate ready) {
+        while (!ready()) {
+            if (wait_until(lock, when) == cv_status::timeout) return ready();
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period, typename Predicate>
+    bool wait_for(unique_lock<PiMutex>& lock, chrono::duration<Rep, Period> timeout, Predicate ready) {
+        return wait_until(lock, clock::now() + timeout, ready);
+    }
+};
+
+#endif // RT_MUTEX_H
@@ -0,0 +1,267 @@
+#include "rt_profile.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <alloca.h>
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Aplica una lista "rol=valor,rol=valor" sobre un arreglo por rol.
+ * Las claves desconocidas se informan y se ignoran; `extra` recibe las que
+ * no son roles (por ejemplo `opencv`).
+ */
+void parse_role_list(const char* name, array<int, ROLE_COUNT>& out, string* extra_key = nullptr, string* extra = nullptr) {
+    const char* value = getenv(name);
+    if (!value) return;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) continue;
+        string key = item.substr(0, eq);
+        string val = item.substr(eq + 1);
+        if (extra_key && key == *extra_key) {
+            *extra = val;
+            continue;
+        }
+        bool found = false;
+        for (size_t r = 0; r < ROLE_COUNT; r++) {
+            if (key == ROLE_NAMES[r]) {
+                out[r] = atoi(val.c_str());
+                found = true;
+            }
+        }
+        if (!found) cerr << "[RT] " << name << ": rol desconocido '" << key << "'" << endl;
+    }
+}
+
+/**
+ * Convierte "0-1,3" en un cpu_set_t.
+ */
+bool parse_cpu_list(const string& list, cpu_set_t& set) {
+    CPU_ZERO(&set);
+    stringstream ss(list);
+    string item;
+    int cpus = static_cast<int>(thread::hardware_concurrency());
+    while (getline(ss, item, ',')) {
+        int lo = 0, hi = 0;
+        size_t dash = item.find('-');
+        if (dash == string::npos) {
+            lo = hi = atoi(item.c_str());
+        } else {
+            lo = atoi(item.substr(0, dash).c_str());
+            hi = atoi(item.substr(dash + 1).c_str());
+        }
+        for (int c = lo; c <= hi; c++) {
+            if (c >= 0 && (cpus == 0 || c < cpus)) CPU_SET(c, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0;
+}
+
+/**
+ * Fallos de página del proceso desde el arranque.
+ */
+void page_faults(long& minflt, long& majflt) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    minflt = usage.ru_minflt;
+    majflt = usage.ru_majflt;
+}
+
+} // namespace
+
+void RtProfile::load_from_env() {
+    enabled = env_long("STR_RT", 0) != 0;
+    parse_role_list("STR_RT_PRIO", priority);
+    string opencv_key = "opencv";
+    parse_role_list("STR_RT_CPUS", cpu, &opencv_key, &opencv_cpus);
+    lock_memory = env_long("STR_RT_MLOCK", 1) != 0;
+    heap_reserve = static_cast<size_t>(env_long("STR_RT_HEAP_MB", 16)) << 20;
+    stack_prefault = static_cast<size_t>(env_long("STR_RT_STACK_KB", 256)) << 10;
+    warmup = chrono::milliseconds(env_long("STR_RT_WARMUP_MS", 5000));
+}
+
+void RtProfile::setup_memory() {
+    if (!enabled || !lock_memory) return;
+    lock_guard<PiMutex> lock(report_mutex);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        memory_status = string("mlockall falló: ") + strerror(errno);
+        cerr << "[RT] " << memory_status << endl;
+        return;
+    }
+
+    // Que free() no devuelva memoria al sistema ni se usen mmap sueltos:
+    // lo reservado acá queda tocado y bloqueado para el resto de la ejecución
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (heap_reserve > 0) {
+        char* reserve = static_cast<char*>(malloc(heap_reserve));
+        if (reserve) {
+            long page = sysconf(_SC_PAGESIZE);
+            for (size_t i = 0; i < heap_reserve; i += page) reserve[i] = 0;
+            free(reserve);
+        }
+    }
+    memory_status = "mlockall ok, heap reservado " + to_string(heap_reserve >> 20) + " MB";
+}
+
+void RtProfile::confine_opencv() {
+    if (!enabled || opencv_cpus.empty()) return;
+    cpu_set_t set;
+    if (!parse_cpu_list(opencv_cpus, set)) {
+        lock_guard<PiMutex> lock(report_mutex);
+        opencv_status = "lista de núcleos inválida: " + opencv_cpus;
+        return;
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        lock_guard<PiMutex> lock(report_mutex);
+        opencv_status = "no se pudo fijar la afinidad";
+        return;
+    }
+
+    // El pool de OpenCV se crea en el primer parallel_for_ y sus hilos heredan
+    // esta afinidad; después los hilos de tiempo real fijan la suya propia
+    int threads = CPU_COUNT(&set);
+    cv::setNumThreads(threads);
+    cv::parallel_for_(cv::Range(0, threads), [](const cv::Range&) {});
+
+    lock_guard<PiMutex> lock(report_mutex);
+    opencv_status = "núcleos " + opencv_cpus + ", " + to_string(threads) + " hilos";
+}
+
+void RtProfile::confine_worker() {
+    if (!enabled || opencv_cpus.empty()) return;
+    cpu_set_t set;
+    string status;
+    if (!parse_cpu_list(opencv_cpus, set)) {
+        status = "lista de núcleos inválida: " + opencv_cpus;
+    } else if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        status = "no se pudo fijar la afinidad";
+    } else {
+        status = "núcleos " + opencv_cpus;
+    }
+    lock_guard<PiMutex> lock(report_mutex);
+    worker_status = status;
+}
+
+size_t RtProfile::worker_cpus() const {
+    if (!enabled || opencv_cpus.empty()) return 0;
+    cpu_set_t set;
+    if (!parse_cpu_list(opencv_cpus, set)) return 0;
+    return static_cast<size_t>(CPU_COUNT(&set));
+}
+
+void RtProfile::apply(ThreadRole role) {
+    if (!enabled) return;
+    Applied result = apply_to(role, pthread_self());
+
+    // Toca el stack ahora para que las páginas queden residentes (y bloqueadas)
+    if (stack_prefault > 0) {
+        volatile char* stack = static_cast<volatile char*>(alloca(stack_prefault));
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < stack_prefault; i += page) stack[i] = 0;
+    }
+
+    lock_guard<PiMutex> lock(report_mutex);
+    applied[static_cast<size_t>(role)] = result;
+}
+
+void RtProfile::apply(ThreadRole role, pthread_t handle) {
+    if (!enabled) return;
+    Applied result = apply_to(role, handle);
+    lock_guard<PiMutex> lock(report_mutex);
+    applied[static_cast<size_t>(role)] = result;
+}
+
+RtProfile::Applied RtProfile::apply_to(ThreadRole role, pthread_t handle) {
+    size_t r = static_cast<size_t>(role);
+    Applied result;
+    result.done = true;
+
+    int core = cpu[r];
+    if (core >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        if (pthread_setaffinity_np(handle, sizeof(set), &set) == 0) {
+            result.cpu = core;
+        } else {
+            result.error = "afinidad a cpu " + to_string(core) + " falló";
+        }
+    }
+
+    sched_param param{};
+    param.sched_priority = priority[r];
+    int policy = priority[r] > 0 ? SCHED_FIFO : SCHED_OTHER;
+    if (int err = pthread_setschedparam(handle, policy, &param); err == 0) {
+        result.policy = policy;
+        result.priority = priority[r];
+    } else {
+        result.error += (result.error.empty() ? "" : "; ") + string("SCHED_FIFO falló: ") + strerror(err);
+    }
+
+    // Puede correr en un hilo ya de tiempo real (un trabajador reiniciado): sin iostream
+    if (!result.error.empty()) LOG_WARN("[RT] %s: %s", ROLE_NAMES[r], result.error.c_str());
+    return result;
+}
+
+void RtProfile::mark_warm() {
+    lock_guard<PiMutex> lock(report_mutex);
+    page_faults(warm_minflt, warm_majflt);
+}
+
+void RtProfile::print_report() {
+    lock_guard<PiMutex> lock(report_mutex);
+
+    // Costo del modo de ejecución (hilos o event loop): cambios de contexto y memoria residente
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    cout << "[RT] Proceso: " << usage.ru_nvcsw << " cambios de contexto voluntarios, " << usage.ru_nivcsw
+         << " involuntarios, RSS máximo " << usage.ru_maxrss << " KiB" << endl;
+
+    if (!enabled) {
+        cout << "[RT] Perfil de tiempo real desactivado (STR_RT=1 para activarlo)" << endl;
+        return;
+    }
+
+    cout << "[RT] Perfil de tiempo real:" << endl;
+    for (size_t r = 0; r < ROLE_COUNT; r++) {
+        const Applied& a = applied[r];
+        cout << "  " << ROLE_NAMES[r] << ": ";
+        if (!a.done) {
+            cout << "no aplicado" << endl;
+            continue;
+        }
+        cout << (a.policy == SCHED_FIFO ? "SCHED_FIFO " + to_string(a.priority) : string("SCHED_OTHER"))
+             << ", cpu " << (a.cpu >= 0 ? to_string(a.cpu) : string("libre"));
+        if (!a.error.empty()) cout << " (" << a.error << ")";
+        cout << endl;
+    }
+    cout << "  memoria: " << memory_status << endl;
+    cout << "  opencv: " << opencv_status << endl;
+    cout << "  pool de trabajo: " << worker_status << endl;
+
+    long minflt = 0, majflt = 0;
+    page_faults(minflt, majflt);
+    if (warm_minflt < 0) {
+        cout << "  fallos de página: " << minflt << " menores, " << majflt
+             << " mayores (sin terminar el calentamiento)" << endl;
+    } else {
+        cout << "  fallos de página desde el calentamiento: " << minflt - warm_minflt << " menores, "
+             << majflt - warm_majflt << " mayores" << endl;
+    }
+}
@@ -0,0 +1,159 @@
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include "rt_mutex.h"
+
+using namespace std;
+
+/**
+ * Rol de cada hilo del sistema a efectos de planificación.
+ */
+enum class ThreadRole : uint8_t {
+    Sensor,
+    Barrier,
+    Camera,
+    Communicator,
+    Monitor,      // Monitor de plazos del supervisor
+    Recovery,     // Ejecutor de recuperaciones del supervisor
+    Count
+};
+
+inline constexpr size_t ROLE_COUNT = static_cast<size_t>(ThreadRole::Count);
+
+inline constexpr const char* ROLE_NAMES[ROLE_COUNT] = {
+    "sensor", "barrier", "camera", "communicator", "monitor", "recovery"
+};
+
+/**
+ * Clase RtProfile
+ * Perfil de tiempo real del proceso: prioridad SCHED_FIFO y núcleo por rol de
+ * hilo, memoria bloqueada y confinamiento del pool de hilos de OpenCV.
+ *
+ * Se configura por variables de entorno (todas opcionales):
+ * - STR_RT=1                    Activa el perfil (por defecto todo corre en SCHED_OTHER)
+ * - STR_RT_PRIO=sensor=80,...   Prioridad SCHED_FIFO por rol (0 = SCHED_OTHER)
+ * - STR_RT_CPUS=sensor=3,...    Núcleo por rol (-1 = sin fijar); `opencv=0-1` fija el pool de OpenCV
+ * - STR_RT_MLOCK=0              Desactiva mlockall() y la reserva de heap
+ * - STR_RT_HEAP_MB=16           Heap que se reserva y toca al arrancar
+ * - STR_RT_STACK_KB=256         Stack que cada hilo toca al aplicar su rol
+ * - STR_RT_WARMUP_MS=5000       Duración del calentamiento antes de contar fallos de página
+ *
+ * Por defecto el sensor tiene la prioridad más alta entre los hilos de
+ * trabajo, luego la barrera, la cámara y el comunicador; el monitor del
+ * supervisor está por encima de todos para poder detectar sus cuelgues.
+ */
+class RtProfile {
+public:
+    /** Resultado de aplicar el perfil a un hilo, para el reporte */
+    struct Applied {
+        bool done = false;
+        int policy = SCHED_OTHER;
+        int priority = 0;
+        int cpu = -1;
+        string error;                  // Vacío si todo se aplicó
+    };
+
+    bool enabled = false;
+    array<int, ROLE_COUNT> priority{80, 70, 60, 50, 85, 40};
+    array<int, ROLE_COUNT> cpu{3, 3, 2, 1, 3, 1};
+    string opencv_cpus = "0";          // Lista de núcleos para el pool de OpenCV ("" = sin confinar)
+    bool lock_memory = true;
+    size_t heap_reserve = 16u << 20;
+    size_t stack_prefault = 256u << 10;
+    chrono::milliseconds warmup{5000};
+
+    /**
+     * Carga la configuración de las variables de entorno STR_RT*.
+     */
+    void load_from_env();
+
+    /**
+     * Ajustes de memoria del proceso: mlockall(), malloc sin devolver memoria
+     * al sistema y reserva de heap ya tocada. Llamar al arrancar, antes de
+     * crear los hilos.
+     */
+    void setup_memory();
+
+    /**
+     * Fija el hilo que llama (y los que cree después) a los núcleos de OpenCV
+     * y crea ahí el pool de hilos de OpenCV, para que no compita con los hilos
+     * de tiempo real.
+     */
+    void confine_opencv();
+
+    /**
+     * Fija el hilo que llama (un hilo del WorkerPool) a los núcleos de OpenCV,
+     * fuera de los núcleos de tiempo real, en SCHED_OTHER.
+     */
+    void confine_worker();
+
+    /**
+     * Núcleos para trabajo de fondo (la lista de OpenCV), para dimensionar el
+     * WorkerPool. 0 si el perfil está desactivado o la lista está vacía.
+     */
+    size_t worker_cpus() const;
+
+    /**
+     * Aplica el rol al hilo que llama: afinidad, SCHED_FIFO y stack pretocado.
+     */
+    void apply(ThreadRole role);
+
+    /**
+     * Aplica el rol a otro hilo ya creado (sin pretocar su stack).
+     */
+    void apply(ThreadRole role, pthread_t handle);
+
+    /**
+     * Toma la cuenta de fallos de página al terminar el calentamiento.
+     */
+    void mark_warm();
+
+    /**
+     * Imprime los cambios de contexto y el RSS máximo del proceso, la política
+     * aplicada a cada rol y los fallos de página desde el calentamiento.
+     */
+    void print_report();
+
+private:
+    PiMutex report_mutex;
+    array<Applied, ROLE_COUNT> applied{};
+    string memory_status = "sin configurar";
+    string opencv_status = "sin confinar";
+    string worker_status = "sin confinar";
+    long warm_minflt = -1;
+    long warm_majflt = -1;
+
+    Applied apply_to(ThreadRole role, pthread_t handle);
+};
+
+/**
+ * Lee un entero de una variable de entorno.
+ * @return `fallback` si la variable no existe o no es un número.
+ */
+inline long env_long(const char* name, long fallback) {
+    const char* value = getenv(name);
+    if (!value || !*value) return fallback;
+    char* end = nullptr;
+    long parsed = strtol(value, &end, 10);
+    return (end && *end == '\0') ? parsed : fallback;
+}
+
+/**
+ * Pasa el hilo que llama a SCHED_OTHER. Lo usan los hilos de infraestructura
+ * (log, trazas, métricas, estado compartido, LEDs) al arrancar, para no
+ * heredar la prioridad SCHED_FIFO de quien los crea.
+ */
+inline void set_background_policy() {
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+}
+
+#endif // RT_PROFILE_H
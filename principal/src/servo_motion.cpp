@@ -0,0 +1,222 @@
+#include "servo_motion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <pigpio.h>
+#include "logger.h"
+
+using namespace std;
+using namespace chrono;
+
+ServoProfile ServoProfile::from_env() {
+    ServoProfile p;
+    if (const char* shape = getenv("STR_SERVO_PROFILE"); shape && *shape) {
+        if (strcmp(shape, "trapezoid") == 0) p.shape = MotionShape::Trapezoid;
+        else if (strcmp(shape, "snap") == 0) p.shape = MotionShape::Snap;
+        else if (strcmp(shape, "scurve") == 0) p.shape = MotionShape::SCurve;
+        else LOG_WARN("[SERVO] STR_SERVO_PROFILE desconocido '%s', se usa scurve", shape);
+    }
+    if (const char* ms = getenv("STR_SERVO_MS"); ms && *ms) {
+        long value = strtol(ms, nullptr, 10);
+        if (value >= 100 && value <= 10000) p.duration = milliseconds(value);
+        else LOG_WARN("[SERVO] STR_SERVO_MS fuera de rango (100-10000): %s", ms);
+    }
+    return p;
+}
+
+double motion_position(MotionShape shape, double t, double accel_fraction) {
+    t = clamp(t, 0.0, 1.0);
+    switch (shape) {
+    case MotionShape::Snap:
+        return t;
+    case MotionShape::Trapezoid: {
+        // Área bajo la velocidad = 1: v_max * (1 - ta) con aceleración a = v_max / ta
+        double ta = clamp(accel_fraction, 0.01, 0.5);
+        double v = 1.0 / (1.0 - ta);
+        if (t < ta) return 0.5 * v / ta * t * t;
+        if (t > 1.0 - ta) return 1.0 - 0.5 * v / ta * (1.0 - t) * (1.0 - t);
+        return v * (t - ta / 2);
+    }
+    case MotionShape::SCurve:
+        return t * t * t * (10.0 + t * (-15.0 + 6.0 * t));
+    }
+    return 1.0;
+}
+
+microseconds ServoRamp::time_to(uint32_t width_us) const {
+    if (widths.empty()) return microseconds(0);
+    bool rising = widths.back() >= widths.front();
+    for (size_t i = 0; i < widths.size(); i++) {
+        if (rising ? widths[i] >= width_us : widths[i] <= width_us) return microseconds(uint64_t(i) * frame_us);
+    }
+    return duration();
+}
+
+uint32_t ServoRamp::width_at(nanoseconds elapsed) const {
+    if (widths.empty()) return 0;
+    if (elapsed < nanoseconds::zero()) return widths.front();
+    size_t frame = static_cast<size_t>(elapsed.count() / (int64_t(frame_us) * 1000));
+    return widths[min(frame, widths.size() - 1)];
+}
+
+ServoRamp plan_servo_ramp(uint32_t from_us, uint32_t to_us, microseconds duration, const ServoProfile& profile) {
+    ServoRamp ramp;
+    ramp.frame_us = profile.frame_us;
+    size_t frames = max<size_t>(1, static_cast<size_t>((duration.count() + profile.frame_us - 1) / profile.frame_us));
+    ramp.widths.reserve(frames);
+    double span = static_cast<double>(to_us) - static_cast<double>(from_us);
+    // Cada cuadro lleva la posición del final de su intervalo: el último es exactamente `to_us`
+    for (size_t i = 1; i <= frames; i++) {
+        double s = motion_position(profile.shape, static_cast<double>(i) / frames, profile.accel_fraction);
+        ramp.widths.push_back(static_cast<uint16_t>(lround(from_us + span * s)));
+    }
+    return ramp;
+}
+
+ServoMotion::ServoMotion(unsigned gpio, uint32_t closed_us, uint32_t open_us, ServoProfile profile)
+    : gpio(gpio), closed_us(closed_us), open_us(open_us), config(profile) {
+    open_ramp = plan_servo_ramp(closed_us, open_us, duration_cast<microseconds>(config.duration), config);
+    close_ramp = plan_servo_ramp(open_us, closed_us, duration_cast<microseconds>(config.duration), config);
+}
+
+ServoMotion::~ServoMotion() {
+    release();
+}
+
+bool ServoMotion::init() {
+    if (config.shape == MotionShape::Snap) return false;
+    gpioSetMode(gpio, PI_OUTPUT);
+
+    open_wave = create_wave(open_ramp.widths);
+    close_wave = create_wave(close_ramp.widths);
+    hold_open_wave = create_wave({static_cast<uint16_t>(open_us)});
+    hold_closed_wave = create_wave({static_cast<uint16_t>(closed_us)});
+    waves_ready = open_wave >= 0 && close_wave >= 0 && hold_open_wave >= 0 && hold_closed_wave >= 0;
+    if (!waves_ready) {
+        for (int* wave : {&open_wave, &close_wave, &hold_open_wave, &hold_closed_wave}) delete_wave(*wave);
+        LOG_WARN("[SERVO] No se pudieron crear las ondas; se usa gpioServo sin rampa");
+        return false;
+    }
+    LOG_INFO("[SERVO] Rampas de %lld ms (%zu cuadros) por DMA", static_cast<long long>(config.duration.count()),
+             open_ramp.widths.size());
+    return true;
+}
+
+ServoMove ServoMotion::move(bool open, clock::time_point now) {
+    uint32_t target = open ? open_us : closed_us;
+    uint32_t from = position_known ? position(now) : target;
+
+    // Posición desconocida o ya en destino: solo se sostiene. Desde el otro
+    // extremo se usa la rampa completa; desde el medio (inversión), una parcial.
+    const ServoRamp* ramp = nullptr;
+    int wave = -1;
+    if (from != target) {
+        if (from == (open ? closed_us : open_us)) {
+            ramp = open ? &open_ramp : &close_ramp;
+            wave = open ? open_wave : close_wave;
+        } else {
+            partial_ramp = plan_servo_ramp(from, target, scaled_duration(from, target), config);
+            ramp = &partial_ramp;
+            if (waves_ready) {
+                // La onda parcial anterior puede estar en transmisión: se detiene antes de borrarla
+                gpioWaveTxStop();
+                delete_wave(partial_wave);
+                partial_wave = create_wave(partial_ramp.widths);
+                wave = partial_wave;
+            }
+        }
+    }
+
+    ServoMove result;
+    if (waves_ready) {
+        result.ok = (!ramp || wave >= 0) && transmit(wave, open ? hold_open_wave : hold_closed_wave);
+    } else {
+        result.ok = gpioServo(gpio, target) == 0;
+    }
+    if (!result.ok) {
+        position_known = false;
+        return result;
+    }
+
+    current = ramp;
+    started = now;
+    hold_us = target;
+    position_known = true;
+    if (ramp) {
+        result.settled = ramp->duration();
+        result.passable = open ? ramp->time_to(passable_us()) : nanoseconds(0);
+    }
+    return result;
+}
+
+void ServoMotion::stop() {
+    if (waves_ready) gpioWaveTxStop();
+    gpioServo(gpio, 0);
+    gpioWrite(gpio, 0);
+    position_known = false;
+}
+
+void ServoMotion::release() {
+    if (!waves_ready) return;
+    gpioWaveTxStop();
+    for (int* wave : {&open_wave, &close_wave, &hold_open_wave, &hold_closed_wave, &partial_wave}) delete_wave(*wave);
+    waves_ready = false;
+    current = nullptr;
+}
+
+uint32_t ServoMotion::passable_us() const {
+    return closed_us + static_cast<uint32_t>(lround((static_cast<double>(open_us) - closed_us) * config.passable_fraction));
+}
+
+microseconds ServoMotion::scaled_duration(uint32_t from_us, uint32_t to_us) const {
+    double stroke = fabs(static_cast<double>(open_us) - static_cast<double>(closed_us));
+    double part = fabs(static_cast<double>(to_us) - static_cast<double>(from_us));
+    return microseconds(static_cast<int64_t>(duration_cast<microseconds>(config.duration).count() * min(1.0, part / stroke)));
+}
+
+uint32_t ServoMotion::position(clock::time_point now) const {
+    if (!current) return hold_us;
+    return current->width_at(now - started);
+}
+
+/**
+ * Arma una onda con un cuadro por ancho: pulso alto de `w` µs y bajo el resto del período.
+ * @return id de la onda o -1 si pigpio no pudo crearla
+ */
+int ServoMotion::create_wave(const vector<uint16_t>& widths) {
+    vector<gpioPulse_t> pulses;
+    pulses.reserve(widths.size() * 2);
+    uint32_t mask = 1u << gpio;
+    for (uint16_t w : widths) {
+        pulses.push_back({mask, 0, w});
+        pulses.push_back({0, mask, config.frame_us - w});
+    }
+    gpioWaveAddNew();
+    if (gpioWaveAddGeneric(static_cast<unsigned>(pulses.size()), pulses.data()) < 0) return -1;
+    int wave = gpioWaveCreate();
+    return wave >= 0 ? wave : -1;
+}
+
+/**
+ * Reemplaza la cadena en transmisión por `motion_wave` (si hay) seguida del
+ * sostén repetido para siempre.
+ */
+bool ServoMotion::transmit(int motion_wave, int hold_wave) {
+    gpioWaveTxStop();
+    gpioServo(gpio, 0);
+    char chain[8];
+    unsigned len = 0;
+    if (motion_wave >= 0) chain[len++] = static_cast<char>(motion_wave);
+    chain[len++] = static_cast<char>(255);
+    chain[len++] = 0;
+    chain[len++] = static_cast<char>(hold_wave);
+    chain[len++] = static_cast<char>(255);
+    chain[len++] = 3;
+    return gpioWaveChain(chain, len) == 0;
+}
+
+void ServoMotion::delete_wave(int& wave) {
+    if (wave >= 0) gpioWaveDelete(static_cast<unsigned>(wave));
+    wave = -1;
+}
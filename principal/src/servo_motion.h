@@ -0,0 +1,151 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/** Forma de la rampa de posición del servo */
+enum class MotionShape : uint8_t {
+    Snap,          // Salto directo con gpioServo, como antes; la posición se estima lineal en `duration`
+    Trapezoid,     // Velocidad trapezoidal: aceleración constante, crucero, frenado constante
+    SCurve         // Polinomio de jerk mínimo: velocidad y aceleración nulas en los extremos
+};
+
+/**
+ * Perfil de movimiento del brazo. Se configura por variables de entorno:
+ * - STR_SERVO_PROFILE=scurve|trapezoid|snap   Forma de la rampa (scurve por defecto)
+ * - STR_SERVO_MS=800                          Duración de un recorrido completo
+ */
+struct ServoProfile {
+    MotionShape shape = MotionShape::SCurve;
+    chrono::milliseconds duration{800};      // Recorrido completo; uno parcial dura proporcionalmente
+    double accel_fraction = 0.25;            // Trapezoidal: fracción del tiempo acelerando (y frenando)
+    double passable_fraction = 0.85;         // Fracción de la apertura a partir de la cual pasa un vehículo
+    uint32_t frame_us = 20000;               // Período de pulsos del servo (50 Hz)
+
+    static ServoProfile from_env();
+};
+
+/**
+ * Posición normalizada (0..1) de la forma `shape` en el instante normalizado `t` (0..1).
+ */
+double motion_position(MotionShape shape, double t, double accel_fraction = 0.25);
+
+/**
+ * Rampa precalculada: un ancho de pulso por cuadro del servo. También es la
+ * estimación de la posición del brazo, que no tiene realimentación.
+ */
+struct ServoRamp {
+    vector<uint16_t> widths;                 // Ancho de pulso de cada cuadro (µs)
+    uint32_t frame_us = 20000;
+
+    chrono::microseconds duration() const { return chrono::microseconds(uint64_t(widths.size()) * frame_us); }
+
+    /**
+     * Instante (desde el inicio de la rampa) del primer cuadro que alcanza `width_us`
+     * en el sentido del movimiento; la duración completa si nunca lo alcanza.
+     */
+    chrono::microseconds time_to(uint32_t width_us) const;
+
+    /** Ancho de pulso estimado a `elapsed` del inicio (el último si ya terminó) */
+    uint32_t width_at(chrono::nanoseconds elapsed) const;
+};
+
+/**
+ * Calcula la rampa de `from_us` a `to_us` en `duration`, con al menos un cuadro.
+ */
+ServoRamp plan_servo_ramp(uint32_t from_us, uint32_t to_us, chrono::microseconds duration,
+                          const ServoProfile& profile);
+
+/**
+ * Predicción de un movimiento iniciado.
+ */
+struct ServoMove {
+    bool ok = false;
+    chrono::nanoseconds passable{0};         // Hasta que el brazo deja pasar (0 si ya deja o si cierra)
+    chrono::nanoseconds settled{0};          // Hasta que el brazo termina el recorrido
+};
+
+/**
+ * Clase ServoMotion
+ * Mueve el servo de la barrera con rampas suaves transmitidas por DMA como
+ * ondas de pigpio: cada movimiento es una cadena `rampa + sostén para siempre`
+ * (gpioWaveChain), así el pulso de cada cuadro sale con tiempo exacto y sin
+ * CPU, y el brazo queda sostenido en la posición final. Las rampas de
+ * recorrido completo se crean una vez al iniciar; solo una inversión a mitad
+ * de camino arma una onda nueva desde la posición estimada.
+ *
+ * El motor de ondas de pigpio es uno solo por proceso: ningún otro módulo debe
+ * transmitir ondas mientras el servo lo usa. Si las ondas no están disponibles
+ * (o el perfil es Snap) se usa gpioServo con la duración del perfil como
+ * estimación del recorrido.
+ */
+class ServoMotion {
+public:
+    using clock = chrono::steady_clock;
+
+    ServoMotion(unsigned gpio, uint32_t closed_us, uint32_t open_us, ServoProfile profile = ServoProfile::from_env());
+    ~ServoMotion();
+
+    ServoMotion(const ServoMotion&) = delete;
+    ServoMotion& operator=(const ServoMotion&) = delete;
+
+    /**
+     * Crea las ondas de recorrido completo y de sostén.
+     * @return false si no pudieron crearse (queda en modo gpioServo)
+     */
+    bool init();
+
+    /**
+     * Inicia el movimiento hacia abierta o cerrada desde la posición actual.
+     * Si la posición es desconocida (primer comando) va directo, sin rampa.
+     */
+    ServoMove move(bool open, clock::time_point now);
+
+    /** Detiene las ondas y corta los pulsos del servo (apagado y modo seguro) */
+    void stop();
+
+    /**
+     * Detiene la transmisión y borra las ondas; después el servo sigue con
+     * gpioServo. Debe llamarse antes de gpioTerminate(): el destructor solo
+     * libera lo que quedó y, en un objeto estático, corre después.
+     */
+    void release();
+
+    bool using_waves() const { return waves_ready; }
+    const ServoProfile& profile() const { return config; }
+
+private:
+    unsigned gpio;
+    uint32_t closed_us;
+    uint32_t open_us;
+    ServoProfile config;
+    bool waves_ready = false;
+
+    ServoRamp open_ramp;                      // Recorrido completo cerrada -> abierta
+    ServoRamp close_ramp;                     // Recorrido completo abierta -> cerrada
+    int open_wave = -1;
+    int close_wave = -1;
+    int hold_open_wave = -1;
+    int hold_closed_wave = -1;
+    int partial_wave = -1;                    // Onda de la última inversión (se borra en la siguiente)
+    ServoRamp partial_ramp;
+
+    // Movimiento en curso, para estimar la posición al invertir
+    const ServoRamp* current = nullptr;      // nullptr = sostenido en `hold_us`
+    clock::time_point started{};
+    uint32_t hold_us = 0;
+    bool position_known = false;
+
+    uint32_t passable_us() const;
+    chrono::microseconds scaled_duration(uint32_t from_us, uint32_t to_us) const;
+    uint32_t position(clock::time_point now) const;
+    int create_wave(const vector<uint16_t>& widths);
+    bool transmit(int motion_wave, int hold_wave);
+    void delete_wave(int& wave);
+};
+
+#endif // SERVO_MOTION_H
@@ -1,52 +1,479 @@
 #ifndef SHARED_DATA_H
 #define SHARED_DATA_H
 
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <string>
-#include <mutex>
-#include <condition_variable>
+#include <vector>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "futex_signal.h"
+#include "ring_buffer.h"
+#include "event_channel.h"
+#include "rt_mutex.h"
+#include "vehicle_event.h"
 using namespace std;
 
 /**
- * Bandera global atómica que indica si se debe levantar la barrera.
- * Puede ser modificada por distintos hilos para coordinar el acceso.
+ * Contador global de eventos de vehículo. Cada detección recibe un id único
+ * que acompaña al vehículo por todas las etapas del pipeline.
  */
-inline atomic<bool> lift_barrier(false);
+inline atomic<uint64_t> event_id_counter(0);
+
+/**
+ * Devuelve un nuevo id de evento de vehículo.
+ */
+inline uint64_t next_event_id() {
+    return event_id_counter.fetch_add(1, memory_order_relaxed) + 1;
+}
+
+/**
+ * Estadísticas exportadas por la cola de eventos.
+ */
+struct QueueStats {
+    size_t live_depth = 0;          // Eventos vigentes en espera
+    size_t background_depth = 0;    // Eventos vencidos en el carril de auditoría
+    uint64_t pushed = 0;            // Total de eventos insertados
+    uint64_t demoted = 0;           // Eventos degradados a auditoría (vencidos o desplazados)
+    uint64_t dropped = 0;           // Eventos descartados por desborde del carril de auditoría
+    uint64_t dequeued = 0;          // Total de eventos entregados
+    chrono::microseconds last_age{0};   // Edad del último evento entregado
+    chrono::microseconds max_age{0};    // Máxima edad observada al desencolar
+    chrono::microseconds total_age{0};  // Suma de edades (para calcular el promedio)
+};
+
+/**
+ * Capacidad por defecto de los carriles de una cola de fotos. Entre los dos
+ * deben quedar lejos de VehiclePool::CAPACITY: un registro en auditoría solo
+ * se libera cuando su carril se llena, y si el carril pudiera retener casi
+ * todo el pool, con un backend lento el sensor se quedaría sin registros
+ * para el vehículo que está en la barrera.
+ */
+inline constexpr size_t LIVE_CAPACITY = 8;
+inline constexpr size_t AUDIT_CAPACITY = 8;
+static_assert(LIVE_CAPACITY + AUDIT_CAPACITY <= VehiclePool::CAPACITY / 2,
+              "las colas de fotos no deben poder retener la mitad del pool de vehículos");
+
+/**
+ * Clase DeadlineQueue
+ * Política de planificación de eventos de foto con plazos. No es segura para
+ * múltiples hilos: la usa un único dueño (el consumidor) o un envoltorio con lock.
+ *
+ * - Los eventos vigentes se entregan primero. Cada carril tiene a lo sumo uno:
+ *   al llegar uno más nuevo, los anteriores del mismo carril (vehículos que
+ *   ya se fueron) pasan a auditoría. Entre carriles va el de plazo más próximo.
+ * - Los eventos cuyo plazo venció se degradan a un carril de auditoría que
+ *   solo se atiende cuando no hay eventos vigentes.
+ * - Si el carril vigente se llena, el evento más viejo pasa a auditoría;
+ *   si se llena el de auditoría, se descarta su evento más viejo.
+ */
+class DeadlineQueue {
+public:
+    using clock = chrono::steady_clock;
+
+private:
+    vector<VehicleEvent*> live;          // Eventos vigentes (acotado por live_capacity)
+    deque<VehicleEvent*> background;     // Eventos vencidos, en orden de llegada
+    size_t live_capacity;
+    size_t background_capacity;
+    QueueStats counters;
+
+    /**
+     * Pasa al carril de auditoría un evento vigente.
+     */
+    void demote(VehicleEvent* ev) {
+        ev->stale = true;
+        counters.demoted++;
+        if (background.size() >= background_capacity) {
+            release_vehicle(background.front());
+            background.pop_front();
+            counters.dropped++;
+        }
+        background.push_back(move(ev));
+    }
+
+    /**
+     * Elige el próximo evento vigente: el de plazo más próximo (hay uno por
+     * carril). Requiere `live` no vacío.
+     */
+    size_t select_live() const {
+        size_t best = 0;
+        for (size_t i = 1; i < live.size(); i++) {
+            if (live[i]->deadline < live[best]->deadline) best = i;
+        }
+        return best;
+    }
+
+public:
+    /**
+     * @param live_capacity Máximo de eventos vigentes en espera
+     * @param background_capacity Máximo de eventos retenidos para auditoría
+     */
+    explicit DeadlineQueue(size_t live_capacity = LIVE_CAPACITY, size_t background_capacity = AUDIT_CAPACITY)
+        : live_capacity(live_capacity), background_capacity(background_capacity) {
+        live.reserve(live_capacity);
+    }
+
+    /**
+     * Degrada todos los eventos vigentes cuyo plazo ya venció.
+     */
+    void demote_expired(clock::time_point now) {
+        for (size_t i = 0; i < live.size();) {
+            if (live[i]->deadline <= now) {
+                demote(live[i]);
+                live.erase(live.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    /**
+     * Agrega un evento, degradándolo si ya está vencido.
+     */
+    void push(VehicleEvent* ev, clock::time_point now) {
+        counters.pushed++;
+        demote_expired(now);
+
+        if (ev->deadline <= now) {
+            demote(ev);
+            return;
+        }
+
+        // Solo el más nuevo de cada carril sigue vigente
+        for (size_t i = 0; i < live.size();) {
+            if (live[i]->lane != ev->lane) {
+                i++;
+            } else if (live[i]->trigger_time() > ev->trigger_time()) {
+                demote(ev);
+                return;
+            } else {
+                demote(live[i]);
+                live.erase(live.begin() + i);
+            }
+        }
+        if (live.size() >= live_capacity) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < live.size(); i++) {
+                if (live[i]->trigger_time() < live[oldest]->trigger_time()) oldest = i;
+            }
+            demote(live[oldest]);
+            live.erase(live.begin() + oldest);
+        }
+        live.push_back(ev);
+    }
+
+    /**
+     * Extrae el próximo evento según la política: vigentes primero y, si no
+     * hay ninguno, el más viejo del carril de auditoría (con `stale = true`).
+     * @return false si no hay eventos
+     */
+    bool pop(VehicleEvent*& out, clock::time_point now) {
+        demote_expired(now);
+
+        if (!live.empty()) {
+            size_t idx = select_live();
+            out = live[idx];
+            live.erase(live.begin() + idx);
+        } else if (!background.empty()) {
+            out = background.front();
+            background.pop_front();
+        } else {
+            return false;
+        }
+
+        auto age = chrono::duration_cast<chrono::microseconds>(now - out->trigger_time());
+        counters.dequeued++;
+        counters.last_age = age;
+        counters.total_age += age;
+        if (age > counters.max_age) counters.max_age = age;
+        return true;
+    }
+
+    /**
+     * Cuenta un evento que se perdió antes de llegar a la cola (por ejemplo, buffer lleno).
+     * El registro lo devuelve al pool quien no pudo insertarlo.
+     */
+    void count_drop() {
+        counters.pushed++;
+        counters.dropped++;
+    }
+
+    bool empty() const { return live.empty() && background.empty(); }
+
+    /**
+     * Devuelve una copia de las estadísticas actuales.
+     */
+    QueueStats stats() const {
+        QueueStats snapshot = counters;
+        snapshot.live_depth = live.size();
+        snapshot.background_depth = background.size();
+        return snapshot;
+    }
+};
 
 /**
  * Clase SharedQueue
- * Cola segura para múltiples hilos, utilizada para almacenar rutas de fotos.
- * Proporciona mecanismos de sincronización usando mutex y condition_variable.
+ * Versión con mutex (PiMutex) y variable de condición de la cola de eventos con plazos.
+ * Se conserva como referencia para comparar contra PhotoChannel (ver bench/queue_bench.cpp).
  */
 class SharedQueue {
 private:
-    queue<string> photo_paths;        // Cola de rutas de archivos (ej. imágenes capturadas)
-    mutex mtx;                        // Mutex para acceso exclusivo
-    condition_variable cv;           // Variable de condición para notificación entre hilos
+    DeadlineQueue queue;
+    PiMutex mtx;                      // Mutex para acceso exclusivo (con herencia de prioridad)
+    PiCondition cv;                  // Variable de condición para notificación entre hilos
 
 public:
+    explicit SharedQueue(size_t live_capacity = LIVE_CAPACITY, size_t background_capacity = AUDIT_CAPACITY)
+        : queue(live_capacity, background_capacity) {}
+
     /**
-     * Inserta una nueva ruta de foto en la cola y notifica a los hilos en espera.
-     * @param path Ruta al archivo (ej. imagen)
+     * Inserta un nuevo evento en la cola y notifica a los hilos en espera.
+     * @param ev Vehículo con foto, instante de disparo y plazo
      */
-    void push(const string& path) {
-        lock_guard<mutex> lock(mtx);
-        photo_paths.push(path);
+    void push(VehicleEvent* ev) {
+        lock_guard<PiMutex> lock(mtx);
+        queue.push(ev, DeadlineQueue::clock::now());
         cv.notify_one();
     }
 
     /**
-     * Espera hasta que haya un elemento en la cola y lo devuelve.
-     * Bloquea el hilo si la cola está vacía hasta que se inserte un nuevo valor.
-     * @return La ruta de foto al frente de la cola.
+     * Espera hasta que haya un evento y lo devuelve según la política de plazos.
+     * @return El evento a procesar.
      */
-    string wait_and_pop() {
-        unique_lock<mutex> lock(mtx);
-        cv.wait(lock, [this] { return !photo_paths.empty(); });
-        string path = photo_paths.front();
-        photo_paths.pop();
-        return path;
+    VehicleEvent* wait_and_pop() {
+        unique_lock<PiMutex> lock(mtx);
+        cv.wait(lock, [this] { return !queue.empty(); });
+        VehicleEvent* ev = nullptr;
+        queue.pop(ev, DeadlineQueue::clock::now());
+        return ev;
+    }
+
+    /**
+     * Devuelve una copia de las estadísticas actuales de la cola.
+     */
+    QueueStats stats() {
+        lock_guard<PiMutex> lock(mtx);
+        queue.demote_expired(DeadlineQueue::clock::now());
+        return queue.stats();
+    }
+};
+
+/**
+ * Clase PhotoChannel
+ * Canal de vehículos con foto entre la cámara (productores) y el comunicador (único consumidor).
+ *
+ * Los productores insertan sin locks en un MpscRing y despiertan al consumidor
+ * mediante un futex. El consumidor vuelca el buffer en su DeadlineQueue privada
+ * y aplica ahí la política de plazos, por lo que ningún hilo de tiempo real
+ * queda bloqueado en un mutex que tenga otro hilo.
+ *
+ * Si el consumidor además espera sockets (ver pop_or_poll()), duerme en un
+ * poll sobre el eventfd del canal en lugar del futex; los productores solo
+ * escriben en él mientras el consumidor está en esa espera.
+ */
+class PhotoChannel {
+private:
+    static constexpr size_t RING_CAPACITY = 16;
+
+    MpscRing<VehicleEvent*, RING_CAPACITY> ring;
+    FutexSignal signal;
+    int wake_fd = -1;                 // eventfd para la espera con sockets
+    atomic<bool> fd_waiting{false};   // El consumidor duerme en un poll sobre wake_fd
+    DeadlineQueue queue;              // Solo la toca el hilo consumidor
+    atomic<uint64_t> ring_drops{0};   // Eventos rechazados por buffer lleno
+
+    // Copia publicada de las estadísticas para lectores de otros hilos
+    atomic<size_t> pub_live_depth{0};
+    atomic<size_t> pub_background_depth{0};
+    atomic<uint64_t> pub_pushed{0};
+    atomic<uint64_t> pub_demoted{0};
+    atomic<uint64_t> pub_dropped{0};
+    atomic<uint64_t> pub_dequeued{0};
+    atomic<int64_t> pub_last_age_us{0};
+    atomic<int64_t> pub_max_age_us{0};
+    atomic<int64_t> pub_total_age_us{0};
+
+    /**
+     * Mueve al DeadlineQueue todo lo pendiente en el buffer. Solo el consumidor.
+     */
+    void drain(DeadlineQueue::clock::time_point now) {
+        VehicleEvent* ev = nullptr;
+        while (ring.try_pop(ev)) {
+            queue.push(ev, now);
+        }
+        for (uint64_t d = ring_drops.exchange(0, memory_order_relaxed); d > 0; d--) {
+            queue.count_drop();
+        }
+    }
+
+    /**
+     * Despierta al consumidor, en el futex o en el eventfd según dónde espere.
+     */
+    void notify() {
+        signal.notify();
+        if (fd_waiting.load(memory_order_seq_cst)) {
+            uint64_t one = 1;
+            (void)!write(wake_fd, &one, sizeof(one));
+        }
+    }
+
+    void publish() {
+        QueueStats s = queue.stats();
+        pub_live_depth.store(s.live_depth, memory_order_relaxed);
+        pub_background_depth.store(s.background_depth, memory_order_relaxed);
+        pub_pushed.store(s.pushed, memory_order_relaxed);
+        pub_demoted.store(s.demoted, memory_order_relaxed);
+        pub_dropped.store(s.dropped, memory_order_relaxed);
+        pub_dequeued.store(s.dequeued, memory_order_relaxed);
+        pub_last_age_us.store(s.last_age.count(), memory_order_relaxed);
+        pub_max_age_us.store(s.max_age.count(), memory_order_relaxed);
+        pub_total_age_us.store(s.total_age.count(), memory_order_relaxed);
+    }
+
+public:
+    explicit PhotoChannel(size_t live_capacity = LIVE_CAPACITY, size_t background_capacity = AUDIT_CAPACITY)
+        : queue(live_capacity, background_capacity) {
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    ~PhotoChannel() {
+        if (wake_fd >= 0) close(wake_fd);
+    }
+
+    /**
+     * Inserta un evento sin bloquear. Puede llamarse desde cualquier hilo.
+     * @return false si el buffer estaba lleno; el registro sigue siendo del llamador
+     */
+    bool push(VehicleEvent* ev) {
+        bool ok = ring.try_push(move(ev));
+        if (!ok) ring_drops.fetch_add(1, memory_order_relaxed);
+        notify();
+        return ok;
+    }
+
+    /**
+     * Espera hasta que haya un evento y lo devuelve según la política de plazos.
+     * Solo puede llamarlo el hilo consumidor.
+     */
+    VehicleEvent* wait_and_pop() {
+        VehicleEvent* ev = nullptr;
+        for (;;) {
+            uint32_t seq = signal.prepare();
+            auto now = DeadlineQueue::clock::now();
+            drain(now);
+            if (queue.pop(ev, now)) {
+                publish();
+                return ev;
+            }
+            signal.wait(seq);
+        }
+    }
+
+    /**
+     * Igual que wait_and_pop() pero con tiempo máximo de espera.
+     * @param out Evento extraído
+     * @param timeout Tiempo máximo de espera
+     * @return false si venció el tiempo sin eventos
+     */
+    bool wait_and_pop(VehicleEvent*& out, chrono::nanoseconds timeout) {
+        auto deadline = DeadlineQueue::clock::now() + timeout;
+        for (;;) {
+            uint32_t seq = signal.prepare();
+            auto now = DeadlineQueue::clock::now();
+            drain(now);
+            if (queue.pop(out, now)) {
+                publish();
+                return true;
+            }
+            if (now >= deadline) return false;
+            signal.wait_for(seq, deadline - now);
+        }
+    }
+
+    /**
+     * Espera un evento, un wake() o el instante límite, lo que ocurra primero.
+     * Solo el consumidor, que además atiende otro estado (ver EventChannel).
+     * @return true si extrajo un evento
+     */
+    bool pop_or_wait_until(VehicleEvent*& out, DeadlineQueue::clock::time_point deadline) {
+        uint32_t seq = signal.prepare();
+        auto now = DeadlineQueue::clock::now();
+        drain(now);
+        if (!queue.pop(out, now)) {
+            if (now >= deadline) return false;
+            signal.wait_until(seq, deadline);
+            now = DeadlineQueue::clock::now();
+            drain(now);
+            if (!queue.pop(out, now)) return false;
+        }
+        publish();
+        return true;
+    }
+
+    /**
+     * Como pop_or_wait_until(), pero la espera la hace `wait(fd)`, que debe
+     * volver cuando `fd` sea legible o a más tardar en `deadline`. Sirve para
+     * esperar a la vez los sockets de otra fuente, por ejemplo con curl_multi_poll().
+     * Sin eventfd se degrada a pop_or_wait_until().
+     * @return true si extrajo un evento
+     */
+    template <typename Wait>
+    bool pop_or_poll(VehicleEvent*& out, DeadlineQueue::clock::time_point deadline, Wait&& wait) {
+        if (wake_fd < 0) return pop_or_wait_until(out, deadline);
+        // Como en FutexSignal: se anuncia la espera antes de mirar el buffer,
+        // así un push que no vio la marca ya es visible en el drain
+        fd_waiting.store(true, memory_order_seq_cst);
+        (void)signal.prepare();
+        auto now = DeadlineQueue::clock::now();
+        drain(now);
+        bool popped = queue.pop(out, now);
+        if (!popped) {
+            wait(wake_fd);
+            fd_waiting.store(false, memory_order_seq_cst);
+            uint64_t count = 0;
+            (void)!read(wake_fd, &count, sizeof(count));
+            now = DeadlineQueue::clock::now();
+            drain(now);
+            popped = queue.pop(out, now);
+        }
+        fd_waiting.store(false, memory_order_seq_cst);
+        if (popped) publish();
+        return popped;
+    }
+
+    /**
+     * Despierta al consumidor sin publicar nada.
+     */
+    void wake() {
+        notify();
+    }
+
+    /**
+     * Devuelve las estadísticas publicadas por el consumidor en su última operación.
+     * Puede llamarse desde cualquier hilo.
+     */
+    QueueStats stats() const {
+        QueueStats s;
+        s.live_depth = pub_live_depth.load(memory_order_relaxed) + ring.size();
+        s.background_depth = pub_background_depth.load(memory_order_relaxed);
+        s.pushed = pub_pushed.load(memory_order_relaxed);
+        s.demoted = pub_demoted.load(memory_order_relaxed);
+        s.dropped = pub_dropped.load(memory_order_relaxed) + ring_drops.load(memory_order_relaxed);
+        s.dequeued = pub_dequeued.load(memory_order_relaxed);
+        s.last_age = chrono::microseconds(pub_last_age_us.load(memory_order_relaxed));
+        s.max_age = chrono::microseconds(pub_max_age_us.load(memory_order_relaxed));
+        s.total_age = chrono::microseconds(pub_total_age_us.load(memory_order_relaxed));
+        return s;
     }
 };
 
+/** Canal sensor -> cámara con los vehículos detectados */
+using TriggerChannel = EventChannel<VehicleEvent*, 16>;
+
+/** Canal comunicador -> barrera con los vehículos ya decididos */
+using DecisionChannel = EventChannel<VehicleEvent*, 16>;
+
 #endif
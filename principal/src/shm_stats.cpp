@@ -0,0 +1,150 @@
+#include "shm_stats.h"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rt_profile.h"
+
+using namespace std;
+using namespace chrono;
+
+StatsPublisher::~StatsPublisher() {
+    stop();
+}
+
+bool StatsPublisher::start(const string& requested) {
+    if (segment) return true;
+    name = requested;
+    if (name.empty()) {
+        const char* env = getenv("STR_SHM_NAME");
+        name = env && *env ? env : STATS_DEFAULT_NAME;
+    }
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+    bool ok = ftruncate(fd, sizeof(StatsSegment)) == 0;
+    void* mem = ok ? mmap(nullptr, sizeof(StatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // El encabezado se escribe último: un lector nunca ve la versión nueva con datos a medio iniciar
+    segment = static_cast<StatsSegment*>(mem);
+    segment->magic = 0;
+    segment->seq.store(0, memory_order_relaxed);
+    segment->payload = StatsPayload{};
+    segment->version = STATS_VERSION;
+    segment->payload_size = sizeof(StatsPayload);
+    segment->reserved = 0;
+    atomic_thread_fence(memory_order_release);
+    segment->magic = STATS_MAGIC;
+
+    publish(ProcessState::Starting);
+    running = true;
+    publisher = thread(&StatsPublisher::publish_loop, this);
+    return true;
+}
+
+void StatsPublisher::stop() {
+    if (running.exchange(false)) {
+        wake.notify();
+        if (publisher.joinable()) publisher.join();
+    }
+    if (!segment) return;
+    publish(ProcessState::Stopping);
+    munmap(segment, sizeof(StatsSegment));
+    shm_unlink(name.c_str());
+    segment = nullptr;
+}
+
+/**
+ * Hilo publicador: en SCHED_OTHER, arma el estado cada `period` y lo copia al segmento.
+ */
+void StatsPublisher::publish_loop() {
+    set_background_policy();
+
+    auto next = steady_clock::now();
+    while (running.load(memory_order_acquire)) {
+        publish(ProcessState::Running);
+        next += period;
+        uint32_t seq = wake.prepare();
+        if (!running.load(memory_order_acquire)) break;
+        wake.wait_until(seq, next);
+    }
+}
+
+/**
+ * Arma el estado fuera del segmento y lo copia dentro del seqlock, para que
+ * la ventana en la que los lectores reintentan sea solo la de la copia.
+ */
+void StatsPublisher::publish(ProcessState state) {
+    scratch = StatsPayload{};
+    if (fill) fill(scratch);
+    scratch.pid = static_cast<int32_t>(getpid());
+    scratch.state = state;
+    scratch.updated_ns = steady_clock::now().time_since_epoch().count();
+    scratch.publish_count = segment->payload.publish_count + 1;
+
+    uint64_t seq = segment->seq.load(memory_order_relaxed);
+    segment->seq.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&segment->payload, &scratch, sizeof(StatsPayload));
+    segment->seq.store(seq + 2, memory_order_release);
+}
+
+StatsReader::~StatsReader() {
+    if (segment) munmap(const_cast<StatsSegment*>(segment), mapped_size);
+}
+
+bool StatsReader::open(const string& name, string& error) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error = "no existe el segmento " + name + " (¿str_project no está corriendo?)";
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(StatsSegment)) {
+        close(fd);
+        error = "el segmento " + name + " tiene un tamaño inesperado";
+        return false;
+    }
+    void* mem = mmap(nullptr, sizeof(StatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        error = "no se pudo mapear " + name;
+        return false;
+    }
+    segment = static_cast<const StatsSegment*>(mem);
+    mapped_size = sizeof(StatsSegment);
+
+    if (segment->magic != STATS_MAGIC) {
+        error = "el segmento " + name + " no está inicializado";
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (segment->version != STATS_VERSION || segment->payload_size != sizeof(StatsPayload)) {
+        error = "versión del segmento " + to_string(segment->version) + ", se esperaba " + to_string(STATS_VERSION);
+        return false;
+    }
+    return true;
+}
+
+bool StatsReader::read(StatsPayload& out) const {
+    if (!segment) return false;
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint64_t before = segment->seq.load(memory_order_acquire);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&out, &segment->payload, sizeof(StatsPayload));
+        atomic_thread_fence(memory_order_acquire);
+        if (segment->seq.load(memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
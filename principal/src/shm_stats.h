@@ -0,0 +1,184 @@
+#ifndef SHM_STATS_H
+#define SHM_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include "futex_signal.h"
+
+using namespace std;
+
+/**
+ * Estado en vivo que el proceso publica en memoria compartida POSIX para
+ * herramientas externas (strctl, un watchdog). El formato es binario y fijo:
+ * cualquier cambio de estos structs debe incrementar STATS_VERSION.
+ * Todos los instantes son CLOCK_MONOTONIC en ns (steady_clock), comparables
+ * entre procesos del mismo equipo.
+ */
+inline constexpr uint32_t STATS_MAGIC = 0x53545253;     // "STRS"
+inline constexpr uint32_t STATS_VERSION = 2;
+inline constexpr size_t STATS_MAX_LANES = 4;
+inline constexpr size_t STATS_MAX_SLOTS = 16;
+inline constexpr const char* STATS_DEFAULT_NAME = "/str_project";
+
+/** Estado del proceso publicado */
+enum class ProcessState : uint32_t { Starting, Running, Stopping };
+
+struct LaneSnapshot {
+    uint8_t occupied = 0;                 // 1 mientras hay un vehículo frente al sensor
+    uint8_t barrier = 0;                  // Estado de la barrera (ver BARRIER_STATE_NAMES)
+    uint8_t reserved[2] = {};
+    int32_t last_distance_mm = -1;        // Última distancia medida (-1 = inválida)
+    int64_t last_measure_ns = 0;
+    uint64_t last_vehicle_id = 0;
+};
+
+struct SlotSnapshot {
+    int32_t thread_id = -1;
+    uint8_t in_iteration = 0;             // 1 si el hilo está dentro de una iteración
+    uint8_t reserved[3] = {};
+    int64_t last_start_ns = 0;            // Inicio de la última iteración
+    int64_t budget_ns = 0;                // Presupuesto vigente
+    uint64_t iterations = 0;
+    uint64_t timeouts = 0;
+    uint64_t recoveries = 0;
+    uint64_t restarts = 0;
+    uint64_t exec_p50_ns = 0;
+    uint64_t exec_p99_ns = 0;
+    uint64_t exec_max_ns = 0;
+};
+
+struct LatencySnapshot {
+    uint64_t count = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+struct StatsPayload {
+    int64_t updated_ns = 0;               // Última publicación: si envejece, el proceso no responde
+    uint64_t publish_count = 0;
+    int32_t pid = 0;
+    ProcessState state = ProcessState::Starting;
+
+    uint32_t lane_count = 0;
+    LaneSnapshot lanes[STATS_MAX_LANES];
+
+    uint32_t trigger_depth = 0;
+    uint32_t photo_depth = 0;
+    uint32_t audit_depth = 0;
+    uint32_t decision_depth = 0;
+    uint32_t pool_in_use = 0;
+    uint32_t reserved = 0;
+
+    uint64_t vehicles_detected = 0;
+    uint64_t photos_captured = 0;
+    uint64_t frame_drops = 0;
+    uint64_t events_dropped = 0;
+    uint64_t uploads_failed = 0;
+    LatencySnapshot upload_latency;
+    LatencySnapshot decision_latency;
+
+    uint32_t slot_count = 0;
+    uint32_t reserved2 = 0;
+    SlotSnapshot slots[STATS_MAX_SLOTS];
+};
+
+/**
+ * Segmento completo. `seq` protege `payload` al estilo seqlock: es impar
+ * mientras el publicador escribe; un lector que ve `seq` distinta antes y
+ * después de copiar (o impar) reintenta. Así el publicador nunca espera a
+ * los lectores ni hace llamadas al sistema para publicar.
+ */
+struct StatsSegment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t payload_size;
+    uint32_t reserved;
+    atomic<uint64_t> seq;
+    StatsPayload payload;
+};
+
+static_assert(atomic<uint64_t>::is_always_lock_free, "el seqlock entre procesos requiere atómicos sin locks");
+
+/**
+ * Clase StatsPublisher
+ * Crea el segmento y lo actualiza periódicamente desde un hilo SCHED_OTHER
+ * con lo que arma `fill`. El segmento se borra al detenerlo; si el proceso
+ * muere sin detenerlo queda con `updated_ns` viejo, que es lo que detecta
+ * `strctl check`.
+ */
+class StatsPublisher {
+public:
+    using Filler = function<void(StatsPayload&)>;
+
+    StatsPublisher(Filler fill, chrono::milliseconds period = chrono::milliseconds(100))
+        : fill(move(fill)), period(period) {}
+    ~StatsPublisher();
+
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+
+    /**
+     * Crea (o reemplaza) el segmento e inicia la publicación.
+     * @param name Nombre POSIX del segmento (vacío = STR_SHM_NAME o STATS_DEFAULT_NAME)
+     * @return false si no pudo crearse el segmento
+     */
+    bool start(const string& name = "");
+
+    /** Publica el estado final (Stopping), detiene el hilo y borra el segmento */
+    void stop();
+
+    const string& segment_name() const { return name; }
+
+private:
+    Filler fill;
+    chrono::milliseconds period;
+    string name;
+    StatsSegment* segment = nullptr;
+    StatsPayload scratch;
+    atomic<bool> running{false};
+    FutexSignal wake;
+    thread publisher;
+
+    void publish_loop();
+    void publish(ProcessState state);
+};
+
+/**
+ * Clase StatsReader
+ * Lector del segmento, para herramientas externas. Solo mapea en lectura.
+ */
+class StatsReader {
+public:
+    StatsReader() = default;
+    ~StatsReader();
+
+    StatsReader(const StatsReader&) = delete;
+    StatsReader& operator=(const StatsReader&) = delete;
+
+    /**
+     * Abre el segmento.
+     * @param error Descripción del problema si falla
+     * @return false si no existe o su versión no coincide
+     */
+    bool open(const string& name, string& error);
+
+    /**
+     * Copia una versión consistente del estado.
+     * @return false si no se obtuvo una copia consistente tras varios intentos
+     */
+    bool read(StatsPayload& out) const;
+
+private:
+    const StatsSegment* segment = nullptr;
+    size_t mapped_size = 0;
+};
+
+/** Nombres de los estados de barrera publicados en LaneSnapshot::barrier (orden de BarrierState) */
+inline constexpr const char* BARRIER_STATE_NAMES[] = {"cerrada", "abriendo", "abierta", "cerrando", "falla"};
+
+#endif // SHM_STATS_H
@@ -1,14 +1,27 @@
 #include "barrera.h"
-#include <iostream>
+#include <cinttypes>
 #include <pigpio.h>
 #include <unistd.h>
 #include "supervisor.h"
+#include "../led_engine.h"
+#include "../logger.h"
+#include "../servo_motion.h"
+#include "../metrics.h"
+#include "../tracer.h"
 #include "../shared_data.h"
 #include <atomic>
+#include <chrono>
 
 using namespace std;
 
-extern pthread_barrier_t barrier;
+/** Canal con la decisión del backend para cada vehículo */
+extern DecisionChannel decisionChannel;
+
+/** Métricas del pipeline (ocupación del carril y estado de la barrera) */
+extern PipelineMetrics pipelineMetrics;
+
+/** Motor de patrones de los LEDs */
+extern LedEngine leds;
 
 // Pines GPIO
 const int BARRIER_PIN = 18;       // Pin para el servo o motor de la barrera
@@ -16,82 +29,144 @@ const int LED_GREEN = 17;         // Pin para el LED verde (acceso autorizado)
 const int LED_RED = 27;           // Pin para el LED rojo (acceso denegado)
 const int SERVO_OPEN_US = 1500;   // PWM en microsegundos para abrir (90°)
 const int SERVO_CLOSED_US = 500;  // PWM en microsegundos para cerrar (0°)
+const size_t BARRIER_LANE = 0;    // Carril cuyo sensor informa la salida del vehículo
+const chrono::milliseconds IDLE_POLL(200);  // Espera máxima sin plazos pendientes (para revisar la cancelación)
 
 /**
  * Configura los pines GPIO de la barrera y los LEDs.
  * Inicializa la barrera cerrada y enciende el LED rojo por defecto.
  */
 void setupPins() {
-    gpioSetMode(LED_GREEN, PI_OUTPUT);
-    gpioSetMode(LED_RED, PI_OUTPUT);
-
     gpioServo(BARRIER_PIN, SERVO_CLOSED_US); // Barrera cerrada por defecto
-    gpioWrite(LED_GREEN, 0); // LED verde apagado
-    gpioWrite(LED_RED, 1);   // LED rojo encendido
+    leds.post(LED_GREEN, LedPattern::off());  // LED verde apagado
+    leds.post(LED_RED, LedPattern::solid());  // LED rojo encendido
 }
 
+/** Servo ya creado por barrierArm(), para liberarlo al apagar sin crearlo */
+static ServoMotion* created_arm = nullptr;
+
 /**
- * Función de hilo que controla la barrera de acceso mediante un servo.
- * @param supervisor Referencia al supervisor de hilos
- * @param running Variable atómica que indica si el hilo debe seguir ejecutándose
- * @param thread_id Identificador del hilo
- * 
- * El hilo espera una señal de sincronización (barrier), luego actúa según
- * el valor de `lift_barrier` (variable compartida):
- * - Si es true, abre la barrera y enciende el LED verde.
- * - Si es false, parpadea el LED rojo indicando acceso denegado.
+ * Servo de la barrera con rampas por DMA. Es único por proceso, como el motor
+ * de ondas de pigpio, y sobrevive a los reinicios del hilo.
  */
-void threadBarrier(ThreadSupervisor& supervisor, atomic<bool>& running, int thread_id) {
-    setupPins();
-
-    // Asegura que el LED rojo esté encendido al iniciar
-    gpioWrite(LED_RED, 1);
-    gpioWrite(LED_GREEN, 0);
+ServoMotion& barrierArm() {
+    static ServoMotion arm(BARRIER_PIN, SERVO_CLOSED_US, SERVO_OPEN_US);
+    static bool waves = arm.init();
+    (void)waves;
+    created_arm = &arm;
+    return arm;
+}
 
-    while (running) {
-        // Espera sincronizada con otros hilos (por ejemplo, el sensor)
-        pthread_barrier_wait(&barrier);
-        supervisor.notify_start(thread_id);
+void releaseBarrierArm() {
+    if (created_arm) created_arm->release();
+}
 
-        if (lift_barrier) {
-            cout << "\u2705 Acceso autorizado. Abriendo barrera…" << endl;
+/**
+ * Conecta la máquina de estados con el servo y los LEDs.
+ */
+BarrierActuator makeActuator() {
+    BarrierActuator actuator;
+    actuator.servo = [&arm = barrierArm()](bool open, chrono::steady_clock::time_point now) {
+        ServoMove motion = arm.move(open, now);
+        if (!motion.ok) LOG_ERROR("Error al enviar PWM al servo");
+        return motion;
+    };
+    actuator.lights = [](bool green, bool red) {
+        leds.post(LED_GREEN, green ? LedPattern::solid() : LedPattern::off());
+        leds.post(LED_RED, red ? LedPattern::solid() : LedPattern::off());
+    };
+    return actuator;
+}
 
-            // Cambia la luz a verde
-            gpioWrite(LED_RED, 0);
-            gpioWrite(LED_GREEN, 1);
+BarrierStation::BarrierStation()
+    : lane(pipelineMetrics.lanes[BARRIER_LANE]), barrier(makeActuator()) {
+    setupPins();
+    barrier.reset(clock::now());
+    last_state = barrier.state();
+    lane.barrier.store(static_cast<uint8_t>(last_state), memory_order_relaxed);
+}
 
-            // Abre la barrera (servo a 90°)
-            int status = gpioServo(BARRIER_PIN, SERVO_OPEN_US);
-            cout << "Status del servo: " << status << endl;
+void BarrierStation::poll(clock::time_point now) {
+    barrier.lane(lane.occupied.load(memory_order_relaxed) != 0, now);
+    barrier.tick(now);
+}
 
-            if (status != 0) {
-                cerr << "Error al enviar PWM al servo" << endl;
-                supervisor.recovery_thread(thread_id);
-                gpioWrite(LED_GREEN, 0);
-                gpioWrite(LED_RED, 1);
-                continue;
-            }
+void BarrierStation::actuate(VehicleEvent* vehicle, clock::time_point now) {
+    TraceScope actuate_span("actuate", vehicle->id);
+    if (vehicle->lift()) {
+        LOG_INFO("\u2705 Acceso autorizado para vehículo #%" PRIu64 ". Abriendo barrera…", vehicle->id);
+        barrier.grant(now);
+    } else {
+        LOG_INFO("\u274c Acceso denegado para vehículo #%" PRIu64 ". Parpadeo…", vehicle->id);
+        barrier.deny(now);
+    }
+    vehicle->stamp(Stage::Actuation);
+}
 
-            // Espera mientras la barrera está abierta
-            sleep(3);
+void BarrierStation::finish(VehicleEvent* vehicle) {
+    LOG_INFO("Vehículo #%" PRIu64 ": %s", vehicle->id, vehicle->latency_breakdown().c_str());
+    Tracer::instance().vehicle_done(*vehicle);
+    release_vehicle(vehicle);
+}
 
-            // Cierra la barrera (servo a 0°)
-            gpioServo(BARRIER_PIN, SERVO_CLOSED_US);
+bool BarrierStation::update() {
+    BarrierState state = barrier.state();
+    if (state == last_state) return false;
 
-            // Vuelve a encender el LED rojo
-            gpioWrite(LED_GREEN, 0);
-            gpioWrite(LED_RED, 1);
+    lane.barrier.store(static_cast<uint8_t>(state), memory_order_relaxed);
+    if (state == BarrierState::Closing && (last_state == BarrierState::Open || last_state == BarrierState::Opening)) {
+        double open_s = chrono::duration<double>(barrier.last_open_time()).count();
+        if (barrier.closed_by_timeout()) {
+            LOG_WARN("Barrera cerrada por tiempo máximo tras %.1f s sin informe de salida", open_s);
         } else {
-            cout << "\u274c Acceso denegado. Parpadeo…" << endl;
+            LOG_INFO("Vehículo salió, cerrando barrera tras %.1f s", open_s);
+        }
+    }
+    last_state = state;
+    return state == BarrierState::Fault;
+}
 
-            // Parpadea el LED rojo (apagado 1 segundo)
-            gpioWrite(LED_RED, 0);
-            sleep(1);
-            gpioWrite(LED_RED, 1);
+/**
+ * Función de hilo que controla la barrera de acceso mediante un servo.
+ * @param ctx Contexto de la generación del hilo (supervisor, cancelación y latido)
+ *
+ * El hilo no duerme con la barrera abierta: alimenta a un BarrierController con
+ * las decisiones de `decisionChannel`, la ocupación del carril que publica el
+ * sensor (que lo despierta al liberarse el carril) y los plazos de la propia
+ * máquina de estados. Cada vehículo se completa al enviar el comando al servo:
+ * - Si es true, abre la barrera con una rampa suave y enciende el LED verde cuando
+ *   el brazo ya deja pasar; cierra cuando el vehículo sale.
+ * - Si es false, parpadea el LED rojo indicando acceso denegado.
+ */
+void threadBarrier(WorkerContext& ctx) {
+    BarrierStation station;
+
+    while (ctx.active()) {
+        // Espera la próxima decisión, el próximo plazo de la barrera o la salida del vehículo
+        // (o retoma la decisión que una generación anterior colgada no llegó a actuar)
+        auto now = chrono::steady_clock::now();
+        auto wake_at = min(station.next_deadline(), now + IDLE_POLL);
+        VehicleEvent* vehicle = ctx.resume<VehicleEvent>();
+        bool decided = vehicle || decisionChannel.pop_or_wait_until(vehicle, wake_at);
+
+        // Una vuelta de espera sin decisión ni plazo vencido no es trabajo: no se supervisa,
+        // para que la barrera en reposo no despierte al monitor
+        now = chrono::steady_clock::now();
+        bool busy = decided || now >= station.next_deadline();
+        if (busy) ctx.iteration_start();
+        station.poll(now);
+
+        if (decided) {
+            ctx.hold(vehicle);
+            station.actuate(vehicle, now);
+
+            // Una generación abandonada que vuelve tarde no libera un registro ya retomado
+            if (ctx.complete(vehicle)) station.finish(vehicle);
         }
 
-        // Notifica fin de ciclo al supervisor y duerme brevemente
-        supervisor.notify_end(thread_id);
-        usleep(200000); // 200 ms
+        if (station.update()) ctx.recover();
+
+        // Notifica fin de ciclo al supervisor
+        if (busy) ctx.iteration_end();
     }
 }
@@ -3,9 +3,58 @@
 
 #include "supervisor.h"
 #include <atomic>
+#include <chrono>
+#include "../barrier_controller.h"
 
 using namespace std;
 
-void threadBarrier(ThreadSupervisor& supervisor, atomic<bool>& running, int thread_id);
+struct LaneStatus;
+struct VehicleEvent;
+
+/**
+ * Clase BarrierStation
+ * Barrera del carril: la máquina de estados con el servo y los LEDs, la
+ * ocupación que publica el sensor y el registro de cada cambio de estado en
+ * las métricas y el log. La usan el hilo de la barrera y el runtime de event
+ * loop; no es segura para varios hilos.
+ */
+class BarrierStation {
+public:
+    using clock = chrono::steady_clock;
+
+    /** Configura los pines y deja la barrera cerrada con el LED rojo encendido */
+    BarrierStation();
+
+    /** Toma la ocupación del carril y vence los plazos vigentes */
+    void poll(clock::time_point now);
+
+    /** Abre o niega el paso según la decisión del vehículo (no lo libera) */
+    void actuate(VehicleEvent* vehicle, clock::time_point now);
+
+    /** Cierra el recorrido del vehículo: latencias al log, traza y registro al pool */
+    static void finish(VehicleEvent* vehicle);
+
+    /**
+     * Publica y registra el cambio de estado, si lo hubo.
+     * @return true si la barrera acaba de entrar en falla
+     */
+    bool update();
+
+    /** Próximo plazo de la máquina de estados (time_point::max() si no hay) */
+    clock::time_point next_deadline() const { return barrier.next_deadline(); }
+
+private:
+    LaneStatus& lane;
+    BarrierController barrier;
+    BarrierState last_state = BarrierState::Closed;
+};
+
+/**
+ * Borra las ondas del servo de la barrera. Lo llama main con los hilos ya
+ * terminados y antes de gpioTerminate(); el destructor estático corre después.
+ */
+void releaseBarrierArm();
+
+void threadBarrier(WorkerContext& ctx);
 
 #endif // THREAD_BARRIER_H
@@ -1,11 +1,11 @@
 /**
  * @file camera.cpp
- * @brief Módulo de captura de imágenes mediante cámara USB, activado por señal y sincronizado con otros hilos.
+ * @brief Módulo de captura de imágenes mediante cámara USB, activado por eventos de detección.
  */
 
 #include "camera.h"
 #include <atomic>
-#include <iostream>
+#include <cinttypes>
 #include <csignal>
 #include <unistd.h>
 #include <chrono>
@@ -14,16 +14,35 @@
 #include <filesystem> 
 #include <opencv2/opencv.hpp>
 #include "supervisor.h"
+#include "../logger.h"
+#include "../metrics.h"
+#include "../tracer.h"
 #include "shared_data.h"
 
 using namespace std;
 using namespace cv;
 
-// Variable atomica para controlar si hay una foto pendiente
+// Variable atomica para controlar si hay una foto pendiente por disparo manual (SIGUSR1)
 atomic_bool pending_photo(false);
 
-extern pthread_barrier_t barrier;
-extern SharedQueue sharedQueue;
+// Instante (steady_clock, en nanosegundos) en que se disparo la foto pendiente
+atomic<int64_t> pending_trigger_ns(0);
+
+// Directorio donde se guardan las fotos
+const string SAVE_DIR = "/home/raspy/str-project/photos/";
+const int MAX_CAPTURE_ATTEMPTS = 3;     // Capturas por vehículo antes de descartarlo
+
+/** Canal de entrada con los vehiculos detectados por el sensor */
+extern TriggerChannel triggerChannel;
+
+/** Canal de salida con las fotos listas para enviar */
+extern PhotoChannel photoChannel;
+
+/** Pool de registros de vehiculo (para disparos manuales) */
+extern VehiclePool vehiclePool;
+
+/** Metricas del pipeline */
+extern PipelineMetrics pipelineMetrics;
 
 /**
  * @brief Obtiene la marca de tiempo actual en formato YYYYMMDD_HHMMSS.
@@ -43,75 +62,139 @@ string getCurrentTimestamp() {
  */
 void handle_signal_camera(int signal){
     if(signal == SIGUSR1) {
+        pending_trigger_ns = chrono::steady_clock::now().time_since_epoch().count();
         pending_photo = true;
-        cout << "Signal received: " << signal << endl;
     }
 }
 
-/**
- * @brief Hilo de ejecucion encargado de capturar una imagen cuando se recibe una señal.
- *
- * Este hilo espera a que se active la bandera `pending_photo` para iniciar la captura de imagen.
- * Realiza multiples intentos hasta obtener un frame valido, guarda la imagen capturada con
- * marca de tiempo en el nombre, y la coloca en una cola compartida para su posterior envio.
- * Utiliza una barrera para sincronizar el ciclo con el resto del sistema.
- *
- * @param supervisor Referencia al supervisor de hilos para control de fallos y monitoreo.
- * @param running Bandera atomica que indica si el hilo debe continuar en ejecucion.
- * @param thread_id Identificador del hilo para la supervision.
- * @param cam Objeto VideoCapture abierto con la camara correspondiente.
- */
-void threadCamera(ThreadSupervisor& supervisor, std::atomic<bool>& running, int thread_id, VideoCapture cam) {
+VehicleEvent* takeManualTrigger() {
+    if (!pending_photo.exchange(false)) return nullptr;
+    VehicleEvent* vehicle = vehiclePool.acquire();
+    if (vehicle) {
+        vehicle->id = next_event_id();
+        vehicle->stamp(Stage::Trigger, chrono::steady_clock::time_point(
+            chrono::steady_clock::duration(pending_trigger_ns.load())));
+    }
+    return vehicle;
+}
+
+bool capturePhoto(VideoCapture& cam, VehicleEvent* vehicle, string& filename, const function<bool()>& keep_going) {
     Mat frame;
     bool frame_captured = false;
     int count = 0;
-    string save_dir = "/home/raspy/str-project/photos/";
-
-    while(running){
-        if (pending_photo) {
-            try{
-                supervisor.notify_start(thread_id);
-
-                // Intenta capturar multiples frames hasta obtener uno valido
-                for (int i = 0; i < 40; i++) {
-                    cam >> frame;
-                    if (!frame.empty()) {
-                        if (count >= 3){
-                            frame_captured = true;
-                            count = 0;
-                            break;
-                        }
-                        count++;
-                    }
-                    usleep(10000); // Espera 10ms entre intentos
-                }
-
-                if (frame_captured) {
-                    string filename = save_dir + "foto_" + getCurrentTimestamp() + ".jpg";
-                    
-                    if (imwrite(filename, frame)) {
-                        cout << "Foto guardada como: " << filename << endl;
-                        sharedQueue.push(filename);
-                        pending_photo = false;
-                        supervisor.notify_end(thread_id);
-                        frame_captured = false;
-                        count = 0;
-                        pthread_barrier_wait(&barrier);
-                    } else {
-                        cerr << "\u274c Error al guardar la foto." << endl;
-                        supervisor.recovery_thread(thread_id);
-                    }
-                } else {
-                    cerr << "\u274c Error al capturar la imagen." << endl;
-                    supervisor.recovery_thread(thread_id);
-                }
-            } catch (const exception &e) {
-                cerr << "Error: " << e.what() << endl;
-                supervisor.recovery_thread(thread_id);
+
+    // Intenta capturar multiples frames hasta obtener uno valido
+    TraceScope capture_span("capture", vehicle->id);
+    for (int i = 0; i < 40 && keep_going(); i++) {
+        cam >> frame;
+        if (frame.empty()) pipelineMetrics.camera_frame_drops.inc();
+        if (!frame.empty()) {
+            if (count >= 3){
+                frame_captured = true;
+                break;
             }
+            count++;
         }
-        usleep(50000); // Espera 50 ms antes de volver a verificar
+        usleep(10000); // Espera 10ms entre intentos
+    }
+
+    capture_span.end();
+
+    if (!frame_captured) {
+        LOG_ERROR("\u274c Error al capturar la imagen.");
+        pipelineMetrics.camera_frame_drops.inc();
+        return false;
     }
 
-    cam.release();
+    vehicle->stamp(Stage::Frame);
+    filename = SAVE_DIR + "foto_" + getCurrentTimestamp() + "_" + to_string(vehicle->id) + ".jpg";
+
+    TraceScope encode_span("encode", vehicle->id);
+    bool saved = imwrite(filename, frame);
+    encode_span.end();
+
+    if (!saved) {
+        LOG_ERROR("\u274c Error al guardar la foto.");
+        return false;
+    }
+    vehicle->stamp(Stage::Encode);
+    pipelineMetrics.photos_captured.inc();
+    LOG_INFO("Foto guardada como: %s", filename.c_str());
+    return true;
+}
+
+void publishPhoto(VehicleEvent* vehicle, const string& filename) {
+    vehicle->set_path(filename);
+    vehicle->deadline = vehicle->trigger_time() + PHOTO_DEADLINE;
+    if (!photoChannel.push(vehicle)) {
+        LOG_ERROR("\u274c Canal de fotos lleno, se pierde el vehículo #%" PRIu64, vehicle->id);
+        pipelineMetrics.events_dropped.inc();
+        release_vehicle(vehicle);
+    }
+}
+
+/**
+ * @brief Hilo de ejecucion encargado de capturar una imagen por cada vehiculo detectado.
+ *
+ * Este hilo espera vehiculos en `triggerChannel` (o un disparo manual por SIGUSR1).
+ * Realiza multiples intentos hasta obtener un frame valido, guarda la imagen capturada con
+ * marca de tiempo e id de vehiculo en el nombre, y la coloca en `photoChannel` para su
+ * posterior envio junto con su plazo de validez (`PHOTO_DEADLINE`), marcando en el registro
+ * del vehiculo los instantes de frame y codificacion.
+ * No espera al resto del pipeline: mientras se sube una foto ya puede capturarse la siguiente.
+ *
+ * Si el supervisor reinicia el hilo, la nueva generación retoma el vehículo que
+ * la anterior dejó a medio procesar. Una captura fallida se reintenta (como en
+ * la versión original) hasta MAX_CAPTURE_ATTEMPTS veces mientras la foto siga a
+ * tiempo; después el registro vuelve al pool.
+ *
+ * @param ctx Contexto de la generación del hilo (supervisor, cancelación y latido).
+ * @param cam Objeto VideoCapture abierto con la camara correspondiente (lo libera main).
+ */
+void threadCamera(WorkerContext& ctx, VideoCapture& cam) {
+    VehicleEvent* retry = nullptr;     // Vehículo cuya captura falló y se vuelve a intentar
+    int attempts = 0;
+
+    while(ctx.active()){
+        // Reintento, vehículo abandonado por una generación anterior colgada, o el siguiente del canal
+        VehicleEvent* vehicle = exchange(retry, nullptr);
+        if (!vehicle) {
+            attempts = 0;
+            vehicle = ctx.resume<VehicleEvent>();
+            if (!vehicle) triggerChannel.wait_and_pop(vehicle, chrono::milliseconds(50));
+
+            // Disparo manual por SIGUSR1: se toma un registro nuevo del pool
+            if (!vehicle) vehicle = takeManualTrigger();
+            if (!vehicle) continue;
+            ctx.hold(vehicle);
+        }
+
+        // La iteración se cierra en todos los caminos: un latido abierto haría
+        // que el monitor diera por colgado a un hilo que solo está esperando
+        ctx.iteration_start();
+        bool captured = false;
+        string filename;
+        try{
+            captured = capturePhoto(cam, vehicle, filename, [&ctx] { return ctx.active(); });
+        } catch (const exception &e) {
+            LOG_ERROR("Error: %s", e.what());
+        }
+        ctx.iteration_end();
+
+        if (captured) {
+            // Si otra generación tomó el vehículo, ella lo publica
+            if (ctx.complete(vehicle)) publishPhoto(vehicle, filename);
+            continue;
+        }
+        ctx.recover();
+
+        // Se reintenta mientras la foto pueda llegar a tiempo; si no, el registro vuelve al pool
+        bool in_time = chrono::steady_clock::now() < vehicle->trigger_time() + PHOTO_DEADLINE;
+        if (++attempts < MAX_CAPTURE_ATTEMPTS && in_time) {
+            retry = vehicle;
+            continue;
+        }
+        LOG_WARN("Se descarta el vehículo #%" PRIu64 " tras %d capturas fallidas", vehicle->id, attempts);
+        if (ctx.complete(vehicle)) release_vehicle(vehicle);
+    }
 }
@@ -4,11 +4,40 @@
 #include <opencv2/opencv.hpp>
 #include "supervisor.h"
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
 
 using namespace std;
 using namespace cv;
 
-void threadCamera(ThreadSupervisor& supervisor, atomic<bool>& running, int thread_id, VideoCapture cam);
+struct VehicleEvent;
+
+// Tiempo durante el cual una foto sigue siendo util para decidir sobre el vehiculo
+inline constexpr chrono::milliseconds PHOTO_DEADLINE(5000);
+
+void threadCamera(WorkerContext& ctx, VideoCapture& cam);
 void handle_signal_camera(int signal);
 
+/**
+ * Registro nuevo para un disparo manual pendiente (SIGUSR1).
+ * @return nullptr si no hay disparo pendiente o el pool está agotado
+ */
+VehicleEvent* takeManualTrigger();
+
+/**
+ * Captura la foto de un vehículo: descarta los primeros frames válidos (buffer
+ * de la cámara), guarda el siguiente como JPEG y marca Frame y Encode.
+ * @param keep_going Se consulta entre intentos; false cancela la captura
+ * @param filename Ruta del archivo guardado
+ * @return false si no hubo un frame válido o no se pudo guardar
+ */
+bool capturePhoto(VideoCapture& cam, VehicleEvent* vehicle, string& filename, const function<bool()>& keep_going);
+
+/**
+ * Publica la foto en `photoChannel` con su plazo de validez. Si el canal está
+ * lleno el registro vuelve al pool.
+ */
+void publishPhoto(VehicleEvent* vehicle, const string& filename);
+
 #endif //CAMERA_H
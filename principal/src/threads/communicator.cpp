@@ -1,22 +1,45 @@
+#include "communicator.h"
 #include "../shared_data.h"
 #include <curl/curl.h>  // for HTTP POST
 #include "supervisor.h"
+#include "../logger.h"
+#include "../metrics.h"
+#include "../tracer.h"
 #include <fstream>
-#include <iostream>
+#include <cinttypes>
 #include <sstream>
 #include <unistd.h>
 #include <atomic>
+#include <chrono>
 
 using namespace std;
 
-/** Barrera para sincronizar hilos luego de cada envío */
-extern pthread_barrier_t barrier;
+/** Cola compartida con los eventos de foto pendientes de envío */
+extern PhotoChannel photoChannel;
 
-/** Cola compartida que contiene las rutas de imágenes */
-extern SharedQueue sharedQueue;
+/** Canal hacia la barrera con la decisión de cada vehículo */
+extern DecisionChannel decisionChannel;
 
-/** Bandera para indicar si se debe levantar la barrera tras una respuesta válida */
-extern atomic<bool> lift_barrier;
+/** Métricas del pipeline */
+extern PipelineMetrics pipelineMetrics;
+
+namespace {
+
+const char* BACKEND_URL = "http://192.168.0.103:5000/procesar";
+const char* STATUS_URL = "http://192.168.0.103:5000/status";   // Valida la conexión (GET)
+const chrono::milliseconds WARM_IDLE_TIMEOUT(3000);     // Vida de una conexión precalentada sin foto
+const long WARM_PROBE_TIMEOUT_MS = 1000;                // Plazo del pedido que valida la conexión
+const chrono::milliseconds IDLE_WAIT(200);              // Espera máxima sin fotos (revisa ctx.active())
+
+/** Hay un vehículo detectado desde el último precalentamiento */
+atomic<bool> approach_pending{false};
+
+/** Descarta el cuerpo de la respuesta de /status */
+size_t DiscardCallback(void*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+} // namespace
 
 /**
  * Se encarga de concatenar el contenido recibido en una cadena de texto.
@@ -34,77 +57,276 @@ static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* use
     return realsize;
 }
 
-/**
- * Hilo que envía imágenes al servidor y sincroniza por barrera
- * @param supervisor Referencia al supervisor de hilos
- * @param running Bandera global para detener ejecución
- * @param thread_id ID del hilo actual
- */
-void threadCommunicator(ThreadSupervisor& supervisor, std::atomic<bool>& running, int thread_id) {
-    curl_global_init(CURL_GLOBAL_ALL);
+WarmConnection::WarmConnection(chrono::milliseconds idle_timeout) : idle_timeout(idle_timeout) {
+    multi = curl_multi_init();
+    share = curl_share_init();
+    // Solo la usa el hilo comunicador: no hacen falta funciones de bloqueo
+    if (share) curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
 
-    while (running) {
-        try {
-            string photo_path = sharedQueue.wait_and_pop();
-            supervisor.notify_start(thread_id);
-            cout << "Procesando foto: " << photo_path << endl;
-
-            // Verificar existencia del archivo
-            if(access(photo_path.c_str(), F_OK) == -1) {
-                cerr << "Error: Archivo no existe - " << photo_path << endl;
-                supervisor.recovery_thread(thread_id);
-                continue;
-            }
+WarmConnection::~WarmConnection() {
+    drop();
+    if (multi) curl_multi_cleanup(multi);
+    if (share) curl_share_cleanup(share);
+}
 
-            CURL* curl = curl_easy_init();
-            if (!curl) {
-                cerr << "Error al inicializar cURL" << endl;
-                supervisor.recovery_thread(thread_id);
-                continue;
-            }
+void WarmConnection::warm() {
+    if (in_flight || !multi) return;
+    if (!curl) {
+        curl = curl_easy_init();
+        if (!curl) return;
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        if (share) curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+
+    // GET a /status: abre la conexión, o confirma que la guardada sigue viva, sin enviar nada
+    curl_easy_setopt(curl, CURLOPT_URL, STATUS_URL);
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DiscardCallback);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, WARM_PROBE_TIMEOUT_MS);
+    if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+        drop();
+        return;
+    }
+    in_flight = true;
+    probe_start = clock::now();
+    poll(probe_start);
+}
+
+void WarmConnection::poll(clock::time_point now) {
+    if (in_flight) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg == CURLMSG_DONE && msg->easy_handle == curl) finish_probe(msg->data.result, now);
+        }
+        return;
+    }
+    if (!curl || now - warmed_at < idle_timeout) return;
+    LOG_DEBUG("Conexión precalentada descartada: no llegó ninguna foto");
+    pipelineMetrics.connection_expired.inc();
+    drop();
+}
+
+void WarmConnection::wait(clock::time_point until, int wake_fd) {
+    if (!in_flight) return;
+    auto timeout = chrono::ceil<chrono::milliseconds>(until - clock::now()).count();
+    curl_waitfd extra{wake_fd, CURL_WAIT_POLLIN, 0};
+    curl_multi_poll(multi, &extra, 1, static_cast<int>(max<int64_t>(timeout, 0)), nullptr);
+}
+
+void WarmConnection::finish_probe(CURLcode result, clock::time_point now) {
+    curl_multi_remove_handle(multi, curl);
+    in_flight = false;
+
+    long http_code = 0;
+    if (result == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code != 200) {
+        if (result != CURLE_OK) {
+            LOG_WARN("No se pudo precalentar la conexión al backend: %s", curl_easy_strerror(result));
+        } else {
+            LOG_WARN("No se pudo precalentar la conexión al backend: HTTP %ld", http_code);
+        }
+        drop();
+        return;
+    }
 
-            string respuesta;
-            long http_code = 0;
+    // Esqueleto del formulario: al llegar la foto solo falta el archivo
+    if (!form) {
+        form = curl_mime_init(curl);
+        photo = curl_mime_addpart(form);
+        curl_mime_name(photo, "imagen");
+    }
+    warmed_at = now;
+    pipelineMetrics.connection_warmups.inc();
+    LOG_DEBUG("Conexión al backend precalentada en %.1f ms",
+              chrono::duration<double, milli>(now - probe_start).count());
+}
 
-            // Configuración segura de cURL
-            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &respuesta);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+void WarmConnection::drop() {
+    if (in_flight) curl_multi_remove_handle(multi, curl);
+    if (form) curl_mime_free(form);
+    if (curl) curl_easy_cleanup(curl);
+    form = nullptr;
+    photo = nullptr;
+    curl = nullptr;
+    in_flight = false;
+}
 
-            // Configurar formulario multipart
-            curl_mime* form = curl_mime_init(curl);
-            curl_mimepart* field = curl_mime_addpart(form);
-            curl_mime_name(field, "imagen");
-            curl_mime_filedata(field, photo_path.c_str());
+void notifyApproach() {
+    approach_pending.store(true, memory_order_relaxed);
+    photoChannel.wake();
+}
 
-            curl_easy_setopt(curl, CURLOPT_URL, "http://192.168.0.103:5000/procesar");
-            curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
+UploadRequest::UploadRequest(VehicleEvent* vehicle, WarmConnection* warm) : ev(vehicle), warm(warm) {}
 
-            CURLcode res = curl_easy_perform(curl);
+UploadRequest::~UploadRequest() {
+    // Limpieza segura
+    if (form) curl_mime_free(form);
+    if (curl) curl_easy_cleanup(curl);
+}
 
-            if (res != CURLE_OK) {
-                cerr << "Error en cURL: " << curl_easy_strerror(res) << endl;
-            } else {
-                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-                cout << "Respuesta HTTP: " << http_code << endl;
-                
-                if (http_code == 200) {
-                    cout << "Contenido: " << respuesta << endl;
-                    lift_barrier.store(respuesta.find("true") != string::npos);
-                }
-            }
+bool UploadRequest::prepare() {
+    prepare_start = chrono::steady_clock::now();
+    const char* photo_path = ev->photo_path;
+
+    QueueStats qs = photoChannel.stats();
+    auto age_ms = chrono::duration_cast<chrono::milliseconds>(qs.last_age).count();
+    LOG_INFO("Procesando foto: %s (edad %lld ms, en cola %zu+%zu, descartadas %" PRIu64 ")",
+             photo_path, static_cast<long long>(age_ms), qs.live_depth, qs.background_depth, qs.dropped);
+
+    // Una foto vencida solo se envía para auditoría: el vehículo ya no está en la barrera
+    if (ev->stale) {
+        LOG_WARN("Foto vencida del vehículo #%" PRIu64 ", se envía solo para auditoría.", ev->id);
+    }
+
+    ev->decision = AccessDecision::Error;
+
+    // Verificar existencia del archivo
+    if(access(photo_path, F_OK) == -1) {
+        LOG_ERROR("Error: Archivo no existe - %s", photo_path);
+        return false;
+    }
+
+    if (warm && warm->ready()) {
+        // La conexión y el formulario ya están: el handle pasa a este pedido
+        curl = exchange(warm->curl, nullptr);
+        form = exchange(warm->form, nullptr);
+        photo = exchange(warm->photo, nullptr);
+        warm_start = true;
+        curl_easy_setopt(curl, CURLOPT_URL, BACKEND_URL);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 0L);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            LOG_ERROR("Error al inicializar cURL");
+            return false;
+        }
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_URL, BACKEND_URL);
+        // Sin conexión validada igual puede haber una abierta por un envío anterior
+        if (warm && warm->share) curl_easy_setopt(curl, CURLOPT_SHARE, warm->share);
+
+        // Configurar formulario multipart
+        form = curl_mime_init(curl);
+        photo = curl_mime_addpart(form);
+        curl_mime_name(photo, "imagen");
+    }
+
+    // Configuración segura de cURL
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+
+    curl_mime_filedata(photo, photo_path);
+    curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
+    return true;
+}
+
+void UploadRequest::begin() {
+    prepare_time = chrono::steady_clock::now() - prepare_start;
+    ev->stamp(Stage::UploadStart);
+    trace_start_ns = Tracer::instance().enabled() ? Tracer::now_ns() : 0;
+}
+
+void UploadRequest::finish(CURLcode result) {
+    if (trace_start_ns != 0) {
+        Tracer::instance().complete("upload", trace_start_ns, Tracer::now_ns() - trace_start_ns, ev->id);
+    }
+    ev->stamp(Stage::UploadEnd);
+    pipelineMetrics.upload_latency.record((ev->at(Stage::UploadEnd) - ev->at(Stage::UploadStart)).count());
+
+    if (result != CURLE_OK) {
+        LOG_ERROR("Error en cURL: %s", curl_easy_strerror(result));
+        return;
+    }
+
+    // Preparación + conexión hasta empezar a enviar: lo que ahorra el precalentamiento
+    curl_off_t pretransfer_us = 0;
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer_us);
+    int64_t setup_ns = prepare_time.count() + static_cast<int64_t>(pretransfer_us) * 1000;
+    (warm_start ? pipelineMetrics.upload_setup_warm : pipelineMetrics.upload_setup_cold).record(setup_ns);
 
-            // Limpieza segura
-            curl_mime_free(form);
-            curl_easy_cleanup(curl);
-            supervisor.notify_end(thread_id);
-            pthread_barrier_wait(&barrier);
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    LOG_INFO("Respuesta HTTP: %ld", http_code);
 
+    if (http_code == 200) {
+        LOG_INFO("Contenido: %s", response.c_str());
+        ev->decision = response.find("true") != string::npos
+            ? AccessDecision::Granted : AccessDecision::Denied;
+    }
+}
+
+void recordDecision(VehicleEvent* vehicle) {
+    vehicle->stamp(Stage::Decision);
+    if (vehicle->reached(Stage::Trigger)) {
+        pipelineMetrics.decision_latency.record((vehicle->at(Stage::Decision) - vehicle->trigger_time()).count());
+    }
+    if (vehicle->decision == AccessDecision::Granted) pipelineMetrics.decisions_granted.inc();
+    else if (vehicle->decision == AccessDecision::Denied) pipelineMetrics.decisions_denied.inc();
+    else pipelineMetrics.uploads_failed.inc();
+    TRACE_INSTANT("decision", vehicle->id);
+}
+
+void deliverDecision(VehicleEvent* vehicle) {
+    // La decisión viaja en el registro del vehículo hacia la barrera;
+    // las fotos vencidas terminan acá porque no hay nada que actuar.
+    if (vehicle->stale) {
+        release_vehicle(vehicle);
+    } else if (!decisionChannel.push(vehicle)) {
+        LOG_ERROR("\u274c Canal de decisiones lleno, se pierde el vehículo #%" PRIu64, vehicle->id);
+        pipelineMetrics.events_dropped.inc();
+        release_vehicle(vehicle);
+    }
+}
+
+/**
+ * Hilo que envía imágenes al servidor y publica la decisión para la barrera
+ * Requiere curl_global_init() hecho por main: el hilo puede reiniciarse.
+ * @param ctx Contexto de la generación del hilo (supervisor, cancelación y latido)
+ */
+void threadCommunicator(WorkerContext& ctx) {
+    // Propia de cada generación: si el hilo se reinicia, la conexión se descarta con él
+    WarmConnection warm(WARM_IDLE_TIMEOUT);
+    while (ctx.active()) {
+        // Una foto que una generación anterior colgada no llegó a enviar conserva su turno
+        VehicleEvent* vehicle = ctx.resume<VehicleEvent>();
+        if (!vehicle) {
+            // Precalienta mientras la cámara trabaja; si la foto ya está en cola, no hace falta
+            if (approach_pending.exchange(false, memory_order_relaxed) && photoChannel.stats().live_depth == 0) {
+                warm.warm();
+            }
+            auto now = chrono::steady_clock::now();
+            warm.poll(now);
+            auto until = now + IDLE_WAIT;
+            // Mientras se valida la conexión se duerme sobre sus sockets y el eventfd del
+            // canal: despiertan una respuesta, una foto o un aviso, no un intervalo fijo
+            bool popped = warm.probing()
+                ? photoChannel.pop_or_poll(vehicle, until, [&](int fd) { warm.wait(until, fd); })
+                : photoChannel.pop_or_wait_until(vehicle, until);
+            if (!popped) continue;
+        }
+        ctx.hold(vehicle);
+
+        try {
+            ctx.iteration_start();
+            UploadRequest request(vehicle, &warm);
+            if (!request.prepare()) {
+                ctx.recover();
+            } else {
+                request.begin();
+                request.finish(curl_easy_perform(request.handle()));
+            }
+            recordDecision(vehicle);
+            ctx.iteration_end();
         } catch (const exception& e) {
-            cerr << "Excepción en comunicador: " << e.what() << endl;
-            supervisor.recovery_thread(thread_id);
+            LOG_ERROR("Excepción en comunicador: %s", e.what());
+            ctx.recover();
         }
+
+        // Si una generación posterior retomó el vehículo, es ella quien lo entrega
+        if (ctx.complete(vehicle)) deliverDecision(vehicle);
     }
-    curl_global_cleanup();
 }
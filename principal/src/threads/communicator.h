@@ -2,9 +2,138 @@
 #define COMMUNICATOR_H
 #include "supervisor.h"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <curl/curl.h>
 
 using namespace std;
 
-void threadCommunicator(ThreadSupervisor& supervisor, atomic<bool>& running, int thread_id);
+struct VehicleEvent;
+
+/**
+ * Clase WarmConnection
+ * Conexión al backend preparada antes de que llegue la foto. Al detectarse un
+ * vehículo, el comunicador la valida con un GET a /status sin bloquearse (un
+ * multi handle que avanza con poll()) y arma el esqueleto del pedido
+ * multipart; cuando la foto llega, el envío toma este handle y solo le falta
+ * el archivo. Cada aviso nuevo vuelve a validar la conexión en lugar de
+ * confiar en la anterior, y si la foto no llega dentro de `idle_timeout` se
+ * descarta.
+ *
+ * Las conexiones abiertas viven en una caché compartida (CURLSH) entre la
+ * validación y los envíos, así el envío reutiliza la que abrió la validación
+ * (o la de un envío anterior) si el backend la mantiene abierta.
+ */
+class WarmConnection {
+public:
+    using clock = chrono::steady_clock;
+
+    explicit WarmConnection(chrono::milliseconds idle_timeout);
+    ~WarmConnection();
+
+    WarmConnection(const WarmConnection&) = delete;
+    WarmConnection& operator=(const WarmConnection&) = delete;
+
+    /** Lanza la validación de la conexión (abriéndola si hace falta). No bloquea. */
+    void warm();
+
+    /**
+     * Avanza la validación en curso y descarta la conexión si venció su plazo
+     * sin que llegara una foto. No bloquea.
+     */
+    void poll(clock::time_point now);
+
+    /**
+     * Duerme hasta que haya actividad en los sockets de la validación en curso,
+     * `wake_fd` sea legible o llegue `until` (lo que cURL necesite antes, si
+     * tiene un plazo propio). Después hay que llamar a poll().
+     */
+    void wait(clock::time_point until, int wake_fd);
+
+    /** Hay una validación en curso: hay que esperar con wait() y avanzarla con poll() */
+    bool probing() const { return in_flight; }
+
+    bool ready() const { return curl != nullptr && !in_flight; }
+
+private:
+    friend class UploadRequest;
+
+    CURLM* multi = nullptr;
+    CURLSH* share = nullptr;                        // Caché de conexiones de validación y envíos
+    CURL* curl = nullptr;
+    curl_mime* form = nullptr;
+    curl_mimepart* photo = nullptr;
+    bool in_flight = false;                         // El handle está en `multi` validándose
+    clock::time_point probe_start{};
+    clock::time_point warmed_at{};
+    chrono::milliseconds idle_timeout;
+
+    void finish_probe(CURLcode result, clock::time_point now);
+    void drop();
+};
+
+/**
+ * Clase UploadRequest
+ * Consulta al backend por la foto de un vehículo: arma el pedido multipart de
+ * cURL y, al terminar, interpreta la respuesta y deja la decisión en el
+ * registro. El hilo comunicador la ejecuta con curl_easy_perform(); el runtime
+ * de event loop agrega handle() a un multi handle.
+ */
+class UploadRequest {
+public:
+    /**
+     * @param warm Conexión precalentada que el pedido toma si está lista (opcional)
+     */
+    explicit UploadRequest(VehicleEvent* vehicle, WarmConnection* warm = nullptr);
+    ~UploadRequest();
+
+    UploadRequest(const UploadRequest&) = delete;
+    UploadRequest& operator=(const UploadRequest&) = delete;
+
+    /**
+     * Informa la foto y arma el pedido. La decisión queda en Error hasta finish().
+     * @return false si el archivo no existe o cURL no pudo iniciarse
+     */
+    bool prepare();
+
+    /** Marca el inicio del envío */
+    void begin();
+
+    /** Cierra el envío con el resultado de cURL y fija la decisión */
+    void finish(CURLcode result);
+
+    CURL* handle() const { return curl; }
+    VehicleEvent* vehicle() const { return ev; }
+
+private:
+    VehicleEvent* ev;
+    WarmConnection* warm;
+    CURL* curl = nullptr;
+    curl_mime* form = nullptr;
+    curl_mimepart* photo = nullptr;
+    string response;
+    int64_t trace_start_ns = 0;
+    bool warm_start = false;                        // El pedido tomó una conexión precalentada
+    chrono::steady_clock::time_point prepare_start{};
+    chrono::nanoseconds prepare_time{0};            // prepare() -> begin()
+};
+
+/** Marca la decisión del vehículo y la cuenta en las métricas */
+void recordDecision(VehicleEvent* vehicle);
+
+/**
+ * Entrega el vehículo decidido a la barrera por `decisionChannel`. Las fotos
+ * vencidas (y las que no entran en el canal) vuelven al pool.
+ */
+void deliverDecision(VehicleEvent* vehicle);
+
+/**
+ * Avisa al comunicador que se detectó un vehículo, para que precaliente la
+ * conexión mientras la cámara toma la foto. Puede llamarse desde cualquier hilo.
+ */
+void notifyApproach();
+
+void threadCommunicator(WorkerContext& ctx);
 
 #endif
\ No newline at end of file
@@ -1,11 +1,16 @@
 #include "sensor.h"
-#include <iostream>
+#include <cinttypes>
 #include <csignal>
 #include <unistd.h>
 #include <pigpio.h>
 #include <unistd.h>
 #include <chrono>
 #include "supervisor.h"
+#include "communicator.h"
+#include "../logger.h"
+#include "../metrics.h"
+#include "../tracer.h"
+#include "../shared_data.h"
 #include <time.h>
 #include <atomic>
 
@@ -15,18 +20,28 @@ using namespace std;
 const int TRIGGER_PIN = 23;                // Pin GPIO para el trigger (salida)
 const int ECHO_PIN = 24;                // Pin GPIO para el echo (entrada)
 const double DISTANCE_THRESHOLD_CM = 30.0; // Distancia mínima para detección (cm)
-const int SENSOR_TIMEOUT_US = 100000;   // Tiempo máximo de espera para el sensor (microsegundos)
 const int DEBOUNCE_TIME_S = 2;          // Tiempo mínimo entre detecciones (segundos)
 const int TRIGGER_PULSE_US = 10;        // Duración del pulso de trigger (microsegundos)
 const int INITIAL_DELAY_US = 2000;      // Tiempo de espera inicial (microsegundos)
 const double SPEED_OF_SOUND_CM_PER_S = 34300.0; // Velocidad del sonido en cm/s
 
-extern pthread_barrier_t barrier;
+/** Canal hacia la cámara con los vehículos detectados */
+extern TriggerChannel triggerChannel;
+
+/** Canal hacia la barrera; se lo despierta cuando el vehículo deja el carril */
+extern DecisionChannel decisionChannel;
+
+/** Pool de registros de vehículo */
+extern VehiclePool vehiclePool;
+
+/** Métricas del pipeline */
+extern PipelineMetrics pipelineMetrics;
 
 class UltrasonicSensor {
     private:
         int triggerPin;
         int echoPin;
+        chrono::microseconds echoTimeout;
     
     public:
 
@@ -34,8 +49,10 @@ class UltrasonicSensor {
          * Constructor: Configura los pines GPIO
          * @param trig Pin GPIO para el trigger
          * @param echo Pin GPIO para el echo
+         * @param timeout Espera máxima del eco por flanco
          */
-        UltrasonicSensor(int trig, int echo) : triggerPin(trig), echoPin(echo) {
+        UltrasonicSensor(int trig, int echo, chrono::microseconds timeout)
+            : triggerPin(trig), echoPin(echo), echoTimeout(timeout) {
             gpioSetMode(triggerPin, PI_OUTPUT);
             gpioSetMode(echoPin, PI_INPUT);
             gpioWrite(triggerPin, 0);
@@ -56,7 +73,7 @@ class UltrasonicSensor {
             gpioWrite(triggerPin, 0);
         
             // 2. Espera el inicio del eco con timeout
-            const auto timeout = chrono::microseconds(SENSOR_TIMEOUT_US);
+            const auto timeout = echoTimeout;
             auto start_time = chrono::steady_clock::now();
             
             while(gpioRead(echoPin) == 0) {
@@ -84,53 +101,92 @@ class UltrasonicSensor {
         }
     }; 
 
-void threadSensor(ThreadSupervisor& supervisor, std::atomic<bool>& running, int thread_id) {
-    UltrasonicSensor sensor(TRIGGER_PIN, ECHO_PIN);
-    bool detected_car = false;
-    sleep(1);
-    
-    try {
-        time_t last_detection = 0;
-        while (running) {
-            // Notifica el inicio del hilo al supervisor
-            supervisor.notify_start(thread_id);
+VehicleDetector::VehicleDetector(chrono::microseconds echo_timeout)
+    : sensor(make_unique<UltrasonicSensor>(TRIGGER_PIN, ECHO_PIN, echo_timeout)) {}
 
-            // Mide la distancia
-            double distance = sensor.measureDistance();
+VehicleDetector::~VehicleDetector() = default;
 
+bool VehicleDetector::sample() {
+    // Mide la distancia
+    TraceScope measure_span("measure");
+    double distance = sensor->measureDistance();
+    auto measured_at = chrono::steady_clock::now();
+    measure_span.end();
 
-            if (distance > 0 && distance < DISTANCE_THRESHOLD_CM && !detected_car) {
-                time_t now = time(nullptr);
-                detected_car = true;
+    LaneStatus& lane = pipelineMetrics.lanes[0];
+    lane.last_distance_mm.store(distance > 0 ? static_cast<int32_t>(distance * 10) : -1, memory_order_relaxed);
+    lane.last_measure_ns.store(measured_at.time_since_epoch().count(), memory_order_relaxed);
 
-                if (difftime(now, last_detection) >= DEBOUNCE_TIME_S) {
-                    cout << "\u2705 Presencia detectada! Distancia: " << distance << " cm" << endl;
-                    
-                    // manda senial al proceso, activa el handler de la camara en main
-                    kill(getpid(), SIGUSR1);
-                    supervisor.notify_end(thread_id);
-                    last_detection = now;
-                    pthread_barrier_wait(&barrier);
-                    
-                }
-            } else if(detected_car && distance > DISTANCE_THRESHOLD_CM){
-                detected_car = false;
-                cout << "\u274c Vehículo saliendo." << endl;
-                supervisor.notify_end(thread_id);
-                usleep(500000); // 200ms
-            }else if(distance < 0){
-                cerr << "\u274c Error: Distancia no válida." << endl;
-                supervisor.recovery_thread(thread_id);
+
+    if (distance > 0 && distance < DISTANCE_THRESHOLD_CM && !detected_car) {
+        time_t now = time(nullptr);
+        detected_car = true;
+        lane.occupied.store(1, memory_order_relaxed);
+
+        if (difftime(now, last_detection) >= DEBOUNCE_TIME_S) {
+            VehicleEvent* vehicle = vehiclePool.acquire();
+            if (!vehicle) {
+                LOG_ERROR("\u274c Sin registros de vehículo libres, se pierde la detección.");
+                pipelineMetrics.events_dropped.inc();
             } else {
-                cout << "Distancia medida: " << distance << " cm" << endl;
+                vehicle->id = next_event_id();
+                vehicle->distance_cm = distance;
+                vehicle->stamp(Stage::Detect, measured_at);
+                pipelineMetrics.vehicles_detected.inc();
+                lane.last_vehicle_id.store(vehicle->id, memory_order_relaxed);
+                LOG_INFO("\u2705 Presencia detectada! Vehículo #%" PRIu64 " Distancia: %.1f cm", vehicle->id, distance);
+
+                // Dispara la captura sin esperar al resto del pipeline
+                vehicle->stamp(Stage::Trigger);
+                TRACE_INSTANT("trigger", vehicle->id);
+                if (!triggerChannel.push(vehicle)) {
+                    LOG_ERROR("\u274c Canal de disparo lleno, se pierde el vehículo #%" PRIu64, vehicle->id);
+                    pipelineMetrics.events_dropped.inc();
+                    release_vehicle(vehicle);
+                } else {
+                    // Mientras la cámara toma la foto, el comunicador prepara la conexión
+                    notifyApproach();
+                }
             }
-            supervisor.notify_end(thread_id);
-            usleep(500000); // 500 ms
+            last_detection = now;
+        }
+    } else if(detected_car && distance > DISTANCE_THRESHOLD_CM){
+        detected_car = false;
+        lane.occupied.store(0, memory_order_relaxed);
+        decisionChannel.wake();
+        LOG_INFO("\u274c Vehículo saliendo.");
+    }else if(distance < 0){
+        LOG_WARN("\u274c Error: Distancia no válida.");
+        return false;
+    } else {
+        LOG_DEBUG("Distancia medida: %.1f cm", distance);
+    }
+    return true;
+}
+
+/**
+ * Hilo de detección de vehículos con el sensor ultrasónico.
+ * Mide en instantes fijos cada SAMPLE_PERIOD, independientemente de cuánto
+ * tarde cada medición; una medición que se pasa del período se cuenta como
+ * desborde y el muestreo retoma su fase.
+ * @param ctx Contexto de la generación del hilo (supervisor, cancelación y latido)
+ */
+void threadSensor(WorkerContext& ctx) {
+    VehicleDetector detector;
+    ctx.sleep_for(chrono::seconds(1));
+    
+    try {
+        PeriodicTimer sampling(SAMPLE_PERIOD, chrono::nanoseconds::zero(), ctx.periodic_stats());
+        while (ctx.wait_next(sampling)) {
+            // Notifica el inicio del hilo al supervisor
+            ctx.iteration_start();
+
+            if (!detector.sample()) ctx.recover();
+
+            ctx.iteration_end();
         }
     } catch (const exception &e) {
-        cerr << "Error: " << e.what() << endl;
-        supervisor.recovery_thread(thread_id);
+        LOG_ERROR("Error: %s", e.what());
+        ctx.recover();
     } 
-
-    gpioTerminate();
 }
@@ -2,9 +2,52 @@
 #define SENSOR_H
 #include "supervisor.h"
 #include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
 
 using namespace std;
 
-void threadSensor(ThreadSupervisor& supervisor, atomic<bool>& running, int thread_id);
+/** Período de muestreo del sensor (instantes absolutos, sin corrimiento) */
+inline constexpr chrono::milliseconds SAMPLE_PERIOD(500);
+
+/** Espera máxima del eco, por flanco */
+inline constexpr chrono::microseconds SENSOR_ECHO_TIMEOUT(100000);
+
+/** Peor duración de una medición: pausa previa al disparo y los dos flancos esperados hasta el límite */
+inline constexpr chrono::microseconds SENSOR_WORST_MEASURE = chrono::milliseconds(2) + 2 * SENSOR_ECHO_TIMEOUT;
+
+class UltrasonicSensor;
+
+/**
+ * Clase VehicleDetector
+ * Detección de vehículos en el carril: cada sample() mide la distancia,
+ * publica el estado del carril y, al llegar un vehículo, toma un registro del
+ * pool y dispara la captura por `triggerChannel`. La usan el hilo del sensor y
+ * el runtime de event loop.
+ */
+class VehicleDetector {
+public:
+    /**
+     * Configura los pines del sensor (espera 50 ms a que se estabilice).
+     * @param echo_timeout Espera máxima del eco por flanco; quien mide dentro
+     *        de un event loop la acota a su presupuesto de despacho
+     */
+    explicit VehicleDetector(chrono::microseconds echo_timeout = SENSOR_ECHO_TIMEOUT);
+    ~VehicleDetector();
+
+    /**
+     * Una medición completa; bloquea hasta el eco (a lo sumo echo_timeout por flanco).
+     * @return false si la distancia medida no fue válida
+     */
+    bool sample();
+
+private:
+    unique_ptr<UltrasonicSensor> sensor;
+    bool detected_car = false;
+    time_t last_detection = 0;
+};
+
+void threadSensor(WorkerContext& ctx);
 
 #endif
\ No newline at end of file
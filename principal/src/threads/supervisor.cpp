@@ -1,38 +1,60 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
-#include <unordered_map>
 #include <functional>
 #include <mutex>
-#include <condition_variable>
+#include <vector>
+#include <climits>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include "supervisor.h"
+#include "../logger.h"
+#include "../tracer.h"
 
 using namespace std;
 using namespace chrono;
 
-// Estructura que almacena la información relevante de cada hilo supervisado
-struct ThreadInfo {
-    microseconds expected_duration;                      // Duración máxima esperada del ciclo del hilo
-    time_point<steady_clock> last_start_time;            // Última vez que el hilo comenzó a ejecutarse
-    atomic<bool> is_running;                             // Indica si el hilo está actualmente ejecutándose
-    function<void()> recovery_function;                  // Función de recuperación en caso de timeout
-    uint32_t timeout_count{0};                           // Contador de timeouts consecutivos
-};
-
 /**
  * Constructor de la clase ThreadSupervisor.
- * Inicializa el hilo de supervisión para monitorear los hilos registrados.
+ * Abre el timerfd y el eventfd del monitor e inicia el hilo de supervisión.
  */
-ThreadSupervisor::ThreadSupervisor() 
-    : supervisor_thread(&ThreadSupervisor::monitor_threads, this) {}
+ThreadSupervisor::ThreadSupervisor() {
+    timer.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    timer.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (timer.timer_fd < 0 || timer.wake_fd < 0) {
+        cerr << "[SUPERVISOR] Error creando timerfd/eventfd" << endl;
+    }
+    supervisor_thread = thread(&ThreadSupervisor::monitor_threads, this);
+    recovery_executor = thread(&ThreadSupervisor::recovery_worker, this);
+}
 
 /**
  * Destructor de la clase ThreadSupervisor.
  * Señala el cierre y espera a que el hilo de monitoreo finalice.
  */
 ThreadSupervisor::~ThreadSupervisor() {
+    // Una generación abandonada que vuelve ya no puede pedir recuperaciones
+    for (auto& lc : lifecycles) {
+        lock_guard<PiMutex> lock(lc.shared->link_mutex);
+        lc.shared->supervisor = nullptr;
+    }
     shutdown = true;
+    wake_monitor();
+    recovery_signal.notify();
     supervisor_thread.join();
+    recovery_executor.join();
+    if (timer.timer_fd >= 0) close(timer.timer_fd);
+    if (timer.wake_fd >= 0) close(timer.wake_fd);
+}
+
+/**
+ * Despierta al monitor para que recalcule el próximo plazo.
+ */
+void ThreadSupervisor::wake_monitor() {
+    timer.wake();
 }
 
 /**
@@ -45,14 +67,18 @@ void ThreadSupervisor::set_running_flag(atomic<bool>* flag) {
 
 /**
  * Detiene la ejecución de todos los hilos registrados.
- * Establece las banderas `is_running` en falso para todos los hilos.
+ * Desactiva la detección de timeouts para que el apagado no dispare recuperaciones.
  */
 void ThreadSupervisor::shutdown_all() {
     if (running_flag) *running_flag = false;
+    supervising = false;
+    wake_monitor();
 
-    lock_guard<mutex> lock(threads_mutex);
-    for (auto& [id, info] : threads_info) {
-        info.is_running = false;
+    // Interrumpe las esperas de los hilos administrados para que vean el apagado
+    lock_guard<PiMutex> lock(lifecycle_mutex);
+    for (auto& lc : lifecycles) {
+        lc.shared->stopping.store(true, memory_order_relaxed);
+        if (lc.ctx) lc.ctx->interrupt();
     }
 }
 
@@ -61,97 +87,724 @@ void ThreadSupervisor::shutdown_all() {
  * @param thread_id ID único del hilo.
  * @param expected_time Tiempo máximo esperado por iteración.
  * @param recovery_func Función de recuperación ante un posible cuelgue.
+ * @return Handle de latido del hilo (inválido si no quedan slots libres).
+ */
+Heartbeat ThreadSupervisor::register_thread(int thread_id, microseconds expected_time, function<void()> recovery_func) {
+    lock_guard<PiMutex> lock(register_mutex);
+    if (HeartbeatSlot* existing = find_slot(thread_id)) return Heartbeat(existing);
+
+    for (auto& slot : slots) {
+        if (slot.registered.load(memory_order_relaxed)) continue;
+        slot.thread_id = thread_id;
+        slot.expected_duration = expected_time;
+        slot.budget_ns.store(duration_cast<nanoseconds>(expected_time).count(), memory_order_relaxed);
+        slot.timer = &timer;
+        slot.recovery_function = move(recovery_func);
+        slot.timeout_count = 0;
+        slot.stats = &slot_stats[&slot - slots.data()];
+        slot.registered.store(true, memory_order_release);
+        return Heartbeat(&slot);
+    }
+    return Heartbeat();
+}
+
+/**
+ * Registra un hilo de trabajo que el propio supervisor crea y, si se cuelga,
+ * reinicia. El hilo no arranca hasta start_workers().
+ * @param thread_id ID único del hilo.
+ * @param expected_time Tiempo máximo esperado por iteración.
+ * @param recovery_func Función de recuperación ante un posible cuelgue.
+ * @param factory Cuerpo del hilo; recibe el contexto de su generación.
+ * @param restart_after Múltiplos del plazo estático (el techo si el presupuesto
+ *        es adaptativo) que puede durar una iteración antes de abandonar la
+ *        generación actual y crear otra (0 = nunca). Con presupuesto fijo
+ *        equivale a esa cantidad de timeouts seguidos.
+ * @param exclusive Las generaciones usan un mismo dispositivo (por ejemplo la
+ *        cámara): la nueva no arranca hasta que la abandonada termine.
+ * @return Handle de latido del hilo (inválido si no quedan slots libres).
+ */
+Heartbeat ThreadSupervisor::register_worker(int thread_id, microseconds expected_time,
+                                            function<void()> recovery_func,
+                                            function<void(WorkerContext&)> factory,
+                                            uint32_t restart_after, bool exclusive) {
+    Heartbeat hb = register_thread(thread_id, expected_time, move(recovery_func));
+    HeartbeatSlot* slot = find_slot(thread_id);
+    if (!slot) return hb;
+
+    WorkerLifecycle& lc = lifecycles[slot - slots.data()];
+    lock_guard<PiMutex> lock(lifecycle_mutex);
+    lc.factory = move(factory);
+    lc.restart_after = restart_after;
+    lc.exclusive = exclusive;
+    lock_guard<PiMutex> link(lc.shared->link_mutex);
+    lc.shared->supervisor = this;
+    return hb;
+}
+
+/**
+ * Crea la primera generación de cada hilo registrado con register_worker().
+ */
+void ThreadSupervisor::start_workers() {
+    lock_guard<PiMutex> lock(lifecycle_mutex);
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (lifecycles[i].factory && !lifecycles[i].ctx) spawn_worker(i);
+    }
+}
+
+/**
+ * Espera a que terminen los hilos administrados (después de shutdown_all()).
+ * Un hilo que no termina dentro de `grace` se abandona, para que el apagado
+ * no quede bloqueado por una llamada que nunca vuelve.
+ * @param grace Tiempo máximo de espera total.
+ * @return false si alguna generación (actual o abandonada antes) sigue viva:
+ *         quien llama no debe liberar lo que esos hilos usan ni destruir el
+ *         supervisor.
+ */
+bool ThreadSupervisor::join_workers(milliseconds grace) {
+    auto deadline = steady_clock::now() + grace;
+    vector<shared_ptr<WorkerContext>> waiting;
+    {
+        lock_guard<PiMutex> lock(lifecycle_mutex);
+        for (auto& lc : lifecycles) {
+            if (lc.ctx) {
+                lc.ctx->interrupt();
+                waiting.push_back(lc.ctx);
+            }
+            waiting.insert(waiting.end(), lc.abandoned.begin(), lc.abandoned.end());
+        }
+    }
+
+    // La espera no toma lifecycle_mutex
+    for (auto& ctx : waiting) {
+        while (!ctx->exited() && steady_clock::now() < deadline) {
+            this_thread::sleep_for(restart_poll);
+        }
+    }
+
+    bool all_exited = true;
+    lock_guard<PiMutex> lock(lifecycle_mutex);
+    for (auto& lc : lifecycles) {
+        if (lc.worker.joinable()) {
+            if (lc.ctx->exited()) {
+                lc.worker.join();
+            } else {
+                LOG_WARN("[SUPERVISOR] Hilo %d no terminó, se abandona.", lc.ctx->thread_id);
+                lc.worker.detach();
+                lc.abandoned.push_back(lc.ctx);
+            }
+        }
+        erase_if(lc.abandoned, [](const shared_ptr<WorkerContext>& ctx) { return ctx->exited(); });
+        if (!lc.abandoned.empty()) all_exited = false;
+    }
+    return all_exited;
+}
+
+/**
+ * Crea una nueva generación del hilo del slot indicado.
+ * Requiere lifecycle_mutex tomado.
+ * @param index Índice del slot.
+ */
+void ThreadSupervisor::spawn_worker(size_t index) {
+    WorkerLifecycle& lc = lifecycles[index];
+    lc.generation++;
+    lc.ctx = make_shared<WorkerContext>(lc.shared, slots[index].thread_id, lc.generation, Heartbeat(&slots[index]));
+    // El hilo conserva su propio contexto y copia del cuerpo aunque se lo abandone
+    lc.worker = thread([ctx = lc.ctx, body = lc.factory]() {
+        try {
+            body(*ctx);
+        } catch (const exception& e) {
+            LOG_ERROR("[SUPERVISOR] Excepción no atendida en hilo %d: %s", ctx->thread_id, e.what());
+        }
+        ctx->mark_exited();
+    });
+}
+
+/**
+ * Avanza el reemplazo de la generación colgada de un hilo. No bloquea: el
+ * ejecutor de recuperaciones lo vuelve a llamar hasta que termina.
+ *
+ * Cancela la generación actual y le da restart_grace para salir por sí sola;
+ * si no lo hace (por ejemplo, bloqueada en una llamada sin timeout) se la
+ * abandona con detach(): ya no puede latir ni completar el evento en curso,
+ * que pasa a la nueva generación. Si el hilo es exclusivo, la nueva
+ * generación espera a que la abandonada salga del dispositivo.
+ * @param index Índice del slot.
+ * @return Instante (ns de steady_clock) en que volver a llamar, o INT64_MAX
+ *         si el reinicio terminó o se descartó.
+ */
+int64_t ThreadSupervisor::restart_worker(size_t index) {
+    lock_guard<PiMutex> lock(lifecycle_mutex);
+    WorkerLifecycle& lc = lifecycles[index];
+    HeartbeatSlot& slot = slots[index];
+    uint32_t bit = 1u << index;
+    int64_t now = steady_clock::now().time_since_epoch().count();
+    auto to_ns = [](auto d) { return duration_cast<nanoseconds>(d).count(); };
+
+    if (!lc.factory || shutdown || !supervising || (!lc.ctx && lc.abandoned.empty())) {
+        pending_restarts.fetch_and(~bit, memory_order_acq_rel);
+        return INT64_MAX;
+    }
+
+    if (lc.ctx) {
+        if (lc.cancel_deadline_ns == 0) {
+            TRACE_INSTANT("restart", static_cast<uint64_t>(slot.thread_id));
+            LOG_WARN("[SUPERVISOR] Reiniciando hilo %d (generación %u → %u)", slot.thread_id, lc.generation, lc.generation + 1);
+            lc.ctx->cancel();
+            lc.cancel_deadline_ns = now + to_ns(restart_grace);
+        }
+        if (!lc.ctx->exited() && now < lc.cancel_deadline_ns) {
+            return min(now + to_ns(restart_poll), lc.cancel_deadline_ns);
+        }
+
+        if (lc.ctx->exited()) {
+            lc.worker.join();
+        } else {
+            LOG_WARN("[SUPERVISOR] Generación %u del hilo %d no respondió, se abandona.", lc.generation, slot.thread_id);
+            lc.worker.detach();
+            lc.abandoned.push_back(lc.ctx);
+            if (lc.exclusive) {
+                LOG_WARN("[SUPERVISOR] Hilo %d: la nueva generación espera a que la abandonada libere el dispositivo.", slot.thread_id);
+            }
+        }
+        lc.ctx.reset();
+        lc.cancel_deadline_ns = 0;
+
+        // La iteración colgada deja de contar como en ejecución. Con compare_exchange:
+        // si la generación abandonada volvió y cerró su iteración, no se la vuelve a cerrar
+        uint64_t epoch = slot.epoch.load(memory_order_relaxed);
+        if ((epoch & 1) && slot.epoch.compare_exchange_strong(epoch, epoch + 1, memory_order_seq_cst)) {
+            timer.running.fetch_sub(1, memory_order_seq_cst);
+        }
+        slot.timeout_count.store(0, memory_order_relaxed);
+    }
+
+    erase_if(lc.abandoned, [](const shared_ptr<WorkerContext>& ctx) { return ctx->exited(); });
+    if (lc.exclusive && !lc.abandoned.empty()) return now + to_ns(restart_grace);
+
+    spawn_worker(index);
+    lc.restarts.fetch_add(1, memory_order_relaxed);
+
+    // Los timeouts detectados durante la espera se refieren a la generación abandonada
+    pending_restarts.fetch_and(~bit, memory_order_acq_rel);
+    return INT64_MAX;
+}
+
+/**
+ * Marca como pendiente el reinicio del slot indicado. No bloquea.
+ * @param index Índice del slot.
+ */
+void ThreadSupervisor::request_restart(size_t index) {
+    uint32_t bit = 1u << index;
+    if (!(pending_restarts.fetch_or(bit, memory_order_acq_rel) & bit)) {
+        recovery_signal.notify();
+    }
+}
+
+/**
+ * Pasa un hilo registrado a presupuesto adaptativo. Debe llamarse antes de
+ * que el hilo arranque (el ajuste lo hace el propio hilo sin locks).
+ * @param thread_id ID del hilo.
+ * @param config Cuantil, margen, cotas y tamaños de ventana.
+ * @return false si el hilo no está registrado.
+ */
+bool ThreadSupervisor::enable_adaptive_budget(int thread_id, AdaptiveBudget config) {
+    HeartbeatSlot* slot = find_slot(thread_id);
+    if (!slot) return false;
+
+    if (config.ceiling <= microseconds::zero()) config.ceiling = slot->expected_duration;
+    if (config.floor <= microseconds::zero()) config.floor = config.ceiling / 20;
+    if (config.floor > config.ceiling) config.floor = config.ceiling;
+    if (config.window == 0) config.window = 1;
+
+    slot->adaptive = config;
+    slot->stats->budget_window.reset();
+    slot->stats->warmed_up = false;
+    // Durante el calentamiento rige el techo
+    slot->budget_ns.store(duration_cast<nanoseconds>(config.ceiling).count(), memory_order_relaxed);
+    slot->adaptive_enabled.store(true, memory_order_release);
+    return true;
+}
+
+/**
+ * Plazo estático del hilo: el techo si el presupuesto es adaptativo o el
+ * tiempo del registro si no. Es la referencia para decidir reinicios.
+ */
+int64_t ThreadSupervisor::static_budget_ns(const HeartbeatSlot& slot) {
+    auto ceiling = slot.adaptive_enabled.load(memory_order_acquire) ? slot.adaptive.ceiling : slot.expected_duration;
+    return duration_cast<nanoseconds>(ceiling).count();
+}
+
+/**
+ * Busca el slot de un hilo registrado, sin tomar locks.
+ * @param thread_id ID del hilo.
+ * @return Puntero al slot o nullptr si el hilo no está registrado.
+ */
+HeartbeatSlot* ThreadSupervisor::find_slot(int thread_id) {
+    for (auto& slot : slots) {
+        if (slot.registered.load(memory_order_acquire) && slot.thread_id == thread_id) return &slot;
+    }
+    return nullptr;
+}
+
+/**
+ * Devuelve el handle de latido de un hilo ya registrado.
+ * Los hilos lo obtienen una vez al arrancar y lo usan en cada iteración.
+ * @param thread_id ID del hilo.
  */
-void ThreadSupervisor::register_thread(int thread_id, microseconds expected_time, function<void()> recovery_func) {
-    lock_guard<mutex> lock(threads_mutex);
-    threads_info.emplace(
-        piecewise_construct,
-        forward_as_tuple(thread_id),
-        forward_as_tuple(
-            expected_time,
-            steady_clock::now(),
-            false,
-            recovery_func,
-            0
-        )
-    );
+Heartbeat ThreadSupervisor::heartbeat(int thread_id) {
+    return Heartbeat(find_slot(thread_id));
 }
 
 /**
  * Notifica que un hilo ha comenzado su ejecución.
+ * Equivale a heartbeat(thread_id).start(); los hilos deberían guardar el handle.
  * @param thread_id ID del hilo que inicia.
  */
 void ThreadSupervisor::notify_start(int thread_id) {
-    lock_guard<mutex> lock(threads_mutex);
-    if (threads_info.count(thread_id)) {
-        threads_info[thread_id].last_start_time = steady_clock::now();
-        threads_info[thread_id].is_running = true;
-    }
+    heartbeat(thread_id).start();
 }
 
 /**
  * Notifica que un hilo ha finalizado su ejecución correctamente.
- * Reinicia el contador de timeouts.
+ * Equivale a heartbeat(thread_id).end(); los hilos deberían guardar el handle.
  * @param thread_id ID del hilo que termina.
  */
 void ThreadSupervisor::notify_end(int thread_id) {
-    lock_guard<mutex> lock(threads_mutex);
-    if (threads_info.count(thread_id)) {
-        threads_info[thread_id].is_running = false;
-        threads_info[thread_id].timeout_count = 0;
-    }
+    heartbeat(thread_id).end();
 }
 
 /**
- * Ejecuta la función de recuperación asociada a un hilo específico.
+ * Pide la ejecución de la función de recuperación asociada a un hilo específico.
+ * La recuperación corre en el hilo ejecutor, de forma asíncrona; los pedidos
+ * repetidos mientras hay uno pendiente se unifican.
  * Reinicia el contador de timeouts de ese hilo.
  * @param thread_id ID del hilo a recuperar.
  */
 void ThreadSupervisor::recovery_thread(int thread_id) {
-    function<void()> func;
+    HeartbeatSlot* slot = find_slot(thread_id);
+    if (!slot) return;
+    slot->timeout_count.store(0, memory_order_relaxed);
+    request_recovery(static_cast<size_t>(slot - slots.data()));
+}
 
-    {
-        lock_guard<mutex> lock(threads_mutex);
-        if (threads_info.count(thread_id)) {
-            auto& info = threads_info[thread_id];
-            func = info.recovery_function;
-            info.timeout_count = 0;
+/**
+ * Marca como pendiente la recuperación del slot indicado y despierta al ejecutor
+ * solo si no estaba ya pendiente. No bloquea.
+ * @param index Índice del slot.
+ */
+void ThreadSupervisor::request_recovery(size_t index) {
+    uint32_t bit = 1u << index;
+    if (!(pending_recoveries.fetch_or(bit, memory_order_acq_rel) & bit)) {
+        recovery_signal.notify();
+    }
+}
+
+/**
+ * Hilo ejecutor de recuperaciones.
+ *
+ * Atiende los pedidos pendientes de a uno, fuera del monitor, por lo que una
+ * recuperación lenta (o que no vuelve) no frena la supervisión del resto.
+ * Por cada hilo aplica:
+ * - Backoff exponencial: tras cada intento, el siguiente se posterga
+ *   backoff_base * 2^(intentos-1), hasta backoff_max.
+ * - Cortacircuitos: tras breaker_threshold intentos sin que el hilo complete
+ *   una iteración, se suprimen los pedidos durante breaker_open_time; luego
+ *   se permite un intento de prueba. Cualquier iteración completa lo cierra.
+ */
+void ThreadSupervisor::recovery_worker() {
+    Logger::instance().set_thread_name("recuperacion");
+    Tracer::instance().set_thread_name("recuperacion");
+    auto to_ns = [](auto d) { return duration_cast<nanoseconds>(d).count(); };
+
+    while (!shutdown) {
+        uint32_t seq = recovery_signal.prepare();
+
+        // Los reinicios tienen prioridad: la función de recuperación no alcanzó.
+        // Cada uno avanza sin bloquear; los que esperan a su generación vieja siguen pendientes
+        int64_t next_wake = INT64_MAX;
+        uint32_t restarts = pending_restarts.load(memory_order_acquire);
+        for (size_t i = 0; i < MAX_THREADS && !shutdown; i++) {
+            if (restarts & (1u << i)) next_wake = min(next_wake, restart_worker(i));
+        }
+
+        uint32_t mask = pending_recoveries.load(memory_order_acquire);
+
+        for (size_t i = 0; i < MAX_THREADS && !shutdown; i++) {
+            uint32_t bit = 1u << i;
+            if (!(mask & bit)) continue;
+
+            HeartbeatSlot& slot = slots[i];
+            RecoveryState& st = recovery_states[i];
+            int64_t now = steady_clock::now().time_since_epoch().count();
+
+            // Si el hilo completó iteraciones desde el último intento, la recuperación funcionó
+            uint64_t progress = slot.stats->exec_time.count();
+            if (st.attempts > 0 && progress != st.progress_mark) {
+                st.attempts = 0;
+                st.next_allowed_ns = 0;
+                if (st.breaker.load() != BreakerState::Closed) {
+                    LOG_INFO("[SUPERVISOR] Hilo %d recuperado, cortacircuitos cerrado.", slot.thread_id);
+                }
+                st.breaker = BreakerState::Closed;
+            }
+
+            if (st.breaker.load() == BreakerState::Open) {
+                if (now < st.open_until_ns) {
+                    st.suppressed.fetch_add(1, memory_order_relaxed);
+                    pending_recoveries.fetch_and(~bit, memory_order_acq_rel);
+                    continue;
+                }
+                st.breaker = BreakerState::HalfOpen;
+            }
+
+            if (now < st.next_allowed_ns) {
+                next_wake = min(next_wake, st.next_allowed_ns);
+                continue;
+            }
+
+            pending_recoveries.fetch_and(~bit, memory_order_acq_rel);
+            auto t0 = steady_clock::now();
+            try {
+                TRACE_SCOPE("recovery", static_cast<uint64_t>(slot.thread_id));
+                if (slot.recovery_function) slot.recovery_function();
+            } catch (const exception& e) {
+                LOG_ERROR("[SUPERVISOR] Excepción en recuperación del hilo %d: %s", slot.thread_id, e.what());
+            }
+            st.duration.record(to_ns(steady_clock::now() - t0));
+            st.executed.fetch_add(1, memory_order_relaxed);
+
+            now = steady_clock::now().time_since_epoch().count();
+            st.attempts++;
+            st.progress_mark = slot.stats->exec_time.count();
+            int64_t backoff = to_ns(backoff_base) << min<uint32_t>(st.attempts - 1, 20);
+            st.next_allowed_ns = now + min(backoff, to_ns(backoff_max));
+
+            if (st.breaker.load() == BreakerState::HalfOpen || st.attempts >= breaker_threshold) {
+                st.breaker = BreakerState::Open;
+                st.open_until_ns = now + to_ns(breaker_open_time);
+                LOG_ERROR("[SUPERVISOR] Hilo %d: %u recuperaciones sin progreso, cortacircuitos abierto por %lld s",
+                          slot.thread_id, st.attempts, static_cast<long long>(breaker_open_time.count() / 1000));
+            }
+        }
+
+        if (shutdown) break;
+
+        // Los pedidos que lleguen después de prepare() despiertan la espera de inmediato
+        if (next_wake == INT64_MAX) {
+            recovery_signal.wait(seq);
+            continue;
+        }
+        int64_t now = steady_clock::now().time_since_epoch().count();
+        recovery_signal.wait_for(seq, nanoseconds(max<int64_t>(next_wake - now, 0)));
+    }
+}
+
+/**
+ * Copia las estadísticas de tiempos de un hilo registrado.
+ * @param thread_id ID del hilo.
+ * @param out Estadísticas del hilo (percentiles, WCET y margen mínimo).
+ * @return false si el hilo no está registrado.
+ */
+bool ThreadSupervisor::timing_stats(int thread_id, ThreadTimingStats& out) {
+    HeartbeatSlot* slot = find_slot(thread_id);
+    if (!slot) return false;
+    out.thread_id = slot->thread_id;
+    out.budget = slot->expected_duration;
+    out.exec = slot->stats->exec_time.snapshot();
+    out.wcet_ns = slot->stats->wcet_ns.load(memory_order_relaxed);
+    int64_t slack = slot->stats->min_slack_ns.load(memory_order_relaxed);
+    out.current_budget_ns = slot->budget_ns.load(memory_order_relaxed);
+    out.adaptive = slot->adaptive_enabled.load(memory_order_acquire);
+    out.budget_updates = slot->stats->budget_updates.load(memory_order_relaxed);
+    out.min_slack_ns = slack == INT64_MAX ? out.current_budget_ns : slack;
+    out.timeouts = slot->timeouts_total.load(memory_order_relaxed);
+    size_t index = static_cast<size_t>(slot - slots.data());
+    out.recoveries = recovery_states[index].executed.load(memory_order_relaxed);
+    out.restarts = lifecycles[index].restarts.load(memory_order_relaxed);
+    out.in_iteration = slot->epoch.load(memory_order_acquire) & 1;
+    out.last_start_ns = slot->start_ns.load(memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Copia las estadísticas de tiempos de todos los hilos registrados.
+ */
+vector<ThreadTimingStats> ThreadSupervisor::timing_stats() {
+    vector<ThreadTimingStats> all;
+    for (auto& slot : slots) {
+        ThreadTimingStats stats;
+        if (slot.registered.load(memory_order_acquire) && timing_stats(slot.thread_id, stats)) {
+            all.push_back(stats);
+        }
+    }
+    return all;
+}
+
+/**
+ * Imprime una tabla con la distribución de tiempos de cada hilo, útil para
+ * dimensionar los presupuestos de register_thread() a partir de datos reales.
+ */
+void ThreadSupervisor::print_timing_report() {
+    auto ms = [](double ns) { return ns / 1e6; };
+    cout << "[SUPERVISOR] Tiempos de ejecución por hilo (ms):" << endl;
+    for (const auto& st : timing_stats()) {
+        cout << "  hilo " << st.thread_id
+             << ": n=" << st.exec.count
+             << " p50=" << ms(st.exec.p50)
+             << " p99=" << ms(st.exec.p99)
+             << " p999=" << ms(st.exec.p999)
+             << " max=" << ms(st.exec.max)
+             << " wcet=" << ms(st.wcet_ns)
+             << " presupuesto=" << ms(st.current_budget_ns)
+             << (st.adaptive ? " (adaptativo, " + to_string(st.budget_updates) + " ajustes)" : "")
+             << " margen_min=" << ms(st.min_slack_ns)
+             << " timeouts=" << st.timeouts << endl;
+    }
+
+    static const char* breaker_names[] = {"cerrado", "abierto", "semiabierto"};
+    for (size_t i = 0; i < MAX_THREADS; i++) {
+        if (!slots[i].registered.load(memory_order_acquire)) continue;
+        const RecoveryState& rs = recovery_states[i];
+        HistogramSnapshot d = rs.duration.snapshot();
+        cout << "  recuperaciones hilo " << slots[i].thread_id
+             << ": ejecutadas=" << rs.executed.load()
+             << " suprimidas=" << rs.suppressed.load()
+             << " cortacircuitos=" << breaker_names[static_cast<int>(rs.breaker.load())]
+             << " duracion_max=" << ms(d.max);
+        if (lifecycles[i].factory) {
+            HistogramSnapshot mttr = slot_stats[i].recovery_time.snapshot();
+            cout << " reinicios=" << lifecycles[i].restarts.load()
+                 << " mttr_p50=" << ms(mttr.p50)
+                 << " mttr_max=" << ms(mttr.max);
         }
+        cout << endl;
+    }
+
+    for (const auto& slot : slots) {
+        if (!slot.registered.load(memory_order_acquire)) continue;
+        const PeriodicStats& ps = slot.stats->periodic;
+        if (ps.activations.load() == 0) continue;
+        HistogramSnapshot j = ps.jitter.snapshot();
+        cout << "  periódico hilo " << slot.thread_id
+             << ": periodo=" << ms(ps.period_ns.load())
+             << " activaciones=" << ps.activations.load()
+             << " jitter p50=" << j.p50 / 1000.0 << " us p99=" << j.p99 / 1000.0
+             << " us max=" << j.max / 1000.0 << " us"
+             << " desbordes=" << ps.overruns.load()
+             << " saltadas=" << ps.skipped.load() << endl;
     }
 
-    if (func) func();
+    MonitorStats ms_stats = monitor_stats();
+    cout << "  monitor: despertar p50=" << ms_stats.wake_latency.p50 / 1000.0
+         << " us p99=" << ms_stats.wake_latency.p99 / 1000.0
+         << " us max=" << ms_stats.wake_latency.max / 1000.0
+         << " us; trabajo por vuelta max=" << ms_stats.busy_time.max / 1000.0 << " us" << endl;
+}
+
+/**
+ * Devuelve la demora de despertar y el tiempo de trabajo por vuelta del monitor.
+ */
+MonitorStats ThreadSupervisor::monitor_stats() const {
+    return {monitor_wake_latency.snapshot(), monitor_busy_time.snapshot()};
 }
 
 /**
  * Función que ejecuta el hilo de monitoreo.
- * Verifica periódicamente si algún hilo ha superado su tiempo de ejecución esperado
- * y, de ser así, ejecuta su función de recuperación.
+ *
+ * En lugar de revisar cada intervalo fijo, el monitor duerme en un timerfd
+ * armado al plazo más próximo entre los hilos en ejecución. Un hilo que
+ * inicia con un plazo anterior al armado rearma el timerfd él mismo, sin
+ * despertar al monitor; los plazos de iteraciones ya terminadas se
+ * descartan al comparar la época.
+ * Con los slots fijos (MAX_THREADS) recalcular el mínimo recorriéndolos es
+ * más barato que mantener un heap. Sin hilos en ejecución no hay despertares.
+ *
+ * Si un hilo sigue excedido, se vuelve a pedir su recuperación cada vez que
+ * se cumple otro período de su presupuesto. El monitor nunca ejecuta una
+ * recuperación: solo la marca como pendiente para el hilo ejecutor.
  */
 void ThreadSupervisor::monitor_threads() {
+    Logger::instance().set_thread_name("monitor");
+    Tracer::instance().set_thread_name("monitor");
+
+    // Estado privado del monitor por slot
+    array<uint64_t, MAX_THREADS> tracked_epoch{};   // Época cuyo plazo está armado
+    array<int64_t, MAX_THREADS> next_check{};       // Próximo plazo a verificar (ns)
+
+    pollfd fds[2] = {{timer.timer_fd, POLLIN, 0}, {timer.wake_fd, POLLIN, 0}};
+
     while (!shutdown) {
-        this_thread::sleep_for(check_interval); // Intervalo de chequeo
+        // Mientras se recorre, cualquier hilo que inicia arma su propio plazo
+        timer.armed.store(INT64_MAX, memory_order_seq_cst);
+
+        int64_t earliest = INT64_MAX;
+        int64_t now = steady_clock::now().time_since_epoch().count();
 
-        vector<function<void()>> recoveries;
+        for (size_t i = 0; i < slots.size() && supervising; i++) {
+            HeartbeatSlot& slot = slots[i];
+            if (!slot.registered.load(memory_order_acquire)) continue;
 
-        {
-            lock_guard<mutex> lock(threads_mutex);
-            auto now = steady_clock::now();
+            uint64_t epoch = slot.epoch.load(memory_order_seq_cst);
+            if (!(epoch & 1)) continue;
 
-            for (auto& [id, info] : threads_info) {
-                if (info.is_running) {
-                    auto elapsed = duration_cast<microseconds>(now - info.last_start_time);
+            if (tracked_epoch[i] != epoch) {
+                // Nueva iteración: se arma su plazo y se reinicia el conteo de timeouts
+                tracked_epoch[i] = epoch;
+                next_check[i] = slot.start_ns.load(memory_order_relaxed) + slot.budget_ns.load(memory_order_relaxed);
+                slot.timeout_count.store(0, memory_order_relaxed);
+            }
 
-                    if (elapsed > info.expected_duration) {
-                        info.timeout_count++;
-                        recoveries.push_back(info.recovery_function);
-                    }
+            if (now >= next_check[i]) {
+                auto late_us = (now - next_check[i]) / 1000;
+                int64_t budget = slot.budget_ns.load(memory_order_relaxed);
+                uint32_t count = slot.timeout_count.fetch_add(1, memory_order_relaxed) + 1;
+                slot.timeouts_total.fetch_add(1, memory_order_relaxed);
+                LOG_WARN("[SUPERVISOR] Hilo %d excedió su plazo de %lld ms (timeout #%u, detectado con %lld us de retraso)",
+                         slot.thread_id, static_cast<long long>(budget / 1000000), count, static_cast<long long>(late_us));
+                TRACE_INSTANT("deadline_miss", static_cast<uint64_t>(slot.thread_id));
+                // El reinicio se decide contra el plazo estático (el techo), no contra el
+                // aprendido: una iteración lenta pero legítima solo pide recuperaciones
+                const WorkerLifecycle& lc = lifecycles[i];
+                int64_t restart_at = INT64_MAX;
+                if (lc.factory && lc.restart_after) {
+                    restart_at = slot.start_ns.load(memory_order_relaxed) + static_budget_ns(slot) * lc.restart_after;
+                }
+                if (now >= restart_at) {
+                    // La recuperación no alcanzó: se mide el MTTR desde el primer plazo incumplido
+                    int64_t hang_since = slot.start_ns.load(memory_order_relaxed) + budget;
+                    int64_t expected = 0;
+                    slot.hang_since_ns.compare_exchange_strong(expected, hang_since, memory_order_relaxed);
+                    request_restart(i);
+                    // Hilo colgado: se guarda qué venía haciendo cada hilo
+                    Tracer::instance().request_dump("hilo-colgado");
+                } else {
+                    request_recovery(i);
                 }
+                next_check[i] += budget;
+                if (restart_at > now) next_check[i] = min(next_check[i], restart_at);
             }
+            earliest = min(earliest, next_check[i]);
         }
 
-        // Ejecuta funciones de recuperación fuera del lock
-        for (auto& func : recoveries) {
-            if (func) func();
+        // Arma el timer al plazo más próximo, sin pisar uno anterior que un hilo
+        // haya armado durante el recorrido (o lo desarma si no hay ninguno)
+        timer.lower_to(earliest);
+        timer.sync();
+
+        monitor_busy_time.record(steady_clock::now().time_since_epoch().count() - now);
+
+        poll(fds, 2, -1);
+        int64_t woke = steady_clock::now().time_since_epoch().count();
+        int64_t fired = timer.armed.load(memory_order_relaxed);
+        if ((fds[0].revents & POLLIN) && fired != INT64_MAX) {
+            monitor_wake_latency.record(woke - fired);
         }
+        uint64_t drained;
+        (void)!read(timer.timer_fd, &drained, sizeof(drained));
+        (void)!read(timer.wake_fd, &drained, sizeof(drained));
+    }
+}
+
+/**
+ * Constructor del contexto de una generación de hilo administrado.
+ */
+WorkerContext::WorkerContext(shared_ptr<WorkerShared> shared, int thread_id, uint32_t generation, Heartbeat heartbeat)
+    : thread_id(thread_id), generation(generation), shared(move(shared)), heartbeat(heartbeat) {}
+
+/**
+ * Pide la recuperación del hilo. Una generación cancelada no puede pedirla,
+ * ni ninguna una vez destruido el supervisor.
+ */
+void WorkerContext::recover() {
+    if (cancel_flag.load(memory_order_relaxed)) return;
+    lock_guard<PiMutex> lock(shared->link_mutex);
+    if (shared->supervisor) shared->supervisor->recovery_thread(thread_id);
+}
+
+/**
+ * Duerme el tiempo indicado o hasta que se cancele el hilo o se apague el sistema.
+ * @return true si el hilo sigue activo al despertar.
+ */
+bool WorkerContext::sleep_for(nanoseconds duration) {
+    auto deadline = steady_clock::now() + duration;
+    for (;;) {
+        uint32_t seq = wake.prepare();
+        if (!active()) return false;
+        auto remaining = deadline - steady_clock::now();
+        if (remaining <= nanoseconds::zero()) return true;
+        wake.wait_for(seq, remaining);
+    }
+}
+
+/**
+ * Duerme hasta un instante absoluto o hasta que se cancele el hilo o se apague el sistema.
+ * @return true si el hilo sigue activo al despertar.
+ */
+bool WorkerContext::wait_until(steady_clock::time_point deadline) {
+    for (;;) {
+        uint32_t seq = wake.prepare();
+        if (!active()) return false;
+        if (steady_clock::now() >= deadline) return true;
+        wake.wait_until(seq, deadline);
     }
 }
+
+/**
+ * Espera la próxima activación de una tarea periódica (cancelable).
+ * @return false si el hilo fue cancelado o el sistema se apaga.
+ */
+bool WorkerContext::wait_next(PeriodicTimer& timer) {
+    auto release = timer.arm(steady_clock::now());
+    if (!wait_until(release)) return false;
+    timer.released(steady_clock::now());
+    return true;
+}
+
+/**
+ * Cancela esta generación: active() pasa a false y se interrumpen sus esperas.
+ */
+void WorkerContext::cancel() {
+    cancel_flag.store(true, memory_order_relaxed);
+    wake.notify();
+}
+
+/**
+ * Interrumpe sleep_for() para que el hilo revise su estado.
+ */
+void WorkerContext::interrupt() {
+    wake.notify();
+}
+
+/**
+ * Registra el evento que esta generación está procesando.
+ */
+void WorkerContext::hold_raw(void* item) {
+    lock_guard<PiMutex> lock(shared->inflight_mutex);
+    shared->inflight = item;
+    shared->inflight_generation = generation;
+}
+
+/**
+ * Toma el evento que una generación anterior dejó sin completar.
+ * @return nullptr si no hay ninguno.
+ */
+void* WorkerContext::resume_raw() {
+    lock_guard<PiMutex> lock(shared->inflight_mutex);
+    if (!shared->inflight || shared->inflight_generation == generation) return nullptr;
+    shared->inflight_generation = generation;
+    return shared->inflight;
+}
+
+/**
+ * Da por completado el evento en curso.
+ * @return false si la generación fue cancelada o si una posterior se quedó con
+ *         el evento; en ese caso quien llama no debe publicarlo ni liberarlo,
+ *         porque el reemplazo lo retoma con resume().
+ */
+bool WorkerContext::complete_raw(void* item) {
+    if (cancel_flag.load(memory_order_relaxed)) return false;
+    lock_guard<PiMutex> lock(shared->inflight_mutex);
+    if (shared->inflight != item || shared->inflight_generation != generation) return false;
+    shared->inflight = nullptr;
+    return true;
+}
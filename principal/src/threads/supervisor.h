@@ -1,72 +1,509 @@
 #ifndef SUPERVISOR_H
 #define SUPERVISOR_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <climits>
+#include <memory>
 #include <thread>
-#include <unordered_map>
 #include <functional>
-#include <mutex>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+#include "../futex_signal.h"
+#include "../latency_histogram.h"
+#include "../periodic_timer.h"
+#include "../rt_mutex.h"
 
 using namespace std;
 
+/**
+ * Configuración del presupuesto adaptativo de un hilo.
+ *
+ * El supervisor aprende en línea la distribución de duraciones de cada
+ * iteración y fija el plazo en `quantile` de la ventana reciente multiplicado
+ * por `margin`, acotado a [floor, ceiling]. Durante el calentamiento (las
+ * primeras `warmup_samples` iteraciones, por ejemplo la apertura de la cámara)
+ * rige el techo. Luego el presupuesto crece de inmediato si hace falta pero
+ * baja la mitad de la diferencia por ventana, para que una racha de
+ * iteraciones rápidas no provoque recuperaciones falsas en la siguiente lenta.
+ */
+struct AdaptiveBudget {
+    double quantile = 0.999;             // Cuantil de la ventana usado como referencia
+    double margin = 1.5;                 // Factor sobre el cuantil
+    chrono::microseconds floor{0};       // Mínimo absoluto (0 = techo / 20)
+    chrono::microseconds ceiling{0};     // Máximo absoluto (0 = expected_time del registro)
+    uint32_t warmup_samples = 32;        // Iteraciones antes del primer ajuste
+    uint32_t window = 64;                // Iteraciones entre ajustes en régimen
+};
+
+/**
+ * Timer por el que el monitor espera el plazo más próximo.
+ *
+ * Los hilos supervisados lo arman ellos mismos: al iniciar una iteración
+ * bajan `armed` si su plazo es anterior y, al terminar la última iteración en
+ * curso, desarman su propio plazo. El monitor no se despierta por cada
+ * latido, solo cuando vence un plazo; sin iteraciones en curso no hay
+ * despertares. Quien cambia `armed` sincroniza el timerfd con sync().
+ */
+struct DeadlineTimer {
+    atomic<int64_t> armed{INT64_MAX};     // Plazo armado en el timerfd (INT64_MAX = ninguno)
+    atomic<uint32_t> running{0};          // Iteraciones en curso entre todos los hilos
+    int timer_fd = -1;                    // timerfd del monitor (CLOCK_MONOTONIC, tiempo absoluto)
+    int wake_fd = -1;                     // eventfd para que el monitor recalcule los plazos
+
+    /** Arma `deadline` si vence antes que el plazo armado */
+    void lower_to(int64_t deadline) {
+        int64_t current = armed.load(memory_order_seq_cst);
+        while (deadline < current) {
+            if (armed.compare_exchange_weak(current, deadline, memory_order_seq_cst)) {
+                sync();
+                return;
+            }
+        }
+    }
+
+    /**
+     * Desarma `deadline` si es el plazo armado.
+     * @return true si lo desarmó
+     */
+    bool release(int64_t deadline) {
+        if (!armed.compare_exchange_strong(deadline, INT64_MAX, memory_order_seq_cst)) return false;
+        sync();
+        return true;
+    }
+
+    /**
+     * Lleva el timerfd al valor de `armed`. Si otro hilo lo cambió mientras
+     * tanto, repite: el último en sincronizar deja el valor vigente.
+     */
+    void sync() {
+        int64_t target = armed.load(memory_order_seq_cst);
+        for (;;) {
+            itimerspec spec{};
+            if (target != INT64_MAX) {
+                spec.it_value.tv_sec = target / 1000000000;
+                spec.it_value.tv_nsec = target % 1000000000;
+            }
+            timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+            int64_t current = armed.load(memory_order_seq_cst);
+            if (current == target) return;
+            target = current;
+        }
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        (void)!write(wake_fd, &one, sizeof(one));
+    }
+};
+
+/**
+ * Estadísticas y estado del ajuste de presupuesto de un hilo supervisado.
+ * Las escribe el hilo dueño en end() y se leen solo para reportes; viven
+ * fuera del slot para que los histogramas no agranden lo que el monitor recorre.
+ */
+struct HeartbeatStats {
+    LatencyHistogram exec_time;                  // Duración de cada iteración completa
+    atomic<int64_t> wcet_ns{0};                  // Peor tiempo de ejecución observado
+    atomic<int64_t> min_slack_ns{INT64_MAX};     // Menor margen (presupuesto - duración) observado
+    LatencyHistogram recovery_time;              // Tiempo desde el cuelgue hasta la primera iteración sana
+
+    // Presupuesto adaptativo (solo lo ajusta el hilo dueño en end())
+    LatencyHistogram budget_window;              // Duraciones desde el último ajuste
+    bool warmed_up = false;
+    atomic<uint64_t> budget_updates{0};          // Ajustes aplicados
+
+    PeriodicStats periodic;                      // Activaciones si el hilo corre con PeriodicTimer
+};
+
+/**
+ * Slot de latido de un hilo supervisado.
+ *
+ * La primera línea de caché es la del hilo dueño: `start_ns`, `epoch` y
+ * `budget_ns` se escriben en cada latido y el monitor solo las lee. Los
+ * contadores que escriben el monitor y el ejecutor de recuperaciones van en
+ * otra línea, y la configuración (fija tras el registro) en una tercera.
+ *
+ * `epoch` es impar mientras el hilo ejecuta una iteración y par cuando está
+ * ocioso. Lo escribe el hilo dueño; la única excepción es el reinicio, que
+ * cierra con compare_exchange la iteración de una generación abandonada.
+ * Cada inicio arma el plazo `start_ns + budget_ns` en el DeadlineTimer; el
+ * monitor descarta los plazos de épocas ya terminadas.
+ */
+struct alignas(64) HeartbeatSlot {
+    atomic<int64_t> start_ns{0};                 // Inicio de la iteración actual (steady_clock, ns)
+    atomic<uint64_t> epoch{0};                   // Impar = en ejecución, par = ocioso
+    atomic<int64_t> budget_ns{0};                // Plazo vigente por iteración (fijo o adaptativo)
+
+    // Escritos por el monitor y el ejecutor de recuperaciones
+    alignas(64) atomic<uint32_t> timeout_count{0}; // Timeouts consecutivos detectados por el monitor
+    atomic<uint64_t> timeouts_total{0};          // Timeouts detectados desde el arranque
+    atomic<int64_t> hang_since_ns{0};            // Plazo incumplido que originó un reinicio (0 = ninguno)
+
+    // Configuración
+    alignas(64) atomic<bool> registered{false};  // Publicado una vez completada la configuración
+    int thread_id = -1;
+    chrono::microseconds expected_duration{0};   // Duración máxima esperada del ciclo del hilo
+    DeadlineTimer* timer = nullptr;              // Timer del monitor
+    function<void()> recovery_function{nullptr}; // Función de recuperación en caso de timeout
+    atomic<bool> adaptive_enabled{false};
+    AdaptiveBudget adaptive;                     // Cotas ya resueltas a valores absolutos
+    HeartbeatStats* stats = nullptr;             // Estadísticas del hilo (fuera del slot)
+};
+
+/**
+ * Instantánea de los tiempos de ejecución de un hilo supervisado.
+ */
+struct ThreadTimingStats {
+    int thread_id = -1;
+    chrono::microseconds budget{0};      // Presupuesto configurado por iteración
+    int64_t current_budget_ns = 0;       // Presupuesto vigente (distinto si es adaptativo)
+    bool adaptive = false;
+    uint64_t budget_updates = 0;         // Ajustes del presupuesto adaptativo
+    HistogramSnapshot exec;              // Distribución de duraciones (ns)
+    int64_t wcet_ns = 0;                 // Peor caso observado
+    int64_t min_slack_ns = 0;            // Menor margen observado (negativo = se pasó del presupuesto)
+    uint64_t timeouts = 0;               // Timeouts detectados por el monitor
+    uint64_t recoveries = 0;             // Recuperaciones ejecutadas
+    uint64_t restarts = 0;               // Reinicios de la generación del hilo
+    bool in_iteration = false;           // El hilo está dentro de una iteración
+    int64_t last_start_ns = 0;           // Inicio de la última iteración (steady_clock)
+};
+
+/**
+ * Handle de latido devuelto al registrar un hilo.
+ * start() y end() no toman locks ni buscan en tablas, y no despiertan al
+ * monitor: a lo sumo rearman el timerfd.
+ */
+class Heartbeat {
+public:
+    Heartbeat() = default;
+    explicit Heartbeat(HeartbeatSlot* slot) : slot(slot) {}
+
+    /**
+     * Marca el comienzo de una iteración del hilo y arma su plazo.
+     * Solo toca el timerfd si este plazo vence antes que el armado.
+     */
+    void start() {
+        if (!slot) return;
+        uint64_t e = slot->epoch.load(memory_order_relaxed);
+        int64_t now = chrono::steady_clock::now().time_since_epoch().count();
+        slot->start_ns.store(now, memory_order_relaxed);
+        if (!(e & 1)) slot->timer->running.fetch_add(1, memory_order_seq_cst);
+        slot->epoch.store((e & 1) ? e + 2 : e + 1, memory_order_seq_cst);
+        slot->timer->lower_to(now + slot->budget_ns.load(memory_order_relaxed));
+    }
+
+    /**
+     * Marca el final de la iteración en curso (sin efecto si no había ninguna).
+     * El monitor descarta los plazos de épocas ya terminadas; si era la última
+     * iteración en curso y su plazo es el armado, lo desarma para que el
+     * monitor no despierte en vano.
+     * Registra la duración de la iteración en el histograma del hilo.
+     */
+    void end() {
+        if (!slot) return;
+        uint64_t e = slot->epoch.load(memory_order_relaxed);
+        if (!(e & 1)) return;
+        // Con compare_exchange: un reinicio pudo cerrar ya esta iteración
+        if (!slot->epoch.compare_exchange_strong(e, e + 1, memory_order_seq_cst)) return;
+
+        int64_t now = chrono::steady_clock::now().time_since_epoch().count();
+        int64_t start = slot->start_ns.load(memory_order_relaxed);
+        DeadlineTimer& timer = *slot->timer;
+        if (timer.running.fetch_sub(1, memory_order_seq_cst) == 1 &&
+            timer.release(start + slot->budget_ns.load(memory_order_relaxed)) &&
+            timer.running.load(memory_order_seq_cst) > 0) {
+            // Otro hilo empezó sin armar porque vio armado este plazo: que el monitor recalcule
+            timer.wake();
+        }
+
+        int64_t elapsed = now - start;
+        HeartbeatStats& st = *slot->stats;
+        st.exec_time.record(elapsed);
+        if (elapsed > st.wcet_ns.load(memory_order_relaxed)) {
+            st.wcet_ns.store(elapsed, memory_order_relaxed);
+        }
+        int64_t slack = slot->budget_ns.load(memory_order_relaxed) - elapsed;
+        if (slack < st.min_slack_ns.load(memory_order_relaxed)) {
+            st.min_slack_ns.store(slack, memory_order_relaxed);
+        }
+
+        // Primera iteración completa tras un reinicio: se mide el tiempo de recuperación
+        int64_t hang_since = slot->hang_since_ns.load(memory_order_relaxed);
+        if (hang_since != 0) {
+            st.recovery_time.record(now - hang_since);
+            slot->hang_since_ns.store(0, memory_order_relaxed);
+        }
+
+        if (slot->adaptive_enabled.load(memory_order_acquire)) adapt(elapsed);
+    }
+
+    bool valid() const { return slot != nullptr; }
+
+    /** Estadísticas de activación del hilo, para su PeriodicTimer */
+    PeriodicStats* periodic_stats() const { return slot ? &slot->stats->periodic : nullptr; }
+
+private:
+    HeartbeatSlot* slot = nullptr;
+
+    /**
+     * Ajusta el presupuesto del hilo con la duración de la iteración recién terminada.
+     * Cuesta un recorrido del histograma cada `window` iteraciones.
+     */
+    void adapt(int64_t elapsed) {
+        const AdaptiveBudget& cfg = slot->adaptive;
+        int64_t lo = chrono::duration_cast<chrono::nanoseconds>(cfg.floor).count();
+        int64_t hi = chrono::duration_cast<chrono::nanoseconds>(cfg.ceiling).count();
+        auto clamp_budget = [lo, hi](double ns) {
+            return ns < lo ? lo : ns > hi ? hi : static_cast<int64_t>(ns);
+        };
+
+        HeartbeatStats& st = *slot->stats;
+        int64_t current = slot->budget_ns.load(memory_order_relaxed);
+        st.budget_window.record(elapsed);
+
+        // Una iteración lenta pero viva amplía el plazo ya, en lugar de repetir el timeout
+        if (st.warmed_up && elapsed > current) {
+            slot->budget_ns.store(clamp_budget(elapsed * cfg.margin), memory_order_relaxed);
+            st.budget_updates.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        uint32_t needed = st.warmed_up ? cfg.window : cfg.warmup_samples;
+        if (st.budget_window.count() < needed) return;
+
+        int64_t target = clamp_budget(st.budget_window.percentile(cfg.quantile) * cfg.margin);
+        int64_t next = (!st.warmed_up || target >= current) ? target : current - (current - target) / 2;
+        st.warmed_up = true;
+        st.budget_window.reset();
+        if (next != current) {
+            slot->budget_ns.store(next, memory_order_relaxed);
+            st.budget_updates.fetch_add(1, memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Estado del cortacircuitos de recuperación de un hilo.
+ * Closed: se permiten recuperaciones (con backoff exponencial).
+ * Open: se suprimen las recuperaciones hasta que venza `open_until_ns`.
+ * HalfOpen: se permite un único intento de prueba.
+ */
+enum class BreakerState : uint8_t { Closed, Open, HalfOpen };
+
+/**
+ * Estado de recuperación de un hilo. Lo maneja solo el hilo ejecutor de
+ * recuperaciones, salvo los contadores atómicos que se leen para reportes.
+ */
+struct RecoveryState {
+    uint32_t attempts = 0;                // Recuperaciones seguidas sin que el hilo progrese
+    int64_t next_allowed_ns = 0;          // Antes de este instante se posterga la recuperación
+    uint64_t progress_mark = 0;           // Iteraciones completas al momento del último intento
+    int64_t open_until_ns = 0;            // Fin del período con el cortacircuitos abierto
+    atomic<BreakerState> breaker{BreakerState::Closed};
+    atomic<uint64_t> executed{0};         // Recuperaciones ejecutadas
+    atomic<uint64_t> suppressed{0};       // Pedidos descartados con el cortacircuitos abierto
+    LatencyHistogram duration;            // Duración de cada recuperación
+};
+
+/**
+ * Estadísticas del propio monitor: demora de cada despertar respecto del plazo
+ * armado y tiempo de trabajo por vuelta (debe ser corto: el monitor no bloquea).
+ */
+struct MonitorStats {
+    HistogramSnapshot wake_latency;       // Despertar real - plazo armado (ns)
+    HistogramSnapshot busy_time;          // Duración de cada vuelta del monitor (ns)
+};
+
+class ThreadSupervisor;
+
+/**
+ * Estado de un hilo administrado que comparten sus generaciones.
+ *
+ * Cada contexto lo tiene por shared_ptr: una generación abandonada que vuelve
+ * de un bloqueo lo encuentra vivo aunque el supervisor ya haya creado otra o
+ * se haya destruido. Para pedir recuperaciones usa `supervisor`, que el
+ * supervisor pone en nullptr (con `link_mutex`) al destruirse.
+ */
+struct WorkerShared {
+    atomic<bool> stopping{false};             // Apagado pedido con shutdown_all()
+
+    PiMutex link_mutex;
+    ThreadSupervisor* supervisor = nullptr;   // nullptr una vez destruido el supervisor
+
+    // Evento en curso, compartido entre generaciones
+    PiMutex inflight_mutex;
+    void* inflight = nullptr;
+    uint32_t inflight_generation = 0;
+};
+
+/**
+ * Clase WorkerContext
+ * Contexto de una generación de un hilo de trabajo creado por el supervisor.
+ *
+ * Permite cancelación cooperativa: el hilo consulta active() en su ciclo y
+ * duerme con sleep_for(), que se interrumpe al cancelar. Los latidos de una
+ * generación cancelada se ignoran, para que un hilo abandonado que vuelve de
+ * un bloqueo no pise los del reemplazo.
+ *
+ * El evento en curso se registra con hold(); si el hilo se reinicia, la nueva
+ * generación lo retoma con resume() y el hilo viejo ya no puede completarlo
+ * (complete() devuelve false), así el evento conserva su lugar en la cola.
+ *
+ * El contexto no guarda referencias al supervisor: todo lo que comparte con
+ * él está en WorkerShared. El slot de latido es del supervisor, que no se
+ * destruye mientras quede una generación abandonada viva (ver join_workers()).
+ */
+class WorkerContext {
+public:
+    WorkerContext(shared_ptr<WorkerShared> shared, int thread_id, uint32_t generation, Heartbeat heartbeat);
+
+    const int thread_id;
+    const uint32_t generation;
+
+    /** true mientras el sistema corre y esta generación no fue cancelada */
+    bool active() const {
+        return !shared->stopping.load(memory_order_relaxed) && !cancel_flag.load(memory_order_relaxed);
+    }
+
+    void iteration_start() { if (!cancel_flag.load(memory_order_relaxed)) heartbeat.start(); }
+    void iteration_end() { if (!cancel_flag.load(memory_order_relaxed)) heartbeat.end(); }
+
+    void recover();
+    bool sleep_for(chrono::nanoseconds duration);
+    bool wait_until(chrono::steady_clock::time_point deadline);
+    bool wait_next(PeriodicTimer& timer);
+    PeriodicStats* periodic_stats() const { return heartbeat.periodic_stats(); }
+    void cancel();
+    void interrupt();
+    void mark_exited() { exited_flag.store(true, memory_order_release); }
+    bool exited() const { return exited_flag.load(memory_order_acquire); }
+
+    template <typename T> void hold(T* item) { hold_raw(item); }
+    template <typename T> T* resume() { return static_cast<T*>(resume_raw()); }
+    template <typename T> bool complete(T* item) { return complete_raw(item); }
+
+private:
+    shared_ptr<WorkerShared> shared;
+    Heartbeat heartbeat;
+    atomic<bool> cancel_flag{false};
+    atomic<bool> exited_flag{false};
+    FutexSignal wake;
+
+    void hold_raw(void* item);
+    void* resume_raw();
+    bool complete_raw(void* item);
+};
+
+/**
+ * Ciclo de vida de un hilo de trabajo propiedad del supervisor.
+ */
+struct WorkerLifecycle {
+    function<void(WorkerContext&)> factory;   // Cuerpo del hilo (vacío = hilo no administrado)
+    uint32_t restart_after = 0;               // Plazos estáticos que puede durar una iteración (0 = nunca reiniciar)
+    bool exclusive = false;                   // Las generaciones comparten un dispositivo: nunca dos vivas
+    uint32_t generation = 0;
+    shared_ptr<WorkerShared> shared = make_shared<WorkerShared>();
+    shared_ptr<WorkerContext> ctx;            // Contexto de la generación actual
+    thread worker;
+    int64_t cancel_deadline_ns = 0;           // Fin de la gracia de la generación cancelada (0 = ninguna)
+    vector<shared_ptr<WorkerContext>> abandoned;  // Generaciones abandonadas que pueden seguir vivas
+    atomic<uint64_t> restarts{0};
+};
+
 class ThreadSupervisor {
 public:
+    /** Cantidad máxima de hilos supervisados */
+    static constexpr size_t MAX_THREADS = 16;
+
     // Constructor y destructor
     ThreadSupervisor();
     ~ThreadSupervisor();
 
     // Métodos públicos
-    void register_thread(int thread_id, 
-                        chrono::microseconds expected_time, 
-                        function<void()> recovery_func);
-    
+    Heartbeat register_thread(int thread_id,
+                              chrono::microseconds expected_time,
+                              function<void()> recovery_func);
+
+    Heartbeat register_worker(int thread_id,
+                              chrono::microseconds expected_time,
+                              function<void()> recovery_func,
+                              function<void(WorkerContext&)> factory,
+                              uint32_t restart_after = 3,
+                              bool exclusive = false);
+    void start_workers();
+    bool join_workers(chrono::milliseconds grace = chrono::milliseconds(2000));
+
+    bool enable_adaptive_budget(int thread_id, AdaptiveBudget config = {});
+
+    /** Hilos internos del supervisor, para fijarles prioridad y afinidad */
+    pthread_t monitor_handle() { return supervisor_thread.native_handle(); }
+    pthread_t recovery_handle() { return recovery_executor.native_handle(); }
+
+    Heartbeat heartbeat(int thread_id);
     void notify_start(int thread_id);
     void notify_end(int thread_id);
     void recovery_thread(int thread_id);
     void set_running_flag(atomic<bool>* flag);
     void shutdown_all();
 
+    // Estadísticas de tiempos de ejecución
+    bool timing_stats(int thread_id, ThreadTimingStats& out);
+    vector<ThreadTimingStats> timing_stats();
+    void print_timing_report();
+    MonitorStats monitor_stats() const;
+
     // Eliminar copias (opcional pero recomendado)
     ThreadSupervisor(const ThreadSupervisor&) = delete;
     ThreadSupervisor& operator=(const ThreadSupervisor&) = delete;
 
 private:
-    // Estructura interna con constructor por defecto
-    struct ThreadInfo {
-        chrono::microseconds expected_duration{0};
-        chrono::steady_clock::time_point last_start_time{};
-        atomic<bool> is_running{false};
-        function<void()> recovery_function{nullptr};
-        uint32_t timeout_count{0};
-
-        // Constructor por defecto
-        ThreadInfo() = default;
-        
-        // Constructor con parámetros
-        ThreadInfo(chrono::microseconds duration,
-                 chrono::steady_clock::time_point start,
-                 bool running,
-                 function<void()> func,
-                 uint32_t count = 0)
-            : expected_duration(duration),
-              last_start_time(start),
-              is_running(running),
-              recovery_function(move(func)),
-              timeout_count(count) {}
-    };
-
     // Métodos privados
     void monitor_threads();
+    void wake_monitor();
+    void recovery_worker();
+    void request_recovery(size_t index);
+    void request_restart(size_t index);
+    void spawn_worker(size_t index);
+    int64_t restart_worker(size_t index);
+    HeartbeatSlot* find_slot(int thread_id);
+    static int64_t static_budget_ns(const HeartbeatSlot& slot);
 
     // Miembros privados
-    unordered_map<int, ThreadInfo> threads_info;
-    mutex threads_mutex;
-    thread supervisor_thread;
+    array<HeartbeatSlot, MAX_THREADS> slots;
+    array<HeartbeatStats, MAX_THREADS> slot_stats;
+    PiMutex register_mutex;                 // Solo serializa registros, nunca los latidos
     atomic<bool>* running_flag = nullptr;
     atomic<bool> shutdown{false};
-    const chrono::milliseconds check_interval{50};
+    atomic<bool> supervising{true};       // false tras shutdown_all(): no se detectan más timeouts
+    DeadlineTimer timer;                  // Plazo más próximo, armado por los propios hilos
     const uint32_t max_retries{3};
+
+    // Ejecutor de recuperaciones: el monitor solo marca pedidos y nunca ejecuta una recuperación
+    array<RecoveryState, MAX_THREADS> recovery_states;
+    atomic<uint32_t> pending_recoveries{0};   // Bit i = recuperación pendiente para el slot i
+    atomic<uint32_t> pending_restarts{0};     // Bit i = reinicio pendiente para el slot i
+    FutexSignal recovery_signal;
+    const chrono::milliseconds backoff_base{100};
+    const chrono::milliseconds backoff_max{10000};
+    const uint32_t breaker_threshold{5};       // Intentos sin progreso antes de abrir el cortacircuitos
+    const chrono::milliseconds breaker_open_time{30000};
+
+    // Hilos de trabajo administrados (creados y reiniciados por el supervisor)
+    array<WorkerLifecycle, MAX_THREADS> lifecycles;
+    PiMutex lifecycle_mutex;                   // Protege el cambio de generación de cada hilo
+    const chrono::milliseconds restart_grace{200};
+    const chrono::milliseconds restart_poll{5};  // Cada cuánto se revisa si la generación cancelada salió
+
+    LatencyHistogram monitor_wake_latency;
+    LatencyHistogram monitor_busy_time;
+
+    thread supervisor_thread;             // Se crean al final, con los descriptores ya abiertos
+    thread recovery_executor;             // Hilo que ejecuta las recuperaciones
 };
 
-#endif // SUPERVISOR_H
\ No newline at end of file
+#endif // SUPERVISOR_H
@@ -0,0 +1,286 @@
+#include "tracer.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+#include <unistd.h>
+#include "logger.h"
+#include "rt_profile.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+/** Convierte ns de steady_clock a los microsegundos con decimales del formato de Chrome */
+double to_us(int64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+/**
+ * Escribe una cadena como literal JSON (los nombres de tramo y de hilo son
+ * literales del programa, pero se escapan igual por las dudas).
+ */
+void write_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+} // namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() {
+    active.store(env_long("STR_TRACE", 1) != 0, memory_order_relaxed);
+    if (const char* dir = getenv("STR_TRACE_DIR"); dir && *dir) dump_dir = dir;
+    slow_vehicle_ns = env_long("STR_TRACE_SLOW_MS", slow_vehicle_ns / 1000000) * 1000000;
+    keep_dumps = static_cast<size_t>(max(env_long("STR_TRACE_KEEP", static_cast<long>(keep_dumps)), 1L));
+}
+
+Tracer::~Tracer() {
+    stop();
+}
+
+/**
+ * Inicia el hilo que escribe los volcados. Como el escritor de logs, conviene
+ * crearlo antes que los hilos de tiempo real.
+ */
+void Tracer::start() {
+    if (!enabled() || running.exchange(true)) return;
+    dumper = thread(&Tracer::dumper_loop, this);
+}
+
+/**
+ * Detiene el hilo de volcados; un pedido pendiente se escribe antes de salir.
+ */
+void Tracer::stop() {
+    if (!running.exchange(false)) return;
+    wake.notify();
+    if (dumper.joinable()) dumper.join();
+}
+
+void Tracer::set_thread_name(const char* name) {
+    if (Buffer* buffer = current_buffer()) {
+        snprintf(buffer->name, NAME_SIZE, "%s", name);
+    }
+}
+
+Tracer::Registration::~Registration() {
+    if (buffer) buffer->alive.store(false, memory_order_release);
+}
+
+/**
+ * Devuelve (asignándolo la primera vez) el buffer del hilo que llama. Si no
+ * quedan libres se reutiliza el de un hilo terminado: su historia se pierde,
+ * pero la de un hilo colgado (que sigue vivo) se conserva para el volcado.
+ * @return nullptr si todos los buffers son de hilos vivos.
+ */
+Tracer::Buffer* Tracer::current_buffer() {
+    thread_local Registration registration;
+    if (registration.buffer || registration.attempted) return registration.buffer;
+
+    registration.attempted = true;
+    // El dueño de un buffer se decide con `alive`: primero uno nunca usado y, si no hay, uno de un hilo terminado
+    for (int pass = 0; pass < 2; pass++) {
+        for (auto& b : buffers) {
+            if (pass == 0 && b.claimed.load(memory_order_acquire)) continue;
+            bool expected = false;
+            if (!b.alive.compare_exchange_strong(expected, true, memory_order_acq_rel)) continue;
+            // Saltar una vuelta entera invalida los eventos del dueño anterior
+            b.head.store(b.head.load(memory_order_relaxed) + RING_SIZE, memory_order_release);
+            b.tid.store(static_cast<int>(gettid()), memory_order_relaxed);
+            snprintf(b.name, NAME_SIZE, "hilo-%d", static_cast<int>(gettid()));
+            b.claimed.store(true, memory_order_release);
+            registration.buffer = &b;
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+void Tracer::vehicle_done(const VehicleEvent& vehicle) {
+    if (!enabled()) return;
+
+    // Un tramo asincrónico por etapa, con el nombre de la etapa a la que se llega
+    int prev = -1;
+    int first = -1;
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        if (vehicle.stamps[i] == 0) continue;
+        if (first < 0) first = static_cast<int>(i);
+        if (prev >= 0) {
+            record('b', STAGE_NAMES[i], vehicle.stamps[prev], 0, vehicle.id);
+            record('e', STAGE_NAMES[i], vehicle.stamps[i], 0, vehicle.id);
+        }
+        prev = static_cast<int>(i);
+    }
+
+    if (slow_vehicle_ns > 0 && first >= 0 && vehicle.stamps[prev] - vehicle.stamps[first] > slow_vehicle_ns) {
+        request_dump("vehiculo-lento");
+    }
+}
+
+bool Tracer::request_dump(const char* reason, bool manual) {
+    if (!enabled()) return false;
+    if (!manual) {
+        int64_t now = now_ns();
+        int64_t last = last_auto_request_ns.load(memory_order_relaxed);
+        if (last != 0 && now - last < duration_cast<nanoseconds>(min_dump_interval).count()) return false;
+        if (!last_auto_request_ns.compare_exchange_strong(last, now, memory_order_relaxed)) return false;
+    }
+    const char* expected = nullptr;
+    if (!pending_reason.compare_exchange_strong(expected, reason, memory_order_acq_rel)) return false;
+    wake.notify();
+    return true;
+}
+
+/**
+ * Hilo de volcados: en SCHED_OTHER, espera pedidos y, tras `post_trigger`,
+ * escribe la traza.
+ */
+void Tracer::dumper_loop() {
+    set_background_policy();
+    set_thread_name("traza");
+    Logger::instance().set_thread_name("traza");
+
+    while (running.load(memory_order_acquire)) {
+        uint32_t seq = wake.prepare();
+        const char* reason = pending_reason.load(memory_order_acquire);
+        if (!reason) {
+            wake.wait(seq);
+            continue;
+        }
+
+        // Deja pasar un poco de tiempo para que la traza muestre también la reacción
+        auto deadline = steady_clock::now() + post_trigger;
+        while (running.load(memory_order_acquire) && steady_clock::now() < deadline) {
+            uint32_t s = wake.prepare();
+            wake.wait_until(s, deadline);
+        }
+        write_requested(reason);
+    }
+
+    if (const char* reason = pending_reason.load(memory_order_acquire)) write_requested(reason);
+}
+
+void Tracer::write_requested(const char* reason) {
+    time_t now = time(nullptr);
+    tm local{};
+    localtime_r(&now, &local);
+    char name[96];
+    snprintf(name, sizeof(name), "trace_%04d%02d%02d_%02d%02d%02d_%s.json", local.tm_year + 1900,
+             local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec, reason);
+
+    error_code ec;
+    filesystem::create_directories(dump_dir, ec);
+    string path = dump_dir + "/" + name;
+    if (dump(path)) {
+        LOG_INFO("[TRAZA] Traza guardada en %s (%s)", path.c_str(), reason);
+        prune_dumps();
+    } else {
+        LOG_ERROR("[TRAZA] No se pudo escribir %s", path.c_str());
+    }
+    pending_reason.store(nullptr, memory_order_release);
+}
+
+/**
+ * Borra los volcados más viejos, conservando los últimos `keep_dumps`.
+ */
+void Tracer::prune_dumps() {
+    error_code ec;
+    vector<filesystem::path> files;
+    for (const auto& entry : filesystem::directory_iterator(dump_dir, ec)) {
+        string file = entry.path().filename().string();
+        if (file.rfind("trace_", 0) == 0 && entry.path().extension() == ".json") files.push_back(entry.path());
+    }
+    if (files.size() <= keep_dumps) return;
+    // El nombre empieza con la fecha: el orden alfabético es el cronológico
+    sort(files.begin(), files.end());
+    for (size_t i = 0; i + keep_dumps < files.size(); i++) filesystem::remove(files[i], ec);
+}
+
+/**
+ * Copia los eventos de todos los buffers (descartando los que se pisaron
+ * durante la copia), los ordena por timestamp y los escribe en formato JSON
+ * de Chrome trace.
+ */
+bool Tracer::dump(const string& path) {
+    vector<Event> events;
+    events.reserve(MAX_THREADS * RING_SIZE / 4);
+
+    for (auto& b : buffers) {
+        if (!b.claimed.load(memory_order_acquire)) continue;
+        int tid = b.tid.load(memory_order_relaxed);
+        uint64_t head = b.head.load(memory_order_acquire);
+        for (uint64_t pos = head > RING_SIZE ? head - RING_SIZE : 0; pos < head; pos++) {
+            const Slot& slot = b.slots[pos & (RING_SIZE - 1)];
+            uint64_t seq = slot.seq.load(memory_order_acquire);
+            if (seq != 2 * pos + 2) continue;
+            Event ev{slot.ts_ns.load(memory_order_relaxed), slot.dur_ns.load(memory_order_relaxed),
+                     slot.name.load(memory_order_relaxed), slot.id.load(memory_order_relaxed),
+                     slot.phase.load(memory_order_relaxed), tid};
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.seq.load(memory_order_relaxed) != seq || !ev.name) continue;
+            events.push_back(ev);
+        }
+    }
+    stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.ts_ns < b.ts_ns; });
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    int pid = static_cast<int>(getpid());
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"str_project\"}}", pid);
+    for (auto& b : buffers) {
+        if (!b.claimed.load(memory_order_acquire)) continue;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                pid, b.tid.load(memory_order_relaxed));
+        write_json_string(f, b.name);
+        fprintf(f, "}}");
+    }
+
+    for (const Event& ev : events) {
+        fprintf(f, ",\n{\"name\":");
+        write_json_string(f, ev.name);
+        switch (ev.phase) {
+            case 'X':
+                fprintf(f, ",\"cat\":\"str\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", to_us(ev.ts_ns), to_us(ev.dur_ns));
+                break;
+            case 'b':
+            case 'e':
+                // Recorrido del vehículo: una pista asincrónica por id
+                fprintf(f, ",\"cat\":\"vehiculo\",\"ph\":\"%c\",\"id\":%" PRIu64 ",\"ts\":%.3f",
+                        ev.phase, ev.id, to_us(ev.ts_ns));
+                break;
+            default:
+                fprintf(f, ",\"cat\":\"str\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", to_us(ev.ts_ns));
+                break;
+        }
+        fprintf(f, ",\"pid\":%d,\"tid\":%d", pid, ev.tid);
+        if (ev.id != 0) fprintf(f, ",\"args\":{\"id\":%" PRIu64 "}", ev.id);
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    if (ok) dumps_written.fetch_add(1, memory_order_relaxed);
+    return ok;
+}
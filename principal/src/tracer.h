@@ -0,0 +1,223 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "futex_signal.h"
+#include "vehicle_event.h"
+
+using namespace std;
+
+/**
+ * Clase Tracer
+ * Registro continuo de lo que hizo cada hilo, para reconstruir a posteriori
+ * un evento lento ("la barrera tardó muchísimo"). Cada hilo escribe en su
+ * propio buffer circular de tamaño fijo, sin locks ni llamadas al sistema:
+ * cuando se llena se pisan los eventos más viejos, por lo que la memoria
+ * queda acotada (MAX_THREADS * RING_SIZE eventos) y puede dejarse activo en
+ * producción.
+ *
+ * Tipos de evento:
+ * - Tramos con duración (TRACE_SCOPE): medición, captura, codificación, envío,
+ *   actuación, recuperación...
+ * - Instantes (TRACE_INSTANT): disparo, decisión, plazo incumplido.
+ * - Recorrido de cada vehículo por las etapas, a partir de sus timestamps.
+ *
+ * Los buffers se vuelcan como JSON de Chrome trace (chrome://tracing o
+ * https://ui.perfetto.dev) bajo pedido (SIGUSR2) o ante una anomalía (hilo
+ * colgado, vehículo lento). El volcado lo hace un hilo SCHED_OTHER, un rato
+ * después del pedido para incluir también lo que pasó a continuación.
+ *
+ * Se configura por variables de entorno (todas opcionales):
+ * - STR_TRACE=0                 Desactiva el registro
+ * - STR_TRACE_DIR=/ruta         Directorio de los volcados
+ * - STR_TRACE_SLOW_MS=4000      Latencia total de un vehículo que dispara un volcado (0 = nunca)
+ * - STR_TRACE_KEEP=20           Volcados que se conservan (los más viejos se borran)
+ */
+class Tracer {
+public:
+    static constexpr size_t MAX_THREADS = 16;
+    static constexpr size_t RING_SIZE = 2048;        // Potencia de 2
+    static constexpr size_t NAME_SIZE = 16;
+
+    static Tracer& instance();
+
+    void start();
+    void stop();
+
+    bool enabled() const { return active.load(memory_order_relaxed); }
+
+    /**
+     * Nombre del hilo que llama, mostrado en la traza (hasta 15 caracteres).
+     */
+    void set_thread_name(const char* name);
+
+    /**
+     * Registra un tramo ya terminado.
+     * @param name Nombre del tramo (debe ser un literal)
+     * @param start_ns Inicio (steady_clock, ns)
+     * @param dur_ns Duración (ns)
+     * @param id Vehículo o hilo al que se refiere (0 = ninguno)
+     */
+    void complete(const char* name, int64_t start_ns, int64_t dur_ns, uint64_t id = 0) {
+        record('X', name, start_ns, dur_ns, id);
+    }
+
+    /**
+     * Registra un instante.
+     */
+    void instant(const char* name, uint64_t id = 0) {
+        record('i', name, now_ns(), 0, id);
+    }
+
+    /**
+     * Registra el recorrido de un vehículo por las etapas alcanzadas y pide
+     * un volcado si su latencia total superó STR_TRACE_SLOW_MS.
+     */
+    void vehicle_done(const VehicleEvent& vehicle);
+
+    /**
+     * Pide un volcado sin bloquear. Los pedidos automáticos se limitan a uno
+     * cada `min_dump_interval`; los manuales siempre se atienden.
+     * @param reason Motivo (literal), forma parte del nombre del archivo
+     * @return false si el pedido se descartó
+     */
+    bool request_dump(const char* reason, bool manual = false);
+
+    /**
+     * Vuelca los buffers en el momento, en el hilo que llama.
+     * @return false si no pudo escribirse el archivo
+     */
+    bool dump(const string& path);
+
+    uint64_t dumps() const { return dumps_written.load(memory_order_relaxed); }
+
+    static int64_t now_ns() {
+        return chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+private:
+    /**
+     * Evento de un buffer circular, protegido por un número de secuencia al
+     * estilo seqlock: impar mientras se escribe, 2 * (posición + 1) al terminar.
+     * El lector descarta los eventos que cambiaron mientras los copiaba.
+     */
+    struct Slot {
+        atomic<uint64_t> seq{0};
+        atomic<int64_t> ts_ns{0};
+        atomic<int64_t> dur_ns{0};
+        atomic<const char*> name{nullptr};
+        atomic<uint64_t> id{0};
+        atomic<char> phase{0};
+    };
+
+    struct Buffer {
+        array<Slot, RING_SIZE> slots;
+        atomic<uint64_t> head{0};           // Eventos escritos desde siempre
+        atomic<bool> claimed{false};        // Buffer asignado a un hilo
+        atomic<bool> alive{false};          // El hilo dueño sigue vivo
+        atomic<int> tid{0};
+        char name[NAME_SIZE] = {};
+    };
+
+    /** Copia de un evento tomada por el volcado */
+    struct Event {
+        int64_t ts_ns;
+        int64_t dur_ns;
+        const char* name;
+        uint64_t id;
+        char phase;
+        int tid;
+    };
+
+    /** Buffer del hilo actual; queda disponible para otro hilo cuando este termina */
+    struct Registration {
+        Buffer* buffer = nullptr;
+        bool attempted = false;
+        ~Registration();
+    };
+
+    array<Buffer, MAX_THREADS> buffers;
+    atomic<bool> active{true};
+    atomic<bool> running{false};
+    atomic<const char*> pending_reason{nullptr};
+    atomic<int64_t> last_auto_request_ns{0};
+    atomic<uint64_t> dumps_written{0};
+    FutexSignal wake;
+    thread dumper;
+
+    string dump_dir = "/home/raspy/str-project/traces";
+    int64_t slow_vehicle_ns = 4000000000;
+    size_t keep_dumps = 20;
+    chrono::milliseconds post_trigger{500};          // Se sigue registrando este tiempo antes de volcar
+    chrono::seconds min_dump_interval{30};
+
+    Tracer();
+    ~Tracer();
+
+    Buffer* current_buffer();
+    void dumper_loop();
+    void write_requested(const char* reason);
+    void prune_dumps();
+
+    void record(char phase, const char* name, int64_t ts_ns, int64_t dur_ns, uint64_t id) {
+        if (!enabled()) return;
+        Buffer* buffer = current_buffer();
+        if (!buffer) return;
+
+        uint64_t pos = buffer->head.load(memory_order_relaxed);
+        Slot& slot = buffer->slots[pos & (RING_SIZE - 1)];
+        slot.seq.store(2 * pos + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.ts_ns.store(ts_ns, memory_order_relaxed);
+        slot.dur_ns.store(dur_ns, memory_order_relaxed);
+        slot.name.store(name, memory_order_relaxed);
+        slot.id.store(id, memory_order_relaxed);
+        slot.phase.store(phase, memory_order_relaxed);
+        slot.seq.store(2 * pos + 2, memory_order_release);
+        buffer->head.store(pos + 1, memory_order_release);
+    }
+};
+
+/**
+ * Tramo con duración que se registra al salir del bloque (o al llamar a end()).
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, uint64_t id = 0)
+        : name(name), id(id), start_ns(Tracer::instance().enabled() ? Tracer::now_ns() : 0) {}
+
+    ~TraceScope() { end(); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /** Cambia el vehículo o hilo asociado (por ejemplo, si se conoce después de empezar) */
+    void set_id(uint64_t value) { id = value; }
+
+    void end() {
+        if (start_ns == 0) return;
+        Tracer::instance().complete(name, start_ns, Tracer::now_ns() - start_ns, id);
+        start_ns = 0;
+    }
+
+private:
+    const char* name;
+    uint64_t id;
+    int64_t start_ns;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/** Tramo que dura hasta el fin del bloque actual */
+#define TRACE_SCOPE(name, ...) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name __VA_OPT__(,) __VA_ARGS__)
+
+/** Instante */
+#define TRACE_INSTANT(name, ...) Tracer::instance().instant(name __VA_OPT__(,) __VA_ARGS__)
+
+#endif // TRACER_H
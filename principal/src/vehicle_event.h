@@ -0,0 +1,229 @@
+#ifndef VEHICLE_EVENT_H
+#define VEHICLE_EVENT_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+/**
+ * Etapas del pipeline que se marcan con un timestamp monotónico en cada vehículo.
+ */
+enum class Stage : uint8_t {
+    Detect,       // El sensor midió una distancia por debajo del umbral
+    Trigger,      // Se pidió la foto a la cámara
+    Frame,        // Se obtuvo un frame válido
+    Encode,       // La imagen quedó codificada y guardada
+    UploadStart,  // Comienza el envío al backend
+    UploadEnd,    // Terminó el envío al backend
+    Decision,     // Se conoce la decisión de acceso
+    Actuation,    // La barrera actuó según la decisión
+    Count
+};
+
+inline constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+
+/** Nombres cortos de cada etapa, en el mismo orden que Stage */
+inline constexpr const char* STAGE_NAMES[STAGE_COUNT] = {
+    "detect", "trigger", "frame", "encode", "upload_start", "upload_end", "decision", "actuation"
+};
+
+/**
+ * Resultado de la consulta al backend para un vehículo.
+ */
+enum class AccessDecision : uint8_t {
+    Pending,   // Todavía sin respuesta
+    Granted,   // Acceso autorizado
+    Denied,    // Acceso denegado
+    Error      // No se pudo consultar (se trata como denegado)
+};
+
+class VehiclePool;
+
+/**
+ * Registro de un vehículo que recorre todo el pipeline.
+ * Se toma de un VehiclePool preasignado al detectar el vehículo y se devuelve
+ * al pool cuando la barrera actúa (o cuando el evento se descarta).
+ */
+struct VehicleEvent {
+    static constexpr size_t PATH_SIZE = 128;
+
+    uint64_t id = 0;                                 // Id único del vehículo
+    int lane = 0;                                    // Carril de detección
+    double distance_cm = 0;                          // Distancia medida al detectar
+    array<int64_t, STAGE_COUNT> stamps{};            // Timestamps steady_clock en ns (0 = no alcanzada)
+    chrono::steady_clock::time_point deadline;       // Pasado este instante la foto está vencida
+    bool stale = false;                              // true si se entrega desde el carril de auditoría
+    AccessDecision decision = AccessDecision::Pending;
+    char photo_path[PATH_SIZE] = {};                 // Ruta de la imagen capturada
+    VehiclePool* owner = nullptr;                    // Pool al que pertenece el registro
+
+    /**
+     * Marca el instante actual para la etapa indicada.
+     */
+    void stamp(Stage s) {
+        stamps[static_cast<size_t>(s)] = chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    /**
+     * Marca un instante ya medido para la etapa indicada.
+     */
+    void stamp(Stage s, chrono::steady_clock::time_point t) {
+        stamps[static_cast<size_t>(s)] = t.time_since_epoch().count();
+    }
+
+    bool reached(Stage s) const {
+        return stamps[static_cast<size_t>(s)] != 0;
+    }
+
+    chrono::steady_clock::time_point at(Stage s) const {
+        return chrono::steady_clock::time_point(chrono::steady_clock::duration(stamps[static_cast<size_t>(s)]));
+    }
+
+    /** Instante del disparo: referencia para plazos y edades */
+    chrono::steady_clock::time_point trigger_time() const {
+        return at(Stage::Trigger);
+    }
+
+    void set_path(const string& path) {
+        snprintf(photo_path, PATH_SIZE, "%s", path.c_str());
+    }
+
+    bool lift() const {
+        return decision == AccessDecision::Granted;
+    }
+
+    /**
+     * Deja el registro listo para reutilizarse (conserva el dueño).
+     */
+    void reset() {
+        id = 0;
+        lane = 0;
+        distance_cm = 0;
+        stamps.fill(0);
+        deadline = {};
+        stale = false;
+        decision = AccessDecision::Pending;
+        photo_path[0] = '\0';
+    }
+
+    /**
+     * Devuelve el desglose de latencias entre etapas consecutivas alcanzadas, en ms.
+     * Ejemplo: "detect→trigger 0.1 ms, trigger→frame 140.2 ms, ..., total 812.4 ms"
+     */
+    string latency_breakdown() const {
+        string out;
+        char buf[64];
+        int prev = -1;
+        for (size_t i = 0; i < STAGE_COUNT; i++) {
+            if (stamps[i] == 0) continue;
+            if (prev >= 0) {
+                snprintf(buf, sizeof(buf), "%s%s→%s %.1f ms", out.empty() ? "" : ", ",
+                         STAGE_NAMES[prev], STAGE_NAMES[i], (stamps[i] - stamps[prev]) / 1e6);
+                out += buf;
+            }
+            prev = static_cast<int>(i);
+        }
+        int first = -1;
+        for (size_t i = 0; i < STAGE_COUNT && first < 0; i++) {
+            if (stamps[i] != 0) first = static_cast<int>(i);
+        }
+        if (first >= 0 && prev > first) {
+            snprintf(buf, sizeof(buf), ", total %.1f ms", (stamps[prev] - stamps[first]) / 1e6);
+            out += buf;
+        }
+        return out;
+    }
+};
+
+/**
+ * Clase VehiclePool
+ * Pool de registros VehicleEvent preasignados al inicio. Tomar y devolver
+ * registros no reserva memoria ni toma locks: la lista libre es una pila
+ * sin locks con índice y etiqueta de versión para evitar el problema ABA.
+ */
+class VehiclePool {
+public:
+    static constexpr uint32_t CAPACITY = 32;
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    array<VehicleEvent, CAPACITY> records;
+    array<atomic<uint32_t>, CAPACITY> next;
+    atomic<uint64_t> free_head;                  // (etiqueta << 32) | índice
+    atomic<uint32_t> in_use{0};
+    atomic<uint64_t> exhausted{0};               // Veces que se pidió un registro sin haber libres
+
+    static uint64_t pack(uint32_t tag, uint32_t idx) { return (static_cast<uint64_t>(tag) << 32) | idx; }
+    static uint32_t index_of(uint64_t head) { return static_cast<uint32_t>(head & 0xffffffffu); }
+    static uint32_t tag_of(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+public:
+    VehiclePool() {
+        for (uint32_t i = 0; i < CAPACITY; i++) {
+            records[i].owner = this;
+            next[i].store(i + 1 < CAPACITY ? i + 1 : NIL, memory_order_relaxed);
+        }
+        free_head.store(pack(0, 0), memory_order_relaxed);
+    }
+
+    VehiclePool(const VehiclePool&) = delete;
+    VehiclePool& operator=(const VehiclePool&) = delete;
+
+    /**
+     * Toma un registro libre, ya reiniciado.
+     * @return nullptr si el pool está agotado
+     */
+    VehicleEvent* acquire() {
+        uint64_t head = free_head.load(memory_order_acquire);
+        for (;;) {
+            uint32_t idx = index_of(head);
+            if (idx == NIL) {
+                exhausted.fetch_add(1, memory_order_relaxed);
+                return nullptr;
+            }
+            uint64_t new_head = pack(tag_of(head) + 1, next[idx].load(memory_order_relaxed));
+            if (free_head.compare_exchange_weak(head, new_head, memory_order_acq_rel, memory_order_acquire)) {
+                in_use.fetch_add(1, memory_order_relaxed);
+                VehicleEvent* ev = &records[idx];
+                ev->reset();
+                return ev;
+            }
+        }
+    }
+
+    /**
+     * Devuelve un registro al pool. Puede llamarse desde cualquier hilo.
+     */
+    void release(VehicleEvent* ev) {
+        if (!ev) return;
+        uint32_t idx = static_cast<uint32_t>(ev - records.data());
+        uint64_t head = free_head.load(memory_order_relaxed);
+        for (;;) {
+            next[idx].store(index_of(head), memory_order_relaxed);
+            uint64_t new_head = pack(tag_of(head) + 1, idx);
+            if (free_head.compare_exchange_weak(head, new_head, memory_order_release, memory_order_relaxed)) {
+                in_use.fetch_sub(1, memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    uint32_t used() const { return in_use.load(memory_order_relaxed); }
+    uint64_t exhausted_count() const { return exhausted.load(memory_order_relaxed); }
+};
+
+/**
+ * Devuelve un registro a su pool de origen.
+ */
+inline void release_vehicle(VehicleEvent* ev) {
+    if (ev && ev->owner) ev->owner->release(ev);
+}
+
+#endif // VEHICLE_EVENT_H
@@ -0,0 +1,143 @@
+#include "worker_pool.h"
+#include <exception>
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+/** Pool e índice del hilo actual, si es un hilo de algún WorkerPool */
+thread_local const WorkerPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // namespace
+
+WorkerPool::WorkerPool(size_t threads, function<void(size_t index)> setup, size_t capacity)
+    : capacity(capacity) {
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) workers.push_back(make_unique<Worker>());
+    // Los hilos arrancan con todas las colas ya creadas: pueden robar de cualquiera
+    for (size_t i = 0; i < threads; i++) {
+        workers[i]->handle = thread(&WorkerPool::run, this, i, setup);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::submit(Task task, TaskClass cls) {
+    Metrics& m = metrics[static_cast<size_t>(cls)];
+    if (stopping.load(memory_order_relaxed) || workers.empty()) {
+        m.rejected.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    if (reserved.fetch_add(1, memory_order_relaxed) >= capacity) {
+        reserved.fetch_sub(1, memory_order_relaxed);
+        m.rejected.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    m.submitted.fetch_add(1, memory_order_relaxed);
+
+    size_t index = current_pool == this ? current_index
+                                        : next_worker.fetch_add(1, memory_order_relaxed) % workers.size();
+    {
+        Worker& w = *workers[index];
+        lock_guard<PiMutex> lock(w.mtx);
+        w.queues[static_cast<size_t>(cls)].push_back({move(task), clock::now()});
+        ready.fetch_add(1, memory_order_relaxed);
+    }
+    // Pasar por idle_mtx: un hilo que está por dormirse no pierde el aviso
+    { lock_guard<PiMutex> lock(idle_mtx); }
+    idle_cv.notify_one();
+    return true;
+}
+
+size_t WorkerPool::stop() {
+    {
+        lock_guard<PiMutex> lock(idle_mtx);
+        stopping.store(true, memory_order_relaxed);
+    }
+    idle_cv.notify_all();
+    for (auto& w : workers) {
+        if (w->handle.joinable()) w->handle.join();
+    }
+
+    size_t dropped = 0;
+    for (auto& w : workers) {
+        lock_guard<PiMutex> lock(w->mtx);
+        for (auto& queue : w->queues) {
+            dropped += queue.size();
+            queue.clear();
+        }
+    }
+    reserved.store(0, memory_order_relaxed);
+    ready.store(0, memory_order_relaxed);
+    return dropped;
+}
+
+WorkerPool::ClassStats WorkerPool::stats(TaskClass cls) const {
+    const Metrics& m = metrics[static_cast<size_t>(cls)];
+    ClassStats s;
+    s.submitted = m.submitted.load(memory_order_relaxed);
+    s.rejected = m.rejected.load(memory_order_relaxed);
+    s.wait = m.wait.snapshot();
+    s.run = m.run.snapshot();
+    return s;
+}
+
+/**
+ * Busca la próxima tarea: por clase, primero la cola propia (desde el final)
+ * y después las de los demás hilos (desde el principio).
+ */
+bool WorkerPool::take(size_t index, Entry& out, TaskClass& cls) {
+    size_t n = workers.size();
+    for (size_t c = 0; c < TASK_CLASS_COUNT; c++) {
+        for (size_t k = 0; k < n; k++) {
+            Worker& w = *workers[(index + k) % n];
+            lock_guard<PiMutex> lock(w.mtx);
+            auto& queue = w.queues[c];
+            if (queue.empty()) continue;
+            if (k == 0) {
+                out = move(queue.back());
+                queue.pop_back();
+            } else {
+                out = move(queue.front());
+                queue.pop_front();
+                stolen_count.fetch_add(1, memory_order_relaxed);
+            }
+            cls = static_cast<TaskClass>(c);
+            ready.fetch_sub(1, memory_order_relaxed);
+            reserved.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run(size_t index, const function<void(size_t)>& setup) {
+    current_pool = this;
+    current_index = index;
+    if (setup) setup(index);
+    while (!stopping.load(memory_order_relaxed)) {
+        Entry entry;
+        TaskClass cls;
+        if (!take(index, entry, cls)) {
+            unique_lock<PiMutex> lock(idle_mtx);
+            idle_cv.wait(lock, [this] {
+                return stopping.load(memory_order_relaxed) || ready.load(memory_order_relaxed) > 0;
+            });
+            continue;
+        }
+
+        Metrics& m = metrics[static_cast<size_t>(cls)];
+        auto start = clock::now();
+        m.wait.record(chrono::duration_cast<chrono::nanoseconds>(start - entry.queued_at).count());
+        try {
+            entry.task();
+        } catch (const exception& e) {
+            LOG_ERROR("[POOL] Excepción en tarea %s: %s", TASK_CLASS_NAMES[static_cast<size_t>(cls)], e.what());
+        }
+        m.run.record(chrono::duration_cast<chrono::nanoseconds>(clock::now() - start).count());
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "latency_histogram.h"
+#include "rt_mutex.h"
+
+using namespace std;
+
+/**
+ * Clase de una tarea del pool: define su prioridad y sus métricas.
+ */
+enum class TaskClass : uint8_t {
+    Live,          // Trabajo de un vehículo presente (captura, codificación, análisis)
+    Background,    // Trabajo diferible (archivo, limpieza)
+    Count
+};
+
+inline constexpr size_t TASK_CLASS_COUNT = static_cast<size_t>(TaskClass::Count);
+
+inline constexpr const char* TASK_CLASS_NAMES[TASK_CLASS_COUNT] = {"live", "background"};
+
+/**
+ * Clase WorkerPool
+ * Pool acotado de hilos con robo de trabajo para el trabajo bloqueante o de
+ * CPU (captura y codificación de fotos, análisis de imagen). Cada hilo tiene
+ * su propia cola por clase: toma sus tareas del final (las más recientes,
+ * con la caché caliente) y, si no tiene, roba del principio de la cola de
+ * otro hilo. Las tareas enviadas desde fuera del pool se reparten en ronda.
+ *
+ * Las tareas Live van siempre antes que las Background: un hilo libre busca
+ * trabajo Live en todas las colas antes de tomar trabajo Background. No hay
+ * desalojo: una tarea Background ya empezada termina.
+ *
+ * El pool está acotado: con `capacity` tareas en espera, submit() rechaza.
+ * Por cada clase se mide la espera en cola y la duración de cada tarea.
+ */
+class WorkerPool {
+public:
+    using Task = function<void()>;
+    using clock = chrono::steady_clock;
+
+    /** Métricas de una clase de tareas */
+    struct ClassStats {
+        uint64_t submitted = 0;
+        uint64_t rejected = 0;
+        HistogramSnapshot wait;        // Encolada -> empieza (ns)
+        HistogramSnapshot run;         // Duración de la tarea (ns)
+    };
+
+    /**
+     * Crea los hilos.
+     * @param capacity Máximo de tareas en espera (todas las clases)
+     * @param setup Corre al iniciar cada hilo con su índice (nombre, afinidad)
+     */
+    explicit WorkerPool(size_t threads, function<void(size_t index)> setup = {}, size_t capacity = 64);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Encola una tarea. Desde un hilo del pool va a su propia cola.
+     * @return false si el pool está lleno o detenido (la tarea se descarta)
+     */
+    bool submit(Task task, TaskClass cls = TaskClass::Live);
+
+    /**
+     * Espera a que terminen las tareas en curso y detiene los hilos. Las que
+     * no empezaron se descartan.
+     * @return Cantidad de tareas descartadas
+     */
+    size_t stop();
+
+    /** Tareas en espera (sin contar las que están corriendo) */
+    size_t pending() const { return reserved.load(memory_order_relaxed); }
+
+    size_t size() const { return workers.size(); }
+
+    ClassStats stats(TaskClass cls) const;
+
+    /** Tareas que un hilo tomó de la cola de otro */
+    uint64_t stolen() const { return stolen_count.load(memory_order_relaxed); }
+
+private:
+    struct Entry {
+        Task task;
+        clock::time_point queued_at;
+    };
+
+    struct Worker {
+        PiMutex mtx;
+        array<deque<Entry>, TASK_CLASS_COUNT> queues;
+        thread handle;
+    };
+
+    struct Metrics {
+        atomic<uint64_t> submitted{0};
+        atomic<uint64_t> rejected{0};
+        LatencyHistogram wait;
+        LatencyHistogram run;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    size_t capacity;
+    atomic<size_t> reserved{0};            // Lugares ocupados (cuenta para el límite)
+    atomic<size_t> ready{0};               // Tareas visibles en alguna cola
+    atomic<size_t> next_worker{0};         // Reparto en ronda de las tareas externas
+    atomic<bool> stopping{false};
+    atomic<uint64_t> stolen_count{0};
+    array<Metrics, TASK_CLASS_COUNT> metrics;
+
+    PiMutex idle_mtx;
+    PiCondition idle_cv;
+
+    void run(size_t index, const function<void(size_t)>& setup);
+    bool take(size_t index, Entry& out, TaskClass& cls);
+};
+
+#endif // WORKER_POOL_H
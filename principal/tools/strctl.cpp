@@ -0,0 +1,163 @@
+/**
+ * @file strctl.cpp
+ * @brief Inspección del estado en vivo de str_project a través del segmento de
+ * memoria compartida que publica el proceso (ver shm_stats.h).
+ *
+ * Uso:
+ *   strctl [show]                  Imprime el estado una vez
+ *   strctl watch [--interval-ms=N] Lo reimprime cada N ms (500 por defecto) hasta Ctrl+C
+ *   strctl check [--max-age-ms=N]  Chequeo de vida para un watchdog: termina con 0 si el
+ *                                  proceso publicó hace menos de N ms (2000 por defecto),
+ *                                  1 si está colgado o detenido y 2 si no hay segmento
+ * Opciones comunes: --name=/segmento (por defecto STR_SHM_NAME o /str_project)
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "shm_stats.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace {
+
+volatile sig_atomic_t interrupted = 0;
+
+const char* STATE_NAMES[] = {"iniciando", "corriendo", "deteniéndose"};
+
+int64_t now_ns() {
+    return steady_clock::now().time_since_epoch().count();
+}
+
+double ms(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+/** Antigüedad de un instante en ms, o -1 si nunca ocurrió */
+double age_ms(int64_t at_ns, int64_t now) {
+    return at_ns == 0 ? -1 : static_cast<double>(now - at_ns) / 1e6;
+}
+
+void print_latency(const char* name, const LatencySnapshot& l) {
+    printf("  %-22s n=%-8llu p50=%8.1f ms  p99=%8.1f ms  max=%8.1f ms\n", name,
+           static_cast<unsigned long long>(l.count), ms(l.p50_ns), ms(l.p99_ns), ms(l.max_ns));
+}
+
+void print_state(const StatsPayload& s) {
+    int64_t now = now_ns();
+    uint32_t state = static_cast<uint32_t>(s.state);
+    printf("str_project pid %d, %s, publicado hace %.0f ms (#%llu)\n", s.pid,
+           state < 3 ? STATE_NAMES[state] : "?", age_ms(s.updated_ns, now),
+           static_cast<unsigned long long>(s.publish_count));
+
+    printf("\nCarriles\n");
+    for (uint32_t i = 0; i < s.lane_count && i < STATS_MAX_LANES; i++) {
+        const LaneSnapshot& lane = s.lanes[i];
+        char distance[32];
+        if (lane.last_distance_mm >= 0) snprintf(distance, sizeof(distance), "%.1f cm", lane.last_distance_mm / 10.0);
+        else snprintf(distance, sizeof(distance), "inválida");
+        printf("  carril %u: %-8s barrera %-9s distancia %-10s (hace %.0f ms) último vehículo #%llu\n", i,
+               lane.occupied ? "ocupado" : "libre", lane.barrier < size(BARRIER_STATE_NAMES) ? BARRIER_STATE_NAMES[lane.barrier] : "?",
+               distance, age_ms(lane.last_measure_ns, now), static_cast<unsigned long long>(lane.last_vehicle_id));
+    }
+
+    printf("\nColas\n");
+    printf("  disparo=%u  fotos=%u  auditoría=%u  decisiones=%u  registros en uso=%u\n",
+           s.trigger_depth, s.photo_depth, s.audit_depth, s.decision_depth, s.pool_in_use);
+
+    printf("\nContadores\n");
+    printf("  vehículos=%llu  fotos=%llu  frames perdidos=%llu  eventos perdidos=%llu  envíos fallidos=%llu\n",
+           static_cast<unsigned long long>(s.vehicles_detected), static_cast<unsigned long long>(s.photos_captured),
+           static_cast<unsigned long long>(s.frame_drops), static_cast<unsigned long long>(s.events_dropped),
+           static_cast<unsigned long long>(s.uploads_failed));
+
+    printf("\nLatencias\n");
+    print_latency("envío al backend", s.upload_latency);
+    print_latency("disparo -> decisión", s.decision_latency);
+
+    printf("\nHilos supervisados\n");
+    for (uint32_t i = 0; i < s.slot_count && i < STATS_MAX_SLOTS; i++) {
+        const SlotSnapshot& slot = s.slots[i];
+        printf("  hilo %d: %-9s inicio hace %8.0f ms  presupuesto %7.1f ms  iter=%-6llu p50=%.1f p99=%.1f max=%.1f ms"
+               "  timeouts=%llu recuperaciones=%llu reinicios=%llu\n",
+               slot.thread_id, slot.in_iteration ? "ocupado" : "esperando", age_ms(slot.last_start_ns, now),
+               ms(static_cast<uint64_t>(slot.budget_ns)), static_cast<unsigned long long>(slot.iterations),
+               ms(slot.exec_p50_ns), ms(slot.exec_p99_ns), ms(slot.exec_max_ns),
+               static_cast<unsigned long long>(slot.timeouts), static_cast<unsigned long long>(slot.recoveries),
+               static_cast<unsigned long long>(slot.restarts));
+    }
+}
+
+long option(int argc, char** argv, const char* prefix, long fallback) {
+    size_t n = strlen(prefix);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], prefix, n) == 0) return atol(argv[i] + n);
+    }
+    return fallback;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string command = "show";
+    const char* env = getenv("STR_SHM_NAME");
+    string name = env && *env ? env : STATS_DEFAULT_NAME;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--name=", 7) == 0) name = argv[i] + 7;
+        else if (argv[i][0] != '-') command = argv[i];
+    }
+    if (command != "show" && command != "watch" && command != "check") {
+        fprintf(stderr, "Uso: strctl [show|watch|check] [--name=/segmento] [--interval-ms=N] [--max-age-ms=N]\n");
+        return EXIT_FAILURE;
+    }
+
+    StatsReader reader;
+    string error;
+    if (!reader.open(name, error)) {
+        fprintf(stderr, "strctl: %s\n", error.c_str());
+        return 2;
+    }
+
+    StatsPayload s;
+    if (command == "check") {
+        long max_age = option(argc, argv, "--max-age-ms=", 2000);
+        if (!reader.read(s)) {
+            fprintf(stderr, "strctl: no se obtuvo una copia consistente del estado\n");
+            return 1;
+        }
+        double age = age_ms(s.updated_ns, now_ns());
+        // EPERM: el proceso existe pero corre como otro usuario (root, por pigpio);
+        // que esté publicando lo decide la antigüedad de updated_ns
+        bool pid_exists = kill(s.pid, 0) == 0 || errno == EPERM;
+        bool alive = s.state != ProcessState::Stopping && pid_exists && age >= 0 && age <= max_age;
+        printf("%s: pid %d, publicado hace %.0f ms\n", alive ? "OK" : "FALLA", s.pid, age);
+        return alive ? EXIT_SUCCESS : 1;
+    }
+
+    if (command == "show") {
+        if (!reader.read(s)) {
+            fprintf(stderr, "strctl: no se obtuvo una copia consistente del estado\n");
+            return 1;
+        }
+        print_state(s);
+        return EXIT_SUCCESS;
+    }
+
+    long interval = option(argc, argv, "--interval-ms=", 500);
+    signal(SIGINT, [](int) { interrupted = 1; });
+    while (!interrupted) {
+        if (reader.read(s)) {
+            printf("\033[H\033[2J");
+            print_state(s);
+            fflush(stdout);
+        }
+        this_thread::sleep_for(milliseconds(max(interval, 50L)));
+    }
+    return EXIT_SUCCESS;
+}